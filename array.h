@@ -0,0 +1,95 @@
+#ifndef ARRAY_H
+#define ARRAY_H
+
+#include "memtrack.h"
+#include <stdint.h>
+#include <string.h>
+
+// Typed dynamic arrays.
+//
+//   DEFINE_ARRAY(Name, T, N, TAG)
+//
+// declares a struct Name holding elements of type T, plus inline functions
+// Name_init, Name_data, Name_capacity, Name_reserve, Name_push, Name_append,
+// Name_shrink, Name_free and Name_heapBytes. Up to N elements are kept inside
+// the struct itself (small-buffer optimization), so tiny rings need no heap
+// block; past that the elements live in one heap block accounted under TAG.
+// Name_data returns a plain T * for pointer walks. A zeroed struct is a
+// valid empty array.
+
+#define DEFINE_ARRAY(Name, T, N, TAG)                                           \
+  typedef struct {                                                             \
+    uint32_t size;                                                             \
+    uint32_t heapCapacity; /* 0 while the elements are stored inline */       \
+    union {                                                                    \
+      T *heap;                                                                 \
+      T items[N];                                                              \
+    } store;                                                                   \
+  } Name;                                                                      \
+                                                                               \
+  static inline void Name##_init(Name *a) {                                    \
+    a->size = 0;                                                               \
+    a->heapCapacity = 0;                                                       \
+  }                                                                            \
+                                                                               \
+  static inline T *Name##_data(const Name *a) {                                \
+    return a->heapCapacity ? a->store.heap : (T *)a->store.items;              \
+  }                                                                            \
+                                                                               \
+  static inline uint32_t Name##_capacity(const Name *a) {                      \
+    return a->heapCapacity ? a->heapCapacity : (N);                            \
+  }                                                                            \
+                                                                               \
+  static inline void Name##_reserve(Name *a, uint32_t n) {                     \
+    if (n <= Name##_capacity(a)) return;                                       \
+    if (a->heapCapacity) {                                                     \
+      a->store.heap = (T *)memRealloc((TAG), a->store.heap, n * sizeof(T));    \
+    } else {                                                                   \
+      T *heap = (T *)memAlloc((TAG), n * sizeof(T));                           \
+      memcpy(heap, a->store.items, a->size * sizeof(T));                       \
+      a->store.heap = heap;                                                    \
+    }                                                                          \
+    a->heapCapacity = n;                                                       \
+  }                                                                            \
+                                                                               \
+  static inline void Name##_push(Name *a, T item) {                            \
+    if (a->size == Name##_capacity(a)) Name##_reserve(a, a->size * 2);         \
+    Name##_data(a)[a->size++] = item;                                          \
+  }                                                                            \
+                                                                               \
+  static inline void Name##_append(Name *a, const T *items, uint32_t count) {  \
+    if (a->size + count > Name##_capacity(a)) {                                \
+      uint32_t grown = a->size * 2;                                            \
+      Name##_reserve(a, a->size + count > grown ? a->size + count : grown);    \
+    }                                                                          \
+    memcpy(Name##_data(a) + a->size, items, count * sizeof(T));                \
+    a->size += count;                                                          \
+  }                                                                            \
+                                                                               \
+  /* Drop unused capacity, moving back inline when the elements fit */         \
+  static inline void Name##_shrink(Name *a) {                                  \
+    if (!a->heapCapacity || a->size == a->heapCapacity) return;                \
+    if (a->size <= (N)) {                                                      \
+      T *heap = a->store.heap;                                                 \
+      memcpy(a->store.items, heap, a->size * sizeof(T));                       \
+      memFree(heap);                                                           \
+      a->heapCapacity = 0;                                                     \
+    } else {                                                                   \
+      a->store.heap = (T *)memRealloc((TAG), a->store.heap, a->size * sizeof(T)); \
+      a->heapCapacity = a->size;                                               \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static inline void Name##_free(Name *a) {                                    \
+    if (a->heapCapacity) memFree(a->store.heap);                               \
+    Name##_init(a);                                                            \
+  }                                                                            \
+                                                                               \
+  /* Bytes held outside the struct, adding the unused part to *slack */       \
+  static inline uint64_t Name##_heapBytes(const Name *a, uint64_t *slack) {    \
+    if (!a->heapCapacity) return 0;                                            \
+    if (slack) *slack += (uint64_t)(a->heapCapacity - a->size) * sizeof(T);    \
+    return (uint64_t)a->heapCapacity * sizeof(T);                              \
+  }
+
+#endif // ARRAY_H
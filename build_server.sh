@@ -0,0 +1,18 @@
+#!/bin/bash
+
+# Build the headless tools (no raylib needed): the game server, its load
+# generator and the batch distance CLI
+# Usage: ./build_server.sh, then ./server and, in another shell, ./loadgen;
+# or ./distbatch < pairs.csv (./distbatch --solve benchmarks the solver,
+# ./distbatch --validate checks every engine against a reference,
+# ./distbatch --near answers nearest-country queries)
+
+set -e
+
+CFLAGS="-std=c11 -O2 -D_DEFAULT_SOURCE -DGLOBLE_HEADLESS"
+
+cc $CFLAGS server.c game.c geomath.c geodata.c memtrack.c -lm -lpthread -o server
+cc $CFLAGS loadgen.c memtrack.c -lpthread -o loadgen
+cc $CFLAGS distbatch.c solver.c distfield.c distref.c cellindex.c game.c geomath.c geodata.c memtrack.c -lm -lpthread -o distbatch
+
+echo "✓ Built ./server, ./loadgen and ./distbatch"
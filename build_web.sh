@@ -5,6 +5,23 @@
 
 set -e  # Exit on error
 
+# Usage: ./build_web.sh [--threads] [--embed]
+#   --threads  Build the pthreads flavor: border distances run on a Web Worker
+#              pool. Needs SharedArrayBuffer, i.e. a server sending COOP/COEP
+#              headers (run_web.sh does). Without it the single-threaded build
+#              computes them on the main thread.
+#   --embed    Compile the dataset into the wasm (see geoembed.h) instead of
+#              streaming the packed chunks; only the textures are downloaded
+THREADS=0
+EMBED=0
+for arg in "$@"; do
+  case "$arg" in
+    --threads) THREADS=1 ;;
+    --embed) EMBED=1 ;;
+    *) echo "Usage: $0 [--threads] [--embed]"; exit 1 ;;
+  esac
+done
+
 echo "🌍 Building Globle for Web..."
 echo ""
 
@@ -12,6 +29,7 @@ echo ""
 RAYLIB_PATH="./raylib"
 OUTPUT_DIR="./web_build"
 OUTPUT_FILE="index.html"
+DATA_DIR="$OUTPUT_DIR/data"
 
 # Check if emcc is available
 if ! command -v emcc &> /dev/null; then
@@ -40,26 +58,69 @@ if [ ! -f "$RAYLIB_PATH/src/libraylib.web.a" ]; then
   echo ""
 fi
 
+# Threaded flavor: every object linked into a shared-memory wasm must be
+# compiled with -pthread, so raylib gets a separate build for it
+RAYLIB_LIB="$RAYLIB_PATH/src/libraylib.web.a"
+THREAD_FLAGS=""
+if [ "$THREADS" = "1" ]; then
+  RAYLIB_LIB="$RAYLIB_PATH/src/libraylib.pthread.web.a"
+  if [ ! -f "$RAYLIB_LIB" ]; then
+    echo "📦 Compiling Raylib for web with pthreads..."
+    cd "$RAYLIB_PATH/src"
+    make PLATFORM=PLATFORM_WEB -B CUSTOM_CFLAGS=-pthread RAYLIB_LIB_NAME=raylib.pthread
+    cd ../..
+    echo "✓ Raylib compiled for web with pthreads"
+    echo ""
+  fi
+  THREAD_FLAGS="-pthread -s PTHREAD_POOL_SIZE=2"
+  echo "🧵 Building pthreads flavor"
+  echo ""
+fi
+
+# Pack the dataset into streamable binary chunks, or into a C source file
+# for --embed (quantized, as the streamed build is); built with the host compiler
+echo "📦 Packing country dataset..."
+HOST_TOOLS_DIR=$(mktemp -d)
+cc -std=c11 -O2 packdata.c geodata.c geopack.c geoembed.c memtrack.c -lm -lpthread -o "$HOST_TOOLS_DIR/packdata"
+mkdir -p "$DATA_DIR"
+EMBED_FLAGS=""
+if [ "$EMBED" = "1" ]; then
+  "$HOST_TOOLS_DIR/packdata" --quantize --embed "$HOST_TOOLS_DIR/geoembed_data.c" coordinates/ccc.csv
+  EMBED_FLAGS="-DGEODATA_EMBEDDED -I. $HOST_TOOLS_DIR/geoembed_data.c"
+else
+  "$HOST_TOOLS_DIR/packdata" coordinates/ccc.csv "$DATA_DIR"
+fi
+
+# Globe textures: a small copy is streamed first, then the full resolution one
+cp earth2.jpg "$DATA_DIR/earth2.jpg"
+if command -v magick &> /dev/null; then
+  magick earth2.jpg -resize 25% "$DATA_DIR/earth_small.jpg"
+elif command -v convert &> /dev/null; then
+  convert earth2.jpg -resize 25% "$DATA_DIR/earth_small.jpg"
+else
+  echo "⚠️  ImageMagick not found, skipping low resolution texture"
+fi
+echo "✓ Dataset packed into $DATA_DIR"
+echo ""
+
 # Compile the game
 echo "🔨 Compiling Globle game..."
 emcc -o "$OUTPUT_DIR/$OUTPUT_FILE" \
-  main.c geodata.c game.c \
+  main.c geodata.c game.c geomath.c geopack.c datastream.c distworker.c solver.c uitext.c globelod.c viewcull.c picking.c replay.c distfield.c heatmap.c countrymap.c scratch.c memtrack.c \
   -Os -Wall \
   -I"$RAYLIB_PATH/src" \
   -L"$RAYLIB_PATH/src" \
-  "$RAYLIB_PATH/src/libraylib.web.a" \
+  "$RAYLIB_LIB" \
+  $THREAD_FLAGS \
+  $EMBED_FLAGS \
   -s USE_GLFW=3 \
-  -s ASYNCIFY \
-  -s ASYNCIFY_STACK_SIZE=81920 \
   -s INITIAL_MEMORY=256MB \
-  -s TOTAL_STACK=64MB \
-  -s FORCE_FILESYSTEM=1 \
+  -s STACK_SIZE=1MB \
   -s ALLOW_MEMORY_GROWTH=1 \
-  --preload-file coordinates \
-  --preload-file earth2.jpg \
   --shell-file shell.html \
   -DPLATFORM_WEB \
   -sGL_ENABLE_GET_PROC_ADDRESS
+rm -rf "$HOST_TOOLS_DIR"
 
 echo ""
 echo "✅ Build complete!"
@@ -0,0 +1,507 @@
+#include "cellindex.h"
+#include "game.h"
+#include "geomath.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define CELL_PI 3.14159265358979323846
+#define CELL_DEG_TO_RAD (CELL_PI / 180.0)
+#define CELL_QUERY_CELLS 32          // A country query starts from at most this many cells
+#define CELL_FIRST_REACH_KM 500.0    // nearestCountries' first search radius, doubled as needed
+
+// Any point of a segment is within half a sample step, in lat and in lon, of
+// a sample that was registered; one degree of longitude is never longer
+// than one of latitude, so this angle covers it (plus float slack)
+#define CELL_SAMPLE_MARGIN (CELL_SAMPLE_DEGREES * 0.5 * 1.4142135623730951 * CELL_DEG_TO_RAD + 1e-6)
+
+typedef struct {
+  double x, y, z;
+} CellVec;
+
+// Bounding cap of a cell
+typedef struct {
+  CellVec center;  // Unit vector
+  double radius;   // Angle to the farthest corner
+} CellCap;
+
+// A cell waiting in nearestCountryTo's queue
+typedef struct {
+  double boundKm;  // No border in the cell is closer than this
+  uint64_t cell;
+  uint64_t first;  // Entries registered below the cell
+  uint64_t end;
+  int level;
+} QueuedCell;
+
+DEFINE_ARRAY(CellEntryArray, CellEntry, 1, MEM_TAG_PICKING)
+DEFINE_ARRAY(CellQueue, QueuedCell, 16, MEM_TAG_PICKING)
+
+// Per face: the axis through its center, then the axes u and v run along
+static const CellVec faceAxes[6][3] = {
+  {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+  {{0, 1, 0}, {-1, 0, 0}, {0, 0, 1}},
+  {{0, 0, 1}, {0, 1, 0}, {-1, 0, 0}},
+  {{-1, 0, 0}, {0, -1, 0}, {0, 0, 1}},
+  {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},
+  {{0, 0, -1}, {0, 1, 0}, {1, 0, 0}},
+};
+
+static inline CellVec unitVector(double lat, double lon) {
+  double latRad = lat * CELL_DEG_TO_RAD;
+  double lonRad = lon * CELL_DEG_TO_RAD;
+  return (CellVec){cos(latRad) * cos(lonRad), cos(latRad) * sin(lonRad), sin(latRad)};
+}
+
+static inline double dot(CellVec a, CellVec b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Angle between unit vectors; atan2 keeps it exact near 0 and pi
+static inline double angleBetween(CellVec a, CellVec b) {
+  CellVec c = {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+  return atan2(sqrt(dot(c, c)), dot(a, b));
+}
+
+// Morton code halves: spread 16 bits to the even positions and back
+static inline uint32_t spreadBits(uint32_t x) {
+  x &= 0xFFFFu;
+  x = (x | x << 8) & 0x00FF00FFu;
+  x = (x | x << 4) & 0x0F0F0F0Fu;
+  x = (x | x << 2) & 0x33333333u;
+  return (x | x << 1) & 0x55555555u;
+}
+
+static inline uint32_t compactBits(uint32_t x) {
+  x &= 0x55555555u;
+  x = (x | x >> 1) & 0x33333333u;
+  x = (x | x >> 2) & 0x0F0F0F0Fu;
+  x = (x | x >> 4) & 0x00FF00FFu;
+  return (x | x >> 8) & 0xFFFFu;
+}
+
+// Row or column of face coordinate u; atan spreads the cells evenly in angle
+static uint32_t faceIndex(double u, uint32_t size) {
+  double s = atan(u) * (4.0 / CELL_PI);
+  int64_t k = (int64_t)floor((s + 1.0) * 0.5 * size);
+  if (k < 0) return 0;
+  if (k >= (int64_t)size) return size - 1;
+  return (uint32_t)k;
+}
+
+static uint64_t cellOf(CellVec p, int level) {
+  int face = 0;
+  double best = -2.0;
+  for (int f = 0; f < 6; f++) {
+    double d = dot(p, faceAxes[f][0]);
+    if (d > best) {
+      best = d;
+      face = f;
+    }
+  }
+  uint32_t size = 1u << level;
+  uint32_t i = faceIndex(dot(p, faceAxes[face][1]) / best, size);
+  uint32_t j = faceIndex(dot(p, faceAxes[face][2]) / best, size);
+  return (uint64_t)face << (2 * level) | spreadBits(i) | spreadBits(j) << 1;
+}
+
+uint64_t cellIdAt(float lat, float lon, int level) {
+  return cellOf(unitVector(lat, lon), level);
+}
+
+// Point of a face at coordinates s, t in [-1, 1]
+static CellVec facePoint(int face, double s, double t) {
+  double u = tan(s * CELL_PI / 4.0);
+  double v = tan(t * CELL_PI / 4.0);
+  const CellVec *axes = faceAxes[face];
+  CellVec p = {axes[0].x + u * axes[1].x + v * axes[2].x,
+               axes[0].y + u * axes[1].y + v * axes[2].y,
+               axes[0].z + u * axes[1].z + v * axes[2].z};
+  double length = sqrt(dot(p, p));
+  return (CellVec){p.x / length, p.y / length, p.z / length};
+}
+
+// Cell edges are great-circle arcs, so the cap through the corners holds it
+static CellCap cellCap(uint64_t cell, int level) {
+  int face = (int)(cell >> (2 * level));
+  uint32_t morton = (uint32_t)(cell & ((1ull << (2 * level)) - 1));
+  double step = 2.0 / (1u << level);
+  double s0 = -1.0 + compactBits(morton) * step;
+  double t0 = -1.0 + compactBits(morton >> 1) * step;
+
+  CellCap cap = {facePoint(face, s0 + step * 0.5, t0 + step * 0.5), 0.0};
+  for (int corner = 0; corner < 4; corner++) {
+    CellVec p = facePoint(face, s0 + (corner & 1) * step, t0 + (corner >> 1) * step);
+    double angle = angleBetween(cap.center, p);
+    if (angle > cap.radius) cap.radius = angle;
+  }
+  return cap;
+}
+
+// First entry in [lo, hi) whose cell is at least leaf
+static uint64_t lowerBound(const CellIndex *index, uint64_t lo, uint64_t hi, uint64_t leaf) {
+  while (lo < hi) {
+    uint64_t mid = lo + (hi - lo) / 2;
+    if (index->entries[mid].cell < leaf) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// Narrow a parent's entry range to one cell's; false if nothing is registered there
+static bool cellEntries(const CellIndex *index, uint64_t cell, int level,
+                        uint64_t *first, uint64_t *end) {
+  int shift = 2 * (CELL_INDEX_LEVEL - level);
+  uint64_t lo = lowerBound(index, *first, *end, cell << shift);
+  uint64_t hi = lowerBound(index, lo, *end, (cell + 1) << shift);
+  *first = lo;
+  *end = hi;
+  return lo < hi;
+}
+
+// Building
+
+// Register the segment in each leaf cell its samples land in
+static void registerSegment(CellEntryArray *list, GeoPoint a, GeoPoint b, CellEntry e) {
+  double span = fmax(fabs((double)b.lat - a.lat), fabs((double)b.lon - a.lon));
+  uint32_t steps = (uint32_t)ceil(span / CELL_SAMPLE_DEGREES);
+  if (steps < 1) steps = 1;
+  uint64_t last = UINT64_MAX;
+  for (uint32_t k = 0; k <= steps; k++) {
+    double t = (double)k / steps;
+    e.cell = cellOf(unitVector(a.lat + t * ((double)b.lat - a.lat),
+                               a.lon + t * ((double)b.lon - a.lon)), CELL_INDEX_LEVEL);
+    if (e.cell == last) continue;  // Revisits are merged after sorting
+    last = e.cell;
+    CellEntryArray_push(list, e);
+  }
+}
+
+static int compareEntries(const void *a, const void *b) {
+  const CellEntry *ea = a;
+  const CellEntry *eb = b;
+  if (ea->cell != eb->cell) return (ea->cell > eb->cell) - (ea->cell < eb->cell);
+  if (ea->country != eb->country) return (ea->country > eb->country) - (ea->country < eb->country);
+  if (ea->ring != eb->ring) return (ea->ring > eb->ring) - (ea->ring < eb->ring);
+  return (ea->segment > eb->segment) - (ea->segment < eb->segment);
+}
+
+CellIndex *buildCellIndex(CountryDatabase *db) {
+  if (!db) return NULL;
+
+  CellIndex *index = memCalloc(MEM_TAG_PICKING, 1, sizeof(CellIndex));
+  index->db = db;
+
+  CellEntryArray list;
+  CellEntryArray_init(&list);
+  for (uint32_t i = 0; i < db->count; i++) {
+    Polygon **polys = countryPolygons(&db->countries[i]);
+    for (uint32_t j = 0; j < countryRingCount(&db->countries[i]); j++) {
+      uint64_t n = polygonPointCount(polys[j]);
+      if (n < 2) continue;
+      GeoPointArray scratch;
+      GeoPointArray_init(&scratch);
+      const GeoPoint *points = polygonPoints(polys[j], &scratch);
+      for (uint64_t s = 0; s + 1 < n; s++) {
+        registerSegment(&list, points[s], points[s + 1], (CellEntry){0, i, j, (uint32_t)s});
+      }
+      if (n > 2) {
+        registerSegment(&list, points[n - 1], points[0], (CellEntry){0, i, j, (uint32_t)(n - 1)});
+      }
+      GeoPointArray_free(&scratch);
+    }
+  }
+
+  // Sort, drop the repeats, and keep an exact-size copy
+  CellEntry *sorted = CellEntryArray_data(&list);
+  qsort(sorted, list.size, sizeof(CellEntry), compareEntries);
+  uint64_t count = 0;
+  for (uint32_t k = 0; k < list.size; k++) {
+    if (count == 0 || compareEntries(&sorted[count - 1], &sorted[k]) != 0) {
+      sorted[count++] = sorted[k];
+    }
+  }
+  index->entryCount = count;
+  index->entries = memAlloc(MEM_TAG_PICKING, (count ? count : 1) * sizeof(CellEntry));
+  memcpy(index->entries, sorted, count * sizeof(CellEntry));
+  CellEntryArray_free(&list);
+
+  // Each country's distinct cells: count, then fill (CSR layout, ascending
+  // because the entries are)
+  index->countryStart = memCalloc(MEM_TAG_PICKING, db->count + 1, sizeof(uint32_t));
+  for (uint64_t k = 0; k < count; k++) {
+    const CellEntry *e = &index->entries[k];
+    if (k == 0 || e[-1].cell != e->cell || e[-1].country != e->country) {
+      index->countryStart[e->country + 1]++;
+    }
+  }
+  for (uint32_t i = 0; i < db->count; i++) {
+    index->countryStart[i + 1] += index->countryStart[i];
+  }
+  uint32_t cellTotal = index->countryStart[db->count];
+  index->countryCells = memAlloc(MEM_TAG_PICKING, (cellTotal ? cellTotal : 1) * sizeof(uint64_t));
+  uint32_t *cursor = memAlloc(MEM_TAG_PICKING, (db->count ? db->count : 1) * sizeof(uint32_t));
+  memcpy(cursor, index->countryStart, db->count * sizeof(uint32_t));
+  for (uint64_t k = 0; k < count; k++) {
+    const CellEntry *e = &index->entries[k];
+    if (k == 0 || e[-1].cell != e->cell || e[-1].country != e->country) {
+      index->countryCells[cursor[e->country]++] = e->cell;
+    }
+  }
+  memFree(cursor);
+  return index;
+}
+
+void freeCellIndex(CellIndex *index) {
+  if (!index) return;
+  memFree(index->entries);
+  memFree(index->countryStart);
+  memFree(index->countryCells);
+  memFree(index);
+}
+
+// Country queries
+
+// Where a country query starts: the country's border cells, merged into
+// their parents until few enough remain
+typedef struct {
+  CellCap *caps;
+  uint32_t count;
+} QueryCells;
+
+static bool startQuery(const CellIndex *index, uint32_t country, QueryCells *query) {
+  uint32_t first = index->countryStart[country];
+  uint32_t count = index->countryStart[country + 1] - first;
+  query->caps = NULL;
+  query->count = 0;
+  if (count == 0) return false;
+
+  uint64_t *cells = memAlloc(MEM_TAG_PICKING, count * sizeof(uint64_t));
+  memcpy(cells, index->countryCells + first, count * sizeof(uint64_t));
+  int level = CELL_INDEX_LEVEL;
+  while (count > CELL_QUERY_CELLS && level > 0) {
+    // Still ascending after the shift, so repeats are adjacent
+    uint32_t merged = 0;
+    for (uint32_t k = 0; k < count; k++) {
+      uint64_t parent = cells[k] >> 2;
+      if (merged == 0 || cells[merged - 1] != parent) cells[merged++] = parent;
+    }
+    count = merged;
+    level--;
+  }
+
+  query->caps = memAlloc(MEM_TAG_PICKING, count * sizeof(CellCap));
+  for (uint32_t k = 0; k < count; k++) query->caps[k] = cellCap(cells[k], level);
+  query->count = count;
+  memFree(cells);
+  return true;
+}
+
+// Add every country registered under the cell that could be within reach
+// (an angle) of the query cell; marked keeps each country to one entry
+static void collectNear(const CellIndex *index, uint64_t cell, int level, uint64_t first,
+                        uint64_t end, const CellCap *from, double reach, uint8_t *marked,
+                        CountryDistanceArray *found) {
+  if (!cellEntries(index, cell, level, &first, &end)) return;
+  CellCap cap = cellCap(cell, level);
+  if (angleBetween(from->center, cap.center) - from->radius - cap.radius > reach) return;
+
+  if (level == CELL_INDEX_LEVEL) {
+    for (uint64_t k = first; k < end; k++) {
+      uint32_t country = index->entries[k].country;
+      if (marked[country]) continue;
+      marked[country] = 1;
+      CountryDistanceArray_push(found, (CountryDistance){country, -1.0f});
+    }
+    return;
+  }
+  for (uint64_t child = 0; child < 4; child++) {
+    collectNear(index, cell << 2 | child, level + 1, first, end, from, reach, marked, found);
+  }
+}
+
+// Candidates for being within km: both borders are within a sample margin
+// of their cells, hence the two margins on top of the cell caps
+static void collectCandidates(const CellIndex *index, const QueryCells *query, double km,
+                              uint8_t *marked, CountryDistanceArray *found) {
+  double reach = km / GEO_EARTH_RADIUS_KM + 2.0 * CELL_SAMPLE_MARGIN;
+  for (uint32_t q = 0; q < query->count; q++) {
+    for (uint64_t face = 0; face < 6; face++) {
+      collectNear(index, face, 0, 0, index->entryCount, &query->caps[q], reach, marked, found);
+    }
+  }
+}
+
+// Border distances for the candidates from first on
+static void measureCandidates(const CellIndex *index, uint32_t country,
+                              CountryDistanceArray *found, uint32_t first) {
+  CountryDistance *items = CountryDistanceArray_data(found);
+  for (uint32_t k = first; k < found->size; k++) {
+    items[k].km = calculateBorderToBorderDistance(&index->db->countries[country],
+                                                  &index->db->countries[items[k].country]);
+  }
+}
+
+static int compareDistances(const void *a, const void *b) {
+  const CountryDistance *da = a;
+  const CountryDistance *db = b;
+  if (da->km != db->km) return (da->km > db->km) - (da->km < db->km);
+  return (da->country > db->country) - (da->country < db->country);
+}
+
+void countriesWithinKm(const CellIndex *index, uint32_t country, float km,
+                       CountryDistanceArray *out) {
+  out->size = 0;
+  QueryCells query;
+  if (country >= index->db->count || km < 0.0f || !startQuery(index, country, &query)) return;
+
+  uint8_t *marked = memCalloc(MEM_TAG_PICKING, index->db->count, 1);
+  marked[country] = 1;
+  CountryDistanceArray found;
+  CountryDistanceArray_init(&found);
+  collectCandidates(index, &query, km, marked, &found);
+  measureCandidates(index, country, &found, 0);
+
+  const CountryDistance *items = CountryDistanceArray_data(&found);
+  for (uint32_t k = 0; k < found.size; k++) {
+    if (items[k].km <= km) CountryDistanceArray_push(out, items[k]);
+  }
+  qsort(CountryDistanceArray_data(out), out->size, sizeof(CountryDistance), compareDistances);
+
+  CountryDistanceArray_free(&found);
+  memFree(marked);
+  memFree(query.caps);
+}
+
+void nearestCountries(const CellIndex *index, uint32_t country, uint32_t k,
+                      CountryDistanceArray *out) {
+  out->size = 0;
+  QueryCells query;
+  if (country >= index->db->count || k == 0 || !startQuery(index, country, &query)) return;
+
+  // Widen the search until k countries are measured within it; anything
+  // not reached yet is farther than the radius, so those k are final
+  uint8_t *marked = memCalloc(MEM_TAG_PICKING, index->db->count, 1);
+  marked[country] = 1;
+  CountryDistanceArray found;
+  CountryDistanceArray_init(&found);
+  uint32_t measured = 0;
+  for (double reachKm = CELL_FIRST_REACH_KM;; reachKm *= 2.0) {
+    collectCandidates(index, &query, reachKm, marked, &found);
+    measureCandidates(index, country, &found, measured);
+    measured = found.size;
+
+    const CountryDistance *items = CountryDistanceArray_data(&found);
+    uint32_t inReach = 0;
+    for (uint32_t i = 0; i < found.size; i++) inReach += items[i].km <= reachKm;
+    if (inReach >= k || reachKm >= CELL_PI * GEO_EARTH_RADIUS_KM) break;
+  }
+
+  CountryDistance *items = CountryDistanceArray_data(&found);
+  qsort(items, found.size, sizeof(CountryDistance), compareDistances);
+  CountryDistanceArray_append(out, items, found.size < k ? found.size : k);
+
+  CountryDistanceArray_free(&found);
+  memFree(marked);
+  memFree(query.caps);
+}
+
+// Point queries
+
+static void queuePush(CellQueue *queue, QueuedCell item) {
+  CellQueue_push(queue, item);
+  QueuedCell *heap = CellQueue_data(queue);
+  uint32_t i = queue->size - 1;
+  while (i > 0 && heap[(i - 1) / 2].boundKm > item.boundKm) {
+    heap[i] = heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  heap[i] = item;
+}
+
+static QueuedCell queuePop(CellQueue *queue) {
+  QueuedCell *heap = CellQueue_data(queue);
+  QueuedCell top = heap[0];
+  QueuedCell last = heap[--queue->size];
+  uint32_t i = 0;
+  for (;;) {
+    uint32_t child = 2 * i + 1;
+    if (child >= queue->size) break;
+    if (child + 1 < queue->size && heap[child + 1].boundKm < heap[child].boundKm) child++;
+    if (heap[child].boundKm >= last.boundKm) break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  if (queue->size) heap[i] = last;
+  return top;
+}
+
+// Queue the cell unless nothing is registered there or it can't beat bestKm
+static void queueCell(const CellIndex *index, CellQueue *queue, CellVec p, uint64_t cell,
+                      int level, uint64_t first, uint64_t end, float bestKm) {
+  if (!cellEntries(index, cell, level, &first, &end)) return;
+  CellCap cap = cellCap(cell, level);
+  double boundKm = (angleBetween(p, cap.center) - cap.radius - CELL_SAMPLE_MARGIN) *
+                   GEO_EARTH_RADIUS_KM;
+  if (boundKm < bestKm) queuePush(queue, (QueuedCell){boundKm, cell, first, end, level});
+}
+
+// The segment walked linearly in lat/lon like the game's engine, sampled at
+// the index's spacing
+static float pointSegmentKm(GeoPoint p, GeoPoint a, GeoPoint b) {
+  float span = fmaxf(fabsf(b.lat - a.lat), fabsf(b.lon - a.lon));
+  uint32_t steps = (uint32_t)ceilf(span / (float)CELL_SAMPLE_DEGREES);
+  if (steps < 1) steps = 1;
+  float best = INFINITY;
+  for (uint32_t k = 0; k <= steps; k++) {
+    float t = (float)k / steps;
+    GeoPoint sample = {a.lat + t * (b.lat - a.lat), a.lon + t * (b.lon - a.lon)};
+    float km = greatCircleKm(p, sample, PRECISION_FLOAT);
+    if (km < best) best = km;
+  }
+  return best;
+}
+
+CountryData *nearestCountryTo(const CellIndex *index, float lat, float lon, float *km) {
+  GeoPoint point = {lat, lon};
+  CellVec p = unitVector(lat, lon);
+  float bestKm = INFINITY;
+  CountryData *best = NULL;
+
+  // Best first: nearest bound on top, done once it can't beat the best border
+  CellQueue queue;
+  CellQueue_init(&queue);
+  for (uint64_t face = 0; face < 6; face++) {
+    queueCell(index, &queue, p, face, 0, 0, index->entryCount, bestKm);
+  }
+  while (queue.size) {
+    QueuedCell top = queuePop(&queue);
+    if (top.boundKm >= bestKm) break;
+    if (top.level < CELL_INDEX_LEVEL) {
+      for (uint64_t child = 0; child < 4; child++) {
+        queueCell(index, &queue, p, top.cell << 2 | child, top.level + 1, top.first, top.end,
+                  bestKm);
+      }
+      continue;
+    }
+    for (uint64_t k = top.first; k < top.end; k++) {
+      const CellEntry *e = &index->entries[k];
+      CountryData *country = &index->db->countries[e->country];
+      const Polygon *poly = countryPolygons(country)[e->ring];
+      uint64_t n = polygonPointCount(poly);
+      float d = pointSegmentKm(point, polygonPoint(poly, e->segment),
+                               polygonPoint(poly, (e->segment + 1) % n));
+      if (d < bestKm) {
+        bestKm = d;
+        best = country;
+      }
+    }
+  }
+  CellQueue_free(&queue);
+
+  if (km) *km = best ? bestKm : 0.0f;
+  return best;
+}
@@ -0,0 +1,71 @@
+#ifndef CELLINDEX_H
+#define CELLINDEX_H
+
+#include "array.h"
+#include "geodata.h"
+#include <stdint.h>
+
+// Answers "what is near this border" across the whole database. The sphere
+// is split S2-style: a unit vector picks one of six cube faces, each face is
+// split into a quadtree (face coordinates pass through atan so cells stay
+// close to equal area), and a cell's ID is its face followed by its Morton
+// code. Dropping the last two bits gives the parent, so every cell covers a
+// contiguous range of leaf IDs. Each border segment is sampled and
+// registered in every leaf cell it passes through.
+//
+// Queries walk the hierarchy from the six faces down, visiting only
+// populated cells that a bounding cap says could still hold something close
+// enough, and measure distances only for what they reach there: border
+// segments for a point, the game's border-to-border engine for a country.
+// Countries without border geometry are never returned.
+
+#define CELL_INDEX_LEVEL 7        // Leaf cells about 0.7 degrees (~78 km) across
+#define CELL_SAMPLE_DEGREES 0.1   // Sample spacing when registering a segment
+
+// A border segment registered in a leaf cell
+typedef struct {
+  uint64_t cell;     // Leaf cell ID
+  uint32_t country;  // Index into db->countries
+  uint32_t ring;     // Index into that country's polygons
+  uint32_t segment;  // Vertex index where the segment starts (the last closes the ring)
+} CellEntry;
+
+typedef struct {
+  CountryDatabase *db;
+  CellEntry *entries;  // Ascending by cell, then country, ring, segment
+  uint64_t entryCount;
+  uint32_t *countryStart;  // db->count + 1 offsets into countryCells
+  uint64_t *countryCells;  // Leaf cells each country's border passes through, ascending
+} CellIndex;
+
+typedef struct {
+  uint32_t country;  // Index into db->countries
+  float km;          // Border-to-border distance
+} CountryDistance;
+
+DEFINE_ARRAY(CountryDistanceArray, CountryDistance, 1, MEM_TAG_PICKING)
+
+// Build the index over every ring in db (geometry must be loaded)
+CellIndex *buildCellIndex(CountryDatabase *db);
+void freeCellIndex(CellIndex *index);
+
+// Cell containing the point at the given level (0 = cube face)
+uint64_t cellIdAt(float lat, float lon, int level);
+
+// Countries whose borders come within km of the country's, nearest first.
+// The country itself is left out. Replaces out's contents.
+void countriesWithinKm(const CellIndex *index, uint32_t country, float km,
+                       CountryDistanceArray *out);
+
+// The k countries with the nearest borders, nearest first (fewer if the
+// database runs out). Replaces out's contents.
+void nearestCountries(const CellIndex *index, uint32_t country, uint32_t k,
+                      CountryDistanceArray *out);
+
+// Country whose border passes nearest the point, or NULL for an empty
+// index; km (if given) gets the distance. A point inside a country finds the
+// border nearest to it, which may be a neighbour's; use pickCountryAt for
+// the containing country.
+CountryData *nearestCountryTo(const CellIndex *index, float lat, float lon, float *km);
+
+#endif // CELLINDEX_H
@@ -0,0 +1,292 @@
+#include "countrymap.h"
+#include "array.h"
+#include "memtrack.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ID_MAP_WIDTH 2048   // Texels from pole to pole (u, as earth2.jpg)
+#define ID_MAP_HEIGHT 4096  // Texels around the globe (v)
+#define ID_MAP_MAX 65535    // Ids are 16 bits; 0 is open water
+#define PALETTE_WIDTH 256
+
+// Ids are exact integers, so the fragment shader wants highp where it exists.
+// A texel is on a border when a neighbour holds another id; the border takes
+// the most opaque color among them, darkened like the old outline base.
+#define COUNTRY_SHADER_BODY                                                    \
+  "uniform sampler2D texture0;\n" /* Earth */                                  \
+  "uniform sampler2D texture1;\n" /* Country ids */                            \
+  "uniform sampler2D texture2;\n" /* Palette */                                \
+  "uniform vec4 colDiffuse;\n"                                                 \
+  "uniform vec2 idTexel;\n"                                                    \
+  "uniform vec2 paletteSize;\n"                                                \
+  "float countryAt(vec2 uv) {\n"                                               \
+  "  vec4 t = TEX(texture1, uv);\n"                                            \
+  "  return floor(t.r*255.0 + 0.5) + 256.0*floor(t.a*255.0 + 0.5);\n"          \
+  "}\n"                                                                        \
+  "vec4 colorOf(float id) {\n"                                                 \
+  "  vec2 cell = vec2(mod(id, paletteSize.x), floor(id/paletteSize.x));\n"     \
+  "  return TEX(texture2, (cell + 0.5)/paletteSize);\n"                        \
+  "}\n"                                                                        \
+  "vec4 stronger(vec4 a, vec4 b) { return b.a > a.a ? b : a; }\n"              \
+  "vec4 shade() {\n"                                                           \
+  "  vec4 earth = TEX(texture0, fragTexCoord)*colDiffuse*fragColor;\n"         \
+  "  float id = countryAt(fragTexCoord);\n"                                    \
+  "  vec4 fill = colorOf(id);\n"                                               \
+  "  vec3 rgb = mix(earth.rgb, fill.rgb, fill.a);\n"                           \
+  "  float n0 = countryAt(fragTexCoord + vec2(idTexel.x, 0.0));\n"             \
+  "  float n1 = countryAt(fragTexCoord - vec2(idTexel.x, 0.0));\n"             \
+  "  float n2 = countryAt(fragTexCoord + vec2(0.0, idTexel.y));\n"             \
+  "  float n3 = countryAt(fragTexCoord - vec2(0.0, idTexel.y));\n"             \
+  "  if (n0 != id || n1 != id || n2 != id || n3 != id) {\n"                    \
+  "    vec4 line = stronger(stronger(fill, colorOf(n0)), colorOf(n1));\n"      \
+  "    line = stronger(stronger(line, colorOf(n2)), colorOf(n3));\n"           \
+  "    if (line.a > 0.0) rgb = line.rgb*0.6;\n"                                \
+  "  }\n"                                                                      \
+  "  return vec4(rgb, earth.a);\n"                                             \
+  "}\n"
+
+#ifdef PLATFORM_WEB
+static const char *countryShaderCode =
+    "#version 100\n"
+    "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+    "precision highp float;\n"
+    "#else\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "#define TEX texture2D\n"
+    "varying vec2 fragTexCoord;\n"
+    "varying vec4 fragColor;\n"
+    COUNTRY_SHADER_BODY
+    "void main() { gl_FragColor = shade(); }\n";
+#else
+static const char *countryShaderCode =
+    "#version 330\n"
+    "#define TEX texture\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "out vec4 finalColor;\n"
+    COUNTRY_SHADER_BODY
+    "void main() { finalColor = shade(); }\n";
+#endif
+
+// Rasterization
+
+// Where a ring's edge crosses the center line of an id map row
+typedef struct {
+  uint32_t row;
+  float x;  // Texel coordinate along u (texel centers at whole numbers)
+} Crossing;
+
+DEFINE_ARRAY(CrossingArray, Crossing, 1, MEM_TAG_RENDER)
+
+typedef struct {
+  const Polygon *poly;
+  uint16_t id;
+  float area;  // Bounding box, square degrees
+} RingOrder;
+
+static int compareCrossings(const void *a, const void *b) {
+  const Crossing *x = a;
+  const Crossing *y = b;
+  if (x->row != y->row) return (x->row > y->row) - (x->row < y->row);
+  return (x->x > y->x) - (x->x < y->x);
+}
+
+// Larger rings first, so enclaves paint over the country around them
+// (the same rule pickCountryAt uses)
+static int compareRings(const void *a, const void *b) {
+  float x = ((const RingOrder *)a)->area;
+  float y = ((const RingOrder *)b)->area;
+  return (x < y) - (x > y);
+}
+
+static inline float texelU(float lat) {
+  return (90.0f - lat) / 180.0f * ID_MAP_WIDTH;
+}
+
+static inline float texelV(float lon) {
+  return (lon + 180.0f) / 360.0f * ID_MAP_HEIGHT;
+}
+
+// Even-odd scanline fill along v; a row counts a crossing when its center
+// line is in [start, end) of the edge, so shared vertices count once
+static void fillRing(uint16_t *ids, const RingOrder *ring, CrossingArray *crossings) {
+  GeoPointArray scratch;
+  GeoPointArray_init(&scratch);
+  const GeoPoint *points = polygonPoints(ring->poly, &scratch);
+  uint64_t count = polygonPointCount(ring->poly);
+
+  crossings->size = 0;
+  for (uint64_t i = 0; i < count; i++) {
+    GeoPoint a = points[i];
+    GeoPoint b = points[(i + 1) % count];
+    float va = texelV(a.lon) - 0.5f;
+    float vb = texelV(b.lon) - 0.5f;
+    if (va == vb) continue;
+    float lo = fminf(va, vb), hi = fmaxf(va, vb);
+    int first = (int)ceilf(lo);
+    int last = (int)ceilf(hi) - 1;
+    if (first < 0) first = 0;
+    if (last > ID_MAP_HEIGHT - 1) last = ID_MAP_HEIGHT - 1;
+    float ua = texelU(a.lat) - 0.5f;
+    float ub = texelU(b.lat) - 0.5f;
+    for (int row = first; row <= last; row++) {
+      float t = ((float)row - va) / (vb - va);
+      CrossingArray_push(crossings, (Crossing){(uint32_t)row, ua + t * (ub - ua)});
+    }
+  }
+
+  Crossing *c = CrossingArray_data(crossings);
+  qsort(c, crossings->size, sizeof(Crossing), compareCrossings);
+  uint32_t i = 0;
+  while (i + 1 < crossings->size) {
+    if (c[i].row != c[i + 1].row) {
+      i++;  // Unpaired crossing (degenerate ring); resync on the next row
+      continue;
+    }
+    int x0 = (int)ceilf(c[i].x);
+    int x1 = (int)floorf(c[i + 1].x);
+    if (x0 < 0) x0 = 0;
+    if (x1 > ID_MAP_WIDTH - 1) x1 = ID_MAP_WIDTH - 1;
+    uint16_t *row = ids + (size_t)c[i].row * ID_MAP_WIDTH;
+    for (int x = x0; x <= x1; x++) {
+      row[x] = ring->id;
+    }
+    i += 2;
+  }
+
+  // Rings thinner than a texel still show where their vertices are
+  for (uint64_t j = 0; j < count; j++) {
+    int x = (int)texelU(points[j].lat);
+    int y = (int)texelV(points[j].lon);
+    if (x < 0 || x >= ID_MAP_WIDTH || y < 0 || y >= ID_MAP_HEIGHT) continue;
+    uint16_t *texel = &ids[(size_t)y * ID_MAP_WIDTH + x];
+    if (*texel == 0) *texel = ring->id;
+  }
+  GeoPointArray_free(&scratch);
+}
+
+// Country index + 1 per texel, rows along v
+static uint16_t *rasterizeCountries(const CountryDatabase *db) {
+  uint64_t countries = db->count < ID_MAP_MAX ? db->count : ID_MAP_MAX - 1;
+  if (countries < db->count) {
+    printf("Warning: country map holds %llu of %llu countries\n",
+           (unsigned long long)countries, (unsigned long long)db->count);
+  }
+
+  uint64_t ringCount = 0;
+  for (uint64_t i = 0; i < countries; i++) {
+    ringCount += countryRingCount(&db->countries[i]);
+  }
+  RingOrder *rings = memAlloc(MEM_TAG_RENDER, (ringCount ? ringCount : 1) * sizeof(RingOrder));
+  uint64_t n = 0;
+  for (uint64_t i = 0; i < countries; i++) {
+    const CountryData *country = &db->countries[i];
+    Polygon **polys = countryPolygons(country);
+    for (uint32_t j = 0; j < countryRingCount(country); j++) {
+      const Polygon *poly = polys[j];
+      if (polygonPointCount(poly) < 3) continue;
+      float area = (poly->boxMax.lat - poly->boxMin.lat) * (poly->boxMax.lon - poly->boxMin.lon);
+      rings[n++] = (RingOrder){poly, (uint16_t)(i + 1), area};
+    }
+  }
+  qsort(rings, n, sizeof(RingOrder), compareRings);
+
+  uint16_t *ids = memCalloc(MEM_TAG_RENDER, (size_t)ID_MAP_WIDTH * ID_MAP_HEIGHT, sizeof(uint16_t));
+  CrossingArray crossings;
+  CrossingArray_init(&crossings);
+  for (uint64_t i = 0; i < n; i++) {
+    fillRing(ids, &rings[i], &crossings);
+  }
+  CrossingArray_free(&crossings);
+  memFree(rings);
+  return ids;
+}
+
+// Map
+
+static int64_t textureBytes(Texture2D texture, int bytesPerTexel) {
+  return (int64_t)texture.width * texture.height * bytesPerTexel;
+}
+
+bool loadCountryMap(CountryMap *map, const CountryDatabase *db) {
+  memset(map, 0, sizeof(*map));
+  double start = GetTime();
+  uint16_t *ids = rasterizeCountries(db);
+  double rasterTime = GetTime() - start;
+
+  // Gray+alpha is the one two-channel format both GL 3.3 and WebGL 1 take;
+  // little-endian ids land as gray = low byte, alpha = high byte
+  Image idImage = {ids, ID_MAP_WIDTH, ID_MAP_HEIGHT, 1, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA};
+  map->ids = LoadTextureFromImage(idImage);
+  memFree(ids);
+  SetTextureFilter(map->ids, TEXTURE_FILTER_POINT);  // Ids must not blend
+  memTrackExternal(MEM_TAG_GPU, textureBytes(map->ids, 2));
+
+  // Palette rows are a power of two so WebGL 1 can sample it like any texture
+  map->countryCount = db->count < ID_MAP_MAX ? (uint32_t)db->count : ID_MAP_MAX - 1;
+  int rows = 1;
+  while ((uint32_t)rows * PALETTE_WIDTH < map->countryCount + 1) rows *= 2;
+  map->colors = memCalloc(MEM_TAG_RENDER, (size_t)rows * PALETTE_WIDTH, sizeof(Color));
+  Image paletteImage = {map->colors, PALETTE_WIDTH, rows, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+  map->palette = LoadTextureFromImage(paletteImage);
+  SetTextureFilter(map->palette, TEXTURE_FILTER_POINT);
+  memTrackExternal(MEM_TAG_GPU, textureBytes(map->palette, 4));
+
+  map->shader = LoadShaderFromMemory(NULL, countryShaderCode);
+  if (map->shader.id != 0) {
+    float texel[2] = {1.0f / ID_MAP_WIDTH, 1.0f / ID_MAP_HEIGHT};
+    float paletteSize[2] = {(float)PALETTE_WIDTH, (float)rows};
+    SetShaderValue(map->shader, GetShaderLocation(map->shader, "idTexel"), texel,
+                   SHADER_UNIFORM_VEC2);
+    SetShaderValue(map->shader, GetShaderLocation(map->shader, "paletteSize"), paletteSize,
+                   SHADER_UNIFORM_VEC2);
+  }
+
+  map->loaded = map->ids.id != 0 && map->palette.id != 0 && map->shader.id != 0;
+  printf("Country map: %u countries, %dx%d ids, rasterized in %.1f ms\n", map->countryCount,
+         ID_MAP_WIDTH, ID_MAP_HEIGHT, rasterTime * 1000.0);
+  return map->loaded;
+}
+
+void unloadCountryMap(CountryMap *map) {
+  if (map->ids.id) {
+    memTrackExternal(MEM_TAG_GPU, -textureBytes(map->ids, 2));
+    UnloadTexture(map->ids);
+  }
+  if (map->palette.id) {
+    memTrackExternal(MEM_TAG_GPU, -textureBytes(map->palette, 4));
+    UnloadTexture(map->palette);
+  }
+  if (map->shader.id) {
+    UnloadShader(map->shader);
+  }
+  memFree(map->colors);
+  memset(map, 0, sizeof(*map));
+}
+
+void attachCountryMap(const CountryMap *map, GlobeLod *lod) {
+  if (map->loaded) {
+    setGlobeLodShader(lod, map->shader, map->ids, map->palette);
+  } else {
+    setGlobeLodShader(lod, (Shader){0}, (Texture2D){0}, (Texture2D){0});
+  }
+}
+
+void clearCountryColors(CountryMap *map) {
+  if (!map->colors) return;
+  memset(map->colors, 0, (size_t)map->palette.width * map->palette.height * sizeof(Color));
+}
+
+void setCountryColor(CountryMap *map, uint32_t country, Color color) {
+  if (!map->colors || country >= map->countryCount) return;
+  map->colors[country + 1] = color;
+}
+
+void uploadCountryColors(CountryMap *map) {
+  if (map->palette.id) {
+    UpdateTexture(map->palette, map->colors);
+  }
+}
@@ -0,0 +1,44 @@
+#ifndef COUNTRYMAP_H
+#define COUNTRYMAP_H
+
+#include "raylib/src/raylib.h"
+#include "geodata.h"
+#include "globelod.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Guessed countries shaded on the globe surface instead of drawn as geometry.
+// Once per database every country is rasterized into an id texture laid out
+// in the globe's UV space (country index + 1 per texel, 0 over open water).
+// A small palette texture maps each id to a color, and the globe shader
+// blends that color over the earth texture and outlines the texels whose
+// neighbours hold another id. A guess only rewrites one palette entry, so
+// the frame costs the same however many countries are guessed and however
+// detailed their borders are.
+//
+// The id map is 2048 x 4096 texels, about 10 km at the equator; countries
+// smaller than a texel still get the texels their vertices fall in.
+
+typedef struct {
+  Texture2D ids;      // Gray+alpha texels: id low byte, high byte
+  Texture2D palette;  // One RGBA texel per id; alpha is the fill strength
+  Shader shader;
+  Color *colors;      // CPU copy of the palette
+  uint32_t countryCount;
+  bool loaded;
+} CountryMap;
+
+// Rasterize db and build the shader; call after InitWindow. Countries
+// without geometry are left out, so build once geometry is loaded.
+bool loadCountryMap(CountryMap *map, const CountryDatabase *db);
+void unloadCountryMap(CountryMap *map);
+
+// Shade the globe with the map (or restore plain shading when not loaded)
+void attachCountryMap(const CountryMap *map, GlobeLod *lod);
+
+// Palette edits; nothing reaches the GPU until uploadCountryColors
+void clearCountryColors(CountryMap *map);
+void setCountryColor(CountryMap *map, uint32_t country, Color color);  // Index into db
+void uploadCountryColors(CountryMap *map);
+
+#endif // COUNTRYMAP_H
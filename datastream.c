@@ -0,0 +1,174 @@
+#include "datastream.h"
+#include "geopack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef PLATFORM_WEB
+  #include <emscripten/emscripten.h>
+#endif
+
+// Texture levels in download order (earth_small.jpg is produced by build_web.sh)
+static const char *textureFiles[] = {"earth_small.jpg", "earth2.jpg"};
+#define TEXTURE_LEVEL_COUNT (int)(sizeof(textureFiles) / sizeof(textureFiles[0]))
+
+typedef void (*FetchLoaded)(DatasetStream *stream, unsigned char *data, int size);
+typedef void (*FetchFailed)(DatasetStream *stream);
+
+static void requestChunk(DatasetStream *stream);
+static void requestTexture(DatasetStream *stream);
+
+#ifdef PLATFORM_WEB
+// Browser fetch; the callbacks run later from the event loop
+typedef struct {
+  DatasetStream *stream;
+  FetchLoaded onLoaded;
+  FetchFailed onFailed;
+} FetchRequest;
+
+static void onWgetLoad(unsigned handle, void *arg, void *data, unsigned size) {
+  FetchRequest *req = (FetchRequest *)arg;
+  req->onLoaded(req->stream, (unsigned char *)data, (int)size);
+  free(req);
+}
+
+static void onWgetError(unsigned handle, void *arg, int status, const char *text) {
+  FetchRequest *req = (FetchRequest *)arg;
+  fprintf(stderr, "Error: Fetch failed with status %d\n", status);
+  req->onFailed(req->stream);
+  free(req);
+}
+
+static void fetchFile(DatasetStream *stream, const char *name,
+                      FetchLoaded onLoaded, FetchFailed onFailed) {
+  char url[512];
+  snprintf(url, sizeof(url), "%s/%s", stream->baseUrl, name);
+
+  FetchRequest *req = malloc(sizeof(FetchRequest));
+  req->stream = stream;
+  req->onLoaded = onLoaded;
+  req->onFailed = onFailed;
+
+  // free=0: we take ownership of the downloaded buffer
+  emscripten_async_wget2_data(url, "GET", NULL, req, 0, onWgetLoad,
+                              onWgetError, NULL);
+}
+#else
+// Native fallback: read the file straight away
+static void fetchFile(DatasetStream *stream, const char *name,
+                      FetchLoaded onLoaded, FetchFailed onFailed) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s", stream->baseUrl, name);
+
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "Error: Could not open file %s\n", path);
+    onFailed(stream);
+    return;
+  }
+
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  unsigned char *data = malloc(size > 0 ? size : 1);
+  size_t bytesRead = fread(data, 1, size, f);
+  fclose(f);
+  onLoaded(stream, data, (int)bytesRead);
+}
+#endif
+
+static void onChunkLoaded(DatasetStream *stream, unsigned char *data, int size) {
+  bool ok = loadCountryGeometryChunk(stream->db, data, size);
+  free(data);
+  if (!ok) {
+    // Border mode stays unavailable, centroid mode keeps working
+    return;
+  }
+
+  stream->chunksLoaded++;
+  requestChunk(stream);
+}
+
+static void onChunkFailed(DatasetStream *stream) {
+  // Border mode stays unavailable, centroid mode keeps working
+}
+
+// Geometry chunks are fetched one at a time so they arrive in order
+static void requestChunk(DatasetStream *stream) {
+  if (stream->chunksLoaded >= stream->chunkCount) {
+    printf("Border geometry complete (%u chunks)\n", stream->chunkCount);
+    printGeometryQuantization(stream->db);
+    return;
+  }
+
+  char name[64];
+  snprintf(name, sizeof(name), GEOPACK_CHUNK_FILE, stream->chunksLoaded);
+  fetchFile(stream, name, onChunkLoaded, onChunkFailed);
+}
+
+static void onMetaLoaded(DatasetStream *stream, unsigned char *data, int size) {
+  stream->db = loadCountryDatabaseMeta(data, size, &stream->chunkCount);
+  free(data);
+  if (!stream->db) {
+    stream->failed = true;
+    return;
+  }
+  requestChunk(stream);
+}
+
+static void onMetaFailed(DatasetStream *stream) {
+  stream->failed = true;
+}
+
+static void onTextureLoaded(DatasetStream *stream, unsigned char *data, int size) {
+  // A newer level replaces one that was never uploaded
+  free(stream->textureData);
+  stream->textureData = data;
+  stream->textureSize = size;
+
+  stream->textureLevel++;
+  requestTexture(stream);
+}
+
+static void onTextureFailed(DatasetStream *stream) {
+  // Skip to the next level (e.g. no low resolution copy was generated)
+  stream->textureLevel++;
+  requestTexture(stream);
+}
+
+static void requestTexture(DatasetStream *stream) {
+  if (stream->textureLevel >= TEXTURE_LEVEL_COUNT) {
+    return;
+  }
+  fetchFile(stream, textureFiles[stream->textureLevel], onTextureLoaded,
+            onTextureFailed);
+}
+
+void startDatasetStream(DatasetStream *stream, const char *baseUrl) {
+  memset(stream, 0, sizeof(DatasetStream));
+  snprintf(stream->baseUrl, sizeof(stream->baseUrl), "%s", baseUrl);
+
+#ifdef GEODATA_EMBEDDED
+  // The database is compiled in (geoembed.h); only the textures are fetched
+  stream->db = loadCountryDatabase(NULL);
+  printGeometryQuantization(stream->db);
+#else
+  fetchFile(stream, GEOPACK_META_FILE, onMetaLoaded, onMetaFailed);
+#endif
+  requestTexture(stream);
+}
+
+bool isDatasetGeometryComplete(const DatasetStream *stream) {
+  return stream->db != NULL && stream->chunksLoaded >= stream->chunkCount;
+}
+
+unsigned char *takeStreamedTexture(DatasetStream *stream, int *size) {
+  unsigned char *data = stream->textureData;
+  if (data) {
+    *size = stream->textureSize;
+    stream->textureData = NULL;
+    stream->textureSize = 0;
+  }
+  return data;
+}
@@ -0,0 +1,38 @@
+#ifndef DATASTREAM_H
+#define DATASTREAM_H
+
+#include "geodata.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Incremental download of the packed dataset (see geopack.h) and the globe
+// texture. Metadata arrives first so centroid mode is playable immediately;
+// border geometry follows chunk by chunk, the texture low resolution first.
+// On the web every fetch is asynchronous; natively the files are read from
+// disk as soon as they are requested.
+// Builds with GEODATA_EMBEDDED (geoembed.h) start with the whole database
+// in place and only fetch the texture.
+typedef struct {
+  char baseUrl[256];
+  CountryDatabase *db;    // NULL until the metadata has arrived
+  uint32_t chunkCount;    // Geometry chunks listed in the metadata
+  uint32_t chunksLoaded;  // Geometry chunks attached to db so far
+  bool failed;            // Metadata could not be fetched or parsed
+
+  // Globe texture, streamed lowest resolution first
+  int textureLevel;            // Index of the level currently being fetched
+  unsigned char *textureData;  // Newest downloaded image awaiting upload
+  int textureSize;
+} DatasetStream;
+
+// Begin fetching metadata, geometry and textures relative to baseUrl
+void startDatasetStream(DatasetStream *stream, const char *baseUrl);
+
+// True once every geometry chunk has been attached to the database
+bool isDatasetGeometryComplete(const DatasetStream *stream);
+
+// Take ownership of the newest downloaded texture image (free() when done)
+// Returns NULL if nothing new has arrived since the last call
+unsigned char *takeStreamedTexture(DatasetStream *stream, int *size);
+
+#endif // DATASTREAM_H
@@ -0,0 +1,1032 @@
+// Batch distance CLI for analytics and bots. Reads country pairs, computes
+// each distinct (pair, mode) once across all cores, largest jobs first, and
+// writes one result per input line.
+// Usage: ./distbatch [--csv path] [--threads n] [--mode border|centroid]
+//                    [--format csv|binary] [--output file] [--quantize]
+//                    [--field degrees] [input]
+//        ./distbatch --solve [--csv path] [--threads n] [--mode border|centroid]
+//                    [--field degrees]
+//        ./distbatch --field-report [--csv path] [--threads n]
+//        ./distbatch --validate [--csv path] [--threads n] [--engines list]
+//                    [--max-error km] [--max-p99 km] [--max-bucket-changes n]
+//        ./distbatch --near [--csv path] [--within km] [--nearest k] [input]
+//
+// Input lines are "A,B" or "A,B,mode"; countries are matched by English
+// name, ISO 3 code or ISO alpha-2 code (case-insensitive, names with commas
+// may be double-quoted). Distances are symmetric, so A,B and B,A share a job.
+//
+// CSV output: line,from,to,mode,km (line is the 1-based input line).
+// Binary output: "GLDB", u32 version, u32 record count, then per record
+// u32 line and f32 km, little-endian.
+//
+// --solve computes every pair for the mode instead of reading input, then
+// plays each country as the mystery with the solver's suggestions and
+// reports how many guesses it takes and how long a hint costs.
+//
+// --field computes border distances from raster distance fields at the given
+// cell size (see distfield.h) instead of the exact engine. --field-report
+// computes every border pair exactly, then prints the error, build time and
+// memory of the field engine at several cell sizes.
+//
+// --validate computes every pair with a double-precision reference (see
+// distref.h) and compares each engine against it: the exact border engine,
+// the field engine at three cell sizes and the centroid distance at each
+// precision tier (names: border, field-1, field-0.5, field-0.25, centroid,
+// centroid-float, centroid-fast; --engines takes a comma-separated subset).
+// Per engine it prints the max, mean and p99 error, the speed-up over the
+// reference and how many pairs land in another color band (getColorBucket),
+// then lists a few of those pairs. Any limit given is checked against every
+// engine in the run; the exit status is 2 if one is exceeded.
+//
+// --near answers one query per input line from the cell index (see
+// cellindex.h) without computing all pairs. A country line lists its k
+// nearest countries by border distance (--nearest, 5 by default), or every
+// country within --within km (at most k if both are given); a "lat,lon" line
+// names the country whose border passes nearest the point. CSV output:
+// line,from,to,rank,km.
+#include "cellindex.h"
+#include "distfield.h"
+#include "distref.h"
+#include "game.h"
+#include "memtrack.h"
+#include "solver.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BATCH_MAGIC 0x42444c47  // "GLDB"
+#define BATCH_VERSION 1
+#define MAX_BATCH_THREADS 256
+#define MAX_INPUT_LINE 1024
+
+typedef struct {
+  const char *key;
+  uint32_t country;
+} NameEntry;
+
+typedef struct {
+  uint32_t line;
+  uint32_t from, to;  // Countries in input order (the key is canonical)
+  uint64_t key;       // Pair key until deduplicated, then the job index
+} PairRef;
+
+typedef struct {
+  uint64_t key;   // lower country << 33 | higher country << 1 | mode
+  double cost;    // Estimated work, for largest-first scheduling
+  float km;
+} DistanceJob;
+
+typedef struct {
+  uint64_t jobs;
+  double seconds;     // Summed over all threads
+  double maxSeconds;  // Slowest single job
+} ModeCost;
+
+DEFINE_ARRAY(NameIndex, NameEntry, 1, MEM_TAG_GAME)
+DEFINE_ARRAY(PairArray, PairRef, 1, MEM_TAG_GAME)
+DEFINE_ARRAY(JobArray, DistanceJob, 1, MEM_TAG_GAME)
+DEFINE_ARRAY(KeyArray, uint64_t, 1, MEM_TAG_GAME)
+
+static CountryDatabase *db;
+static DistanceJob *jobs;
+static uint32_t *order;  // Job indices, most expensive first
+static uint32_t jobCount;
+static _Atomic uint32_t nextJob;
+
+// Field engine: one field per country, built before the jobs run
+static bool useFields = false;
+static FieldGrid fieldGrid;
+static CountryField *fields;
+static uint8_t *fieldNeed;  // Per country: FIELD_NONE, FIELD_BORDER or FIELD_FULL
+static _Atomic uint32_t nextFieldCountry;
+
+enum { FIELD_NONE, FIELD_BORDER, FIELD_FULL };
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Country lookup
+
+static int compareNames(const void *a, const void *b) {
+  const NameEntry *na = a;
+  const NameEntry *nb = b;
+  int c = strcasecmp(na->key, nb->key);
+  if (c != 0) return c;
+  return (na->country > nb->country) - (na->country < nb->country);
+}
+
+static void addName(NameIndex *index, const char *key, uint32_t country) {
+  if (key && *key) {
+    NameIndex_push(index, (NameEntry){key, country});
+  }
+}
+
+static void buildNameIndex(NameIndex *index) {
+  NameIndex_init(index);
+  for (uint32_t i = 0; i < db->count; i++) {
+    addName(index, db->countries[i].englishName, i);
+    addName(index, db->countries[i].countryCode, i);
+    addName(index, db->countries[i].alpha2, i);
+  }
+  qsort(NameIndex_data(index), index->size, sizeof(NameEntry), compareNames);
+}
+
+// Lowest country index matching the name or code, or -1
+static int64_t findCountry(const NameIndex *index, const char *key) {
+  const NameEntry *entries = NameIndex_data(index);
+  uint32_t lo = 0, hi = index->size;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (strcasecmp(entries[mid].key, key) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < index->size && strcasecmp(entries[lo].key, key) == 0) {
+    return entries[lo].country;
+  }
+  return -1;
+}
+
+// Input
+
+// Split off the next comma-separated field, honoring double quotes ("" is a
+// literal quote); trims spaces. Returns NULL when the line is used up.
+static char *nextField(char **cursor) {
+  char *p = *cursor;
+  if (!p) return NULL;
+  while (*p == ' ' || *p == '\t') p++;
+
+  char *field = p;
+  char *out = p;
+  if (*p == '"') {
+    p++;
+    while (*p) {
+      if (*p == '"' && p[1] == '"') {
+        *out++ = '"';
+        p += 2;
+      } else if (*p == '"') {
+        p++;
+        break;
+      } else {
+        *out++ = *p++;
+      }
+    }
+    while (*p && *p != ',') p++;
+  } else {
+    while (*p && *p != ',') *out++ = *p++;
+    while (out > field && (out[-1] == ' ' || out[-1] == '\t')) out--;
+  }
+  *cursor = *p == ',' ? p + 1 : NULL;
+  *out = '\0';
+  return field;
+}
+
+static bool parseMode(const char *text, DistanceMode *mode) {
+  if (strcasecmp(text, "border") == 0) {
+    *mode = DISTANCE_MODE_BORDER_TO_BORDER;
+  } else if (strcasecmp(text, "centroid") == 0) {
+    *mode = DISTANCE_MODE_CENTROID;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static const char *modeName(DistanceMode mode) {
+  return mode == DISTANCE_MODE_CENTROID ? "centroid" : "border";
+}
+
+static uint64_t pairKey(uint32_t a, uint32_t b, DistanceMode mode) {
+  uint64_t lo = a < b ? a : b;
+  uint64_t hi = a < b ? b : a;
+  return lo << 33 | hi << 1 | (mode == DISTANCE_MODE_CENTROID);
+}
+
+static void readPairs(FILE *in, const NameIndex *index, DistanceMode defaultMode,
+                      PairArray *pairs, uint64_t *skipped) {
+  char buffer[MAX_INPUT_LINE];
+  uint32_t line = 0;
+  while (fgets(buffer, sizeof(buffer), in)) {
+    line++;
+    buffer[strcspn(buffer, "\r\n")] = '\0';
+    char *cursor = buffer;
+    char *a = nextField(&cursor);
+    char *b = nextField(&cursor);
+    char *modeText = nextField(&cursor);
+    if (!a || !*a) continue;  // Blank line
+
+    DistanceMode mode = defaultMode;
+    int64_t ia = findCountry(index, a);
+    int64_t ib = b ? findCountry(index, b) : -1;
+    if (ia < 0 || ib < 0 || (modeText && *modeText && !parseMode(modeText, &mode))) {
+      // Header rows such as "from,to" land here too
+      fprintf(stderr, "line %u: skipped (%s,%s)\n", line, a, b ? b : "");
+      (*skipped)++;
+      continue;
+    }
+    PairArray_push(pairs, (PairRef){line, (uint32_t)ia, (uint32_t)ib,
+                                    pairKey((uint32_t)ia, (uint32_t)ib, mode)});
+  }
+}
+
+// Scheduling
+
+static int compareKeys(const void *a, const void *b) {
+  uint64_t ka = *(const uint64_t *)a;
+  uint64_t kb = *(const uint64_t *)b;
+  return (ka > kb) - (ka < kb);
+}
+
+static int compareCost(const void *a, const void *b) {
+  double ca = jobs[*(const uint32_t *)a].cost;
+  double cb = jobs[*(const uint32_t *)b].cost;
+  return (ca < cb) - (ca > cb);  // Descending
+}
+
+static uint64_t countryPoints(const CountryData *c) {
+  uint64_t points = 0;
+  Polygon **polys = countryPolygons(c);
+  for (uint32_t i = 0; i < countryRingCount(c); i++) {
+    points += polygonPointCount(polys[i]);
+  }
+  return points;
+}
+
+// One job per distinct key; each pair's key becomes its job index
+static void buildJobs(PairArray *pairs, JobArray *jobList) {
+  KeyArray keys;
+  KeyArray_init(&keys);
+  PairRef *refs = PairArray_data(pairs);
+  for (uint32_t i = 0; i < pairs->size; i++) {
+    KeyArray_push(&keys, refs[i].key);
+  }
+  uint64_t *k = KeyArray_data(&keys);
+  qsort(k, keys.size, sizeof(uint64_t), compareKeys);
+
+  uint64_t *points = memAlloc(MEM_TAG_GAME, (db->count ? db->count : 1) * sizeof(uint64_t));
+  for (uint64_t i = 0; i < db->count; i++) {
+    points[i] = countryPoints(&db->countries[i]);
+  }
+
+  JobArray_init(jobList);
+  for (uint32_t i = 0; i < keys.size; i++) {
+    if (i > 0 && k[i] == k[i - 1]) continue;
+    uint32_t a = (uint32_t)(k[i] >> 33);
+    uint32_t b = (uint32_t)(k[i] >> 1) & 0xFFFFFFFFu;
+    // Border distance walks every vertex of one against every segment of
+    // the other (both directions unless it exits early)
+    // (a field lookup is one pass over b's border cells)
+    double cost = (k[i] & 1) ? 1.0
+                  : useFields ? (double)points[b] / 64.0 + 1.0
+                  : 2.0 * (double)points[a] * (double)points[b] + 1.0;
+    JobArray_push(jobList, (DistanceJob){k[i], cost, 0.0f});
+  }
+  memFree(points);
+
+  // Point each pair at its job (jobs are in key order)
+  DistanceJob *list = JobArray_data(jobList);
+  for (uint32_t i = 0; i < pairs->size; i++) {
+    uint32_t lo = 0, hi = jobList->size;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (list[mid].key < refs[i].key) lo = mid + 1; else hi = mid;
+    }
+    refs[i].key = lo;
+  }
+  KeyArray_free(&keys);
+}
+
+typedef struct {
+  ModeCost cost[DISTANCE_MODE_COUNT];
+} WorkerStats;
+
+static void *workerMain(void *arg) {
+  WorkerStats *stats = arg;
+  for (;;) {
+    uint32_t i = atomic_fetch_add(&nextJob, 1);
+    if (i >= jobCount) break;
+
+    DistanceJob *job = &jobs[order[i]];
+    CountryData *a = &db->countries[job->key >> 33];
+    CountryData *b = &db->countries[(job->key >> 1) & 0xFFFFFFFFu];
+    bool centroid = job->key & 1;
+    double start = now();
+    if (centroid) {
+      job->km = calculateDistance(a->centroid, b->centroid);
+    } else if (useFields) {
+      job->km = fieldBorderDistance(&fields[job->key >> 33],
+                                    &fields[(job->key >> 1) & 0xFFFFFFFFu].border);
+    } else {
+      job->km = calculateBorderToBorderDistance(a, b);
+    }
+    double seconds = now() - start;
+
+    ModeCost *cost = &stats->cost[centroid ? DISTANCE_MODE_CENTROID
+                                           : DISTANCE_MODE_BORDER_TO_BORDER];
+    cost->jobs++;
+    cost->seconds += seconds;
+    if (seconds > cost->maxSeconds) cost->maxSeconds = seconds;
+  }
+  return NULL;
+}
+
+static void *fieldWorkerMain(void *arg) {
+  (void)arg;
+  for (;;) {
+    uint32_t i = atomic_fetch_add(&nextFieldCountry, 1);
+    if (i >= db->count) break;
+    if (fieldNeed[i] == FIELD_FULL) {
+      buildCountryField(&fieldGrid, &db->countries[i], &fields[i]);
+    } else if (fieldNeed[i] == FIELD_BORDER) {
+      buildBorderCells(&fieldGrid, &db->countries[i], &fields[i].border);
+    }
+  }
+  return NULL;
+}
+
+// Run fn on up to threadCount threads (inline if none start); returns how
+// many ran it
+static int runWorkers(void *(*fn)(void *), WorkerStats *stats, int threadCount) {
+  pthread_t threads[MAX_BATCH_THREADS];
+  int started = 0;
+  for (; started < threadCount; started++) {
+    if (pthread_create(&threads[started], NULL, fn, stats ? &stats[started] : NULL) != 0) {
+      break;
+    }
+  }
+  if (started == 0) fn(stats ? &stats[0] : NULL);
+  for (int i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  return started ? started : 1;
+}
+
+// What the border jobs read: the lower country's field and the higher
+// one's border cells
+static void markFieldNeeds(void) {
+  for (uint32_t i = 0; i < jobCount; i++) {
+    if (jobs[i].key & 1) continue;
+    uint32_t a = (uint32_t)(jobs[i].key >> 33);
+    uint32_t b = (uint32_t)(jobs[i].key >> 1) & 0xFFFFFFFFu;
+    fieldNeed[a] = FIELD_FULL;
+    if (fieldNeed[b] == FIELD_NONE) fieldNeed[b] = FIELD_BORDER;
+  }
+}
+
+// Fields at the grid's cell size as fieldNeed asks; returns total bytes
+static uint64_t buildFields(int threadCount) {
+  fields = memCalloc(MEM_TAG_FIELDS, db->count ? db->count : 1, sizeof(CountryField));
+  for (uint64_t i = 0; i < db->count; i++) {
+    CellList_init(&fields[i].border);
+  }
+  atomic_store(&nextFieldCountry, 0);
+  runWorkers(fieldWorkerMain, NULL, threadCount);
+  uint64_t bytes = 0;
+  for (uint64_t i = 0; i < db->count; i++) {
+    bytes += countryFieldBytes(&fieldGrid, &fields[i]);
+  }
+  return bytes;
+}
+
+static void freeFields(void) {
+  for (uint64_t i = 0; fields && i < db->count; i++) {
+    freeCountryField(&fields[i]);
+  }
+  memFree(fields);
+  fields = NULL;
+}
+
+// Every pair of countries in one mode, for the solver table
+static void addAllPairs(PairArray *pairs, DistanceMode mode) {
+  for (uint32_t a = 0; a < db->count; a++) {
+    for (uint32_t b = a + 1; b < db->count; b++) {
+      PairArray_push(pairs, (PairRef){0, a, b, pairKey(a, b, mode)});
+    }
+  }
+}
+
+// Play every country as the mystery, always taking the solver's suggestion
+static void runSolveBenchmark(FILE *out, const PairArray *pairs, DistanceMode mode) {
+  DistanceTable table;
+  initDistanceTable(&table, db, mode);
+  const PairRef *refs = PairArray_data(pairs);
+  for (uint32_t i = 0; i < pairs->size; i++) {
+    const DistanceJob *job = &jobs[refs[i].key];
+    setTableDistance(&table, (uint32_t)(job->key >> 33),
+                     (uint32_t)(job->key >> 1) & 0xFFFFFFFFu, job->km);
+  }
+  double start = now();
+  finishDistanceTable(&table);
+  double sortSeconds = now() - start;
+
+  uint32_t histogram[8] = {0};  // 1..7 guesses, then 8+
+  uint64_t guesses = 0, hints = 0;
+  uint32_t solved = 0, worst = 0;
+  start = now();
+  for (uint32_t mystery = 0; mystery < table.count; mystery++) {
+    CountrySet candidates, guessed;
+    initCountrySet(&candidates, table.count, true);
+    initCountrySet(&guessed, table.count, false);
+    uint32_t taken = 0;
+    for (;;) {
+      SolverHint hint = suggestSolverGuess(&table, &candidates, &guessed);
+      hints++;
+      if (hint.country < 0) break;  // Ran out of consistent countries
+      uint32_t g = (uint32_t)hint.country;
+      taken++;
+      if (g == mystery) {
+        solved++;
+        break;
+      }
+      addToCountrySet(&guessed, g);
+      applySolverGuess(&table, &candidates, g, tableDistance(&table, g, mystery));
+      CountrySet_data(&candidates)[g / 64] &= ~(UINT64_C(1) << (g % 64));
+    }
+    guesses += taken;
+    if (taken > worst) worst = taken;
+    histogram[taken < 8 ? (taken ? taken - 1 : 0) : 7]++;
+    CountrySet_free(&candidates);
+    CountrySet_free(&guessed);
+  }
+  double seconds = now() - start;
+
+  fprintf(out, "Solved %u/%u countries in %s mode: %.2f guesses on average, %u at worst\n",
+          solved, table.count, modeName(mode), table.count ? (double)guesses / table.count : 0.0,
+          worst);
+  fprintf(out, "Guesses:");
+  for (int i = 0; i < 8; i++) {
+    fprintf(out, " %d%s:%u", i + 1, i == 7 ? "+" : "", histogram[i]);
+  }
+  fprintf(out, "\nHints: %llu in %.3f s, %.3f ms each (row sort %.3f ms)\n",
+          (unsigned long long)hints, seconds, hints ? seconds * 1000.0 / hints : 0.0,
+          sortSeconds * 1000.0);
+  freeDistanceTable(&table);
+}
+
+static int compareFloats(const void *a, const void *b) {
+  float x = *(const float *)a;
+  float y = *(const float *)b;
+  return (x > y) - (x < y);
+}
+
+// Field engine against the exact distances already in jobs, per cell size
+static void runFieldReport(FILE *out, int threadCount) {
+  static const float cellSizes[] = {2.0f, 1.0f, 0.5f, 0.25f};
+  memset(fieldNeed, FIELD_FULL, db->count);
+  float *errors = memAlloc(MEM_TAG_GAME, (jobCount ? jobCount : 1) * sizeof(float));
+
+  fprintf(out, "Field engine vs exact over %u border pairs\n", jobCount);
+  fprintf(out, "%8s %10s %10s %10s %10s %10s %10s %10s\n", "degrees", "bound km", "build s",
+          "MB", "query us", "mean km", "p95 km", "max km");
+  for (size_t r = 0; r < sizeof(cellSizes) / sizeof(cellSizes[0]); r++) {
+    initFieldGrid(&fieldGrid, cellSizes[r]);
+    double start = now();
+    uint64_t bytes = buildFields(threadCount);
+    double buildSeconds = now() - start;
+
+    double sum = 0.0;
+    start = now();
+    for (uint32_t i = 0; i < jobCount; i++) {
+      const DistanceJob *job = &jobs[i];
+      float km = fieldBorderDistance(&fields[job->key >> 33],
+                                     &fields[(job->key >> 1) & 0xFFFFFFFFu].border);
+      errors[i] = fabsf(km - job->km);
+      sum += errors[i];
+    }
+    double querySeconds = now() - start;
+    qsort(errors, jobCount, sizeof(float), compareFloats);
+
+    fprintf(out, "%8.2f %10.1f %10.3f %10.1f %10.3f %10.1f %10.1f %10.1f\n",
+            fieldGrid.cellDegrees, fieldCellErrorKm(&fieldGrid), buildSeconds,
+            bytes / (1024.0 * 1024.0), jobCount ? querySeconds * 1e6 / jobCount : 0.0,
+            jobCount ? sum / jobCount : 0.0, jobCount ? errors[(uint32_t)(jobCount * 0.95)] : 0.0,
+            jobCount ? errors[jobCount - 1] : 0.0);
+    freeFields();
+    freeFieldGrid(&fieldGrid);
+  }
+  memFree(errors);
+}
+
+// Validation
+
+#define VALIDATE_ENGINES 7
+#define VALIDATE_EXAMPLES 5  // Band changes listed per engine
+
+typedef struct {
+  double maxError;  // km; negative when not checked
+  double maxP99;
+  long maxBucketChanges;
+} ValidateLimits;
+
+typedef struct {
+  const char *name;
+  bool centroid;   // Compared against the centroid reference
+  float *km;       // Per job
+  double seconds;  // Compute, summed over threads
+} EngineRun;
+
+static RefShape *refShapes;
+static double *refKm;  // Reference border km per job
+static _Atomic uint32_t nextRefCountry;
+
+static void *refShapeWorkerMain(void *arg) {
+  (void)arg;
+  for (;;) {
+    uint32_t i = atomic_fetch_add(&nextRefCountry, 1);
+    if (i >= db->count) break;
+    buildRefShape(&db->countries[i], &refShapes[i]);
+  }
+  return NULL;
+}
+
+static void *refWorkerMain(void *arg) {
+  WorkerStats *stats = arg;
+  for (;;) {
+    uint32_t i = atomic_fetch_add(&nextJob, 1);
+    if (i >= jobCount) break;
+
+    uint32_t j = order[i];
+    double start = now();
+    refKm[j] = refBorderDistanceKm(&refShapes[jobs[j].key >> 33],
+                                   &refShapes[(jobs[j].key >> 1) & 0xFFFFFFFFu]);
+    double seconds = now() - start;
+    ModeCost *cost = &stats->cost[DISTANCE_MODE_BORDER_TO_BORDER];
+    cost->jobs++;
+    cost->seconds += seconds;
+    if (seconds > cost->maxSeconds) cost->maxSeconds = seconds;
+  }
+  return NULL;
+}
+
+static double borderSeconds(const WorkerStats *stats, int started) {
+  double seconds = 0.0;
+  for (int t = 0; t < started; t++) {
+    seconds += stats[t].cost[DISTANCE_MODE_BORDER_TO_BORDER].seconds;
+  }
+  return seconds;
+}
+
+// Is name in the comma-separated list (every engine when there is none)?
+static bool engineSelected(const char *list, const char *name) {
+  if (!list) return true;
+  size_t length = strlen(name);
+  for (const char *p = list; *p;) {
+    size_t token = strcspn(p, ",");
+    if (token == length && strncasecmp(p, name, length) == 0) return true;
+    p += token;
+    if (*p == ',') p++;
+  }
+  return false;
+}
+
+// Every engine against the reference, over the border pairs already in jobs
+// (computed by the exact engine in stats). Returns whether all limits held.
+static bool runValidation(FILE *out, int threadCount, const WorkerStats *stats, int started,
+                          const char *engineList, const ValidateLimits *limits) {
+  static const float cellSizes[] = {1.0f, 0.5f, 0.25f};
+  static const char *fieldNames[] = {"field-1", "field-0.5", "field-0.25"};
+  static const char *centroidNames[PRECISION_COUNT] = {"centroid", "centroid-float",
+                                                       "centroid-fast"};
+  uint32_t count = jobCount ? jobCount : 1;
+
+  // Reference: shapes once per country, then every pair across all cores
+  double start = now();
+  refShapes = memCalloc(MEM_TAG_GAME, db->count ? db->count : 1, sizeof(RefShape));
+  atomic_store(&nextRefCountry, 0);
+  runWorkers(refShapeWorkerMain, NULL, threadCount);
+  uint64_t arcs = 0;
+  for (uint64_t i = 0; i < db->count; i++) arcs += refShapes[i].arcs.size;
+  double shapeSeconds = now() - start;
+
+  refKm = memAlloc(MEM_TAG_GAME, count * sizeof(double));
+  WorkerStats refStats[MAX_BATCH_THREADS];
+  memset(refStats, 0, sizeof(refStats));
+  atomic_store(&nextJob, 0);
+  start = now();
+  int refStarted = runWorkers(refWorkerMain, refStats, threadCount);
+  double refWall = now() - start;
+  double refSeconds = borderSeconds(refStats, refStarted);
+
+  double *refCentroidKm = memAlloc(MEM_TAG_GAME, count * sizeof(double));
+  start = now();
+  for (uint32_t i = 0; i < jobCount; i++) {
+    refCentroidKm[i] = refCentroidDistanceKm(db->countries[jobs[i].key >> 33].centroid,
+                                             db->countries[(jobs[i].key >> 1) & 0xFFFFFFFFu].centroid);
+  }
+  double refCentroidSeconds = now() - start;
+
+  fprintf(out, "Reference: %llu arcs of at most %.2f degrees (%.3f s), %u border pairs in "
+          "%.3f s wall\n", (unsigned long long)arcs, REF_STEP_DEGREES, shapeSeconds, jobCount,
+          refWall);
+
+  // Engines; field timings are queries only, as the fields build once
+  EngineRun runs[VALIDATE_ENGINES];
+  int runCount = 0;
+  if (engineSelected(engineList, "border")) {
+    float *km = memAlloc(MEM_TAG_GAME, count * sizeof(float));
+    for (uint32_t i = 0; i < jobCount; i++) km[i] = jobs[i].km;
+    runs[runCount++] = (EngineRun){"border", false, km, borderSeconds(stats, started)};
+  }
+  memset(fieldNeed, FIELD_FULL, db->count);
+  for (size_t r = 0; r < sizeof(cellSizes) / sizeof(cellSizes[0]); r++) {
+    if (!engineSelected(engineList, fieldNames[r])) continue;
+    initFieldGrid(&fieldGrid, cellSizes[r]);
+    buildFields(threadCount);
+    float *km = memAlloc(MEM_TAG_GAME, count * sizeof(float));
+    start = now();
+    for (uint32_t i = 0; i < jobCount; i++) {
+      km[i] = fieldBorderDistance(&fields[jobs[i].key >> 33],
+                                  &fields[(jobs[i].key >> 1) & 0xFFFFFFFFu].border);
+    }
+    runs[runCount++] = (EngineRun){fieldNames[r], false, km, now() - start};
+    freeFields();
+    freeFieldGrid(&fieldGrid);
+  }
+  for (int tier = 0; tier < PRECISION_COUNT; tier++) {
+    if (!engineSelected(engineList, centroidNames[tier])) continue;
+    float *km = memAlloc(MEM_TAG_GAME, count * sizeof(float));
+    start = now();
+    for (uint32_t i = 0; i < jobCount; i++) {
+      km[i] = greatCircleKm(db->countries[jobs[i].key >> 33].centroid,
+                            db->countries[(jobs[i].key >> 1) & 0xFFFFFFFFu].centroid,
+                            (Precision)tier);
+    }
+    runs[runCount++] = (EngineRun){centroidNames[tier], true, km, now() - start};
+  }
+
+  // Report
+  bool passed = true;
+  float *errors = memAlloc(MEM_TAG_GAME, count * sizeof(float));
+  uint32_t changed[VALIDATE_ENGINES];
+  fprintf(out, "%-14s %8s %10s %10s %10s %10s %10s %8s\n", "engine", "pairs", "max km",
+          "mean km", "p99 km", "us/pair", "speed-up", "bands");
+  for (int e = 0; e < runCount; e++) {
+    const EngineRun *run = &runs[e];
+    const double *reference = run->centroid ? refCentroidKm : refKm;
+    double sum = 0.0;
+    changed[e] = 0;
+    for (uint32_t i = 0; i < jobCount; i++) {
+      errors[i] = (float)fabs(run->km[i] - reference[i]);
+      sum += errors[i];
+      changed[e] += getColorBucket(run->km[i], MAX_DISTANCE_KM) !=
+                    getColorBucket((float)reference[i], MAX_DISTANCE_KM);
+    }
+    qsort(errors, jobCount, sizeof(float), compareFloats);
+    double maxError = jobCount ? errors[jobCount - 1] : 0.0;
+    double p99 = jobCount ? errors[(uint32_t)(jobCount * 0.99)] : 0.0;
+    double baseline = run->centroid ? refCentroidSeconds : refSeconds;
+
+    fprintf(out, "%-14s %8u %10.3f %10.3f %10.3f %10.3f %10.1f %8u\n", run->name, jobCount,
+            maxError, jobCount ? sum / jobCount : 0.0, p99,
+            jobCount ? run->seconds * 1e6 / jobCount : 0.0,
+            run->seconds > 0.0 ? baseline / run->seconds : 0.0, changed[e]);
+
+    if ((limits->maxError >= 0.0 && maxError > limits->maxError) ||
+        (limits->maxP99 >= 0.0 && p99 > limits->maxP99) ||
+        (limits->maxBucketChanges >= 0 && changed[e] > (uint64_t)limits->maxBucketChanges)) {
+      passed = false;
+    }
+  }
+
+  for (int e = 0; e < runCount; e++) {
+    const EngineRun *run = &runs[e];
+    const double *reference = run->centroid ? refCentroidKm : refKm;
+    uint32_t listed = 0;
+    if (changed[e] > 0) fprintf(out, "%s: %u pairs change band\n", run->name, changed[e]);
+    for (uint32_t i = 0; i < jobCount && listed < VALIDATE_EXAMPLES; i++) {
+      int engineBucket = getColorBucket(run->km[i], MAX_DISTANCE_KM);
+      int refBucket = getColorBucket((float)reference[i], MAX_DISTANCE_KM);
+      if (engineBucket == refBucket) continue;
+      fprintf(out, "  %s - %s: %.3f km (band %d), reference %.3f km (band %d)\n",
+              db->countries[jobs[i].key >> 33].englishName,
+              db->countries[(jobs[i].key >> 1) & 0xFFFFFFFFu].englishName, run->km[i],
+              engineBucket, reference[i], refBucket);
+      listed++;
+    }
+  }
+  if (limits->maxError >= 0.0 || limits->maxP99 >= 0.0 || limits->maxBucketChanges >= 0) {
+    fprintf(out, "Validation %s\n", passed ? "passed" : "FAILED");
+  }
+
+  for (int e = 0; e < runCount; e++) memFree(runs[e].km);
+  memFree(errors);
+  memFree(refCentroidKm);
+  memFree(refKm);
+  for (uint64_t i = 0; i < db->count; i++) freeRefShape(&refShapes[i]);
+  memFree(refShapes);
+  return passed;
+}
+
+// Output
+
+static void writeCsvName(FILE *out, const char *name) {
+  if (!strpbrk(name, ",\"")) {
+    fputs(name, out);
+    return;
+  }
+  fputc('"', out);
+  for (const char *p = name; *p; p++) {
+    if (*p == '"') fputc('"', out);
+    fputc(*p, out);
+  }
+  fputc('"', out);
+}
+
+static void writeResults(FILE *out, bool binary, const PairArray *pairs) {
+  const PairRef *refs = PairArray_data(pairs);
+  if (binary) {
+    uint32_t header[3] = {BATCH_MAGIC, BATCH_VERSION, pairs->size};
+    fwrite(header, sizeof(header), 1, out);
+    for (uint32_t i = 0; i < pairs->size; i++) {
+      fwrite(&refs[i].line, sizeof(uint32_t), 1, out);
+      fwrite(&jobs[refs[i].key].km, sizeof(float), 1, out);
+    }
+    return;
+  }
+
+  fputs("line,from,to,mode,km\n", out);
+  for (uint32_t i = 0; i < pairs->size; i++) {
+    const DistanceJob *job = &jobs[refs[i].key];
+    fprintf(out, "%u,", refs[i].line);
+    writeCsvName(out, db->countries[refs[i].from].englishName);
+    fputc(',', out);
+    writeCsvName(out, db->countries[refs[i].to].englishName);
+    fprintf(out, ",%s,%.3f\n", (job->key & 1) ? "centroid" : "border", job->km);
+  }
+}
+
+// --near: nearest neighbours from the cell index, one query per input line
+
+static bool parseNumber(const char *text, float *value) {
+  char *end;
+  double v = strtod(text, &end);
+  if (end == text || *end) return false;
+  *value = (float)v;
+  return true;
+}
+
+static void runNearQueries(FILE *in, FILE *out, const NameIndex *names, float withinKm,
+                           long nearestK, uint64_t *skipped) {
+  double start = now();
+  CellIndex *index = buildCellIndex(db);
+  uint32_t countryCells = index->countryStart[db->count];
+  fprintf(stderr, "Cell index: %llu segment entries, %u country cells at level %d, %.1f MB, "
+          "%.3f s\n", (unsigned long long)index->entryCount, countryCells, CELL_INDEX_LEVEL,
+          (index->entryCount * sizeof(CellEntry) + countryCells * sizeof(uint64_t) +
+           (db->count + 1) * sizeof(uint32_t)) / (1024.0 * 1024.0), now() - start);
+
+  CountryDistanceArray found;
+  CountryDistanceArray_init(&found);
+  char buffer[MAX_INPUT_LINE];
+  uint32_t line = 0, queries = 0;
+  double queryStart = now();
+  fputs("line,from,to,rank,km\n", out);
+  while (fgets(buffer, sizeof(buffer), in)) {
+    line++;
+    buffer[strcspn(buffer, "\r\n")] = '\0';
+    char *cursor = buffer;
+    char *a = nextField(&cursor);
+    char *b = nextField(&cursor);
+    if (!a || !*a) continue;  // Blank line
+
+    float lat, lon;
+    if (b && parseNumber(a, &lat) && parseNumber(b, &lon)) {
+      float km;
+      CountryData *nearest = nearestCountryTo(index, lat, lon, &km);
+      queries++;
+      if (!nearest) continue;
+      fprintf(out, "%u,\"%g,%g\",", line, lat, lon);
+      writeCsvName(out, nearest->englishName);
+      fprintf(out, ",1,%.3f\n", km);
+      continue;
+    }
+
+    int64_t country = findCountry(names, a);
+    if (country < 0) {
+      // Header rows land here too
+      fprintf(stderr, "line %u: skipped (%s)\n", line, a);
+      (*skipped)++;
+      continue;
+    }
+    if (withinKm >= 0.0f) {
+      countriesWithinKm(index, (uint32_t)country, withinKm, &found);
+      if (nearestK > 0 && found.size > nearestK) found.size = (uint32_t)nearestK;
+    } else {
+      nearestCountries(index, (uint32_t)country, (uint32_t)nearestK, &found);
+    }
+    queries++;
+    const CountryDistance *items = CountryDistanceArray_data(&found);
+    for (uint32_t i = 0; i < found.size; i++) {
+      fprintf(out, "%u,", line);
+      writeCsvName(out, db->countries[country].englishName);
+      fputc(',', out);
+      writeCsvName(out, db->countries[items[i].country].englishName);
+      fprintf(out, ",%u,%.3f\n", i + 1, items[i].km);
+    }
+  }
+  double seconds = now() - queryStart;
+  fprintf(stderr, "Near: %u queries, %.3f s, %.3f ms per query\n", queries, seconds,
+          queries ? seconds * 1000.0 / queries : 0.0);
+
+  CountryDistanceArray_free(&found);
+  freeCellIndex(index);
+}
+
+int main(int argc, char **argv) {
+  const char *csvPath = "./coordinates/ccc.csv";
+  const char *inputPath = NULL;
+  const char *outputPath = NULL;
+  DistanceMode defaultMode = DISTANCE_MODE_BORDER_TO_BORDER;
+  bool binary = false;
+  bool solve = false;
+  bool fieldReport = false;
+  bool validate = false;
+  bool near = false;
+  float withinKm = -1.0f;
+  long nearestK = 0;
+  const char *engineList = NULL;
+  ValidateLimits limits = {-1.0, -1.0, -1};
+  float fieldDegrees = 0.0f;
+  long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+      csvPath = argv[++i];
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threadCount = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc &&
+               parseMode(argv[i + 1], &defaultMode)) {
+      i++;
+    } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc &&
+               (strcmp(argv[i + 1], "csv") == 0 || strcmp(argv[i + 1], "binary") == 0)) {
+      binary = strcmp(argv[++i], "binary") == 0;
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      outputPath = argv[++i];
+    } else if (strcmp(argv[i], "--quantize") == 0) {
+      setGeometryQuantization(true);
+    } else if (strcmp(argv[i], "--solve") == 0) {
+      solve = true;
+    } else if (strcmp(argv[i], "--field") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0.0) {
+      useFields = true;
+      fieldDegrees = (float)atof(argv[++i]);
+    } else if (strcmp(argv[i], "--field-report") == 0) {
+      fieldReport = true;
+    } else if (strcmp(argv[i], "--validate") == 0) {
+      validate = true;
+    } else if (strcmp(argv[i], "--engines") == 0 && i + 1 < argc) {
+      engineList = argv[++i];
+    } else if (strcmp(argv[i], "--max-error") == 0 && i + 1 < argc) {
+      limits.maxError = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--max-p99") == 0 && i + 1 < argc) {
+      limits.maxP99 = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--max-bucket-changes") == 0 && i + 1 < argc) {
+      limits.maxBucketChanges = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--near") == 0) {
+      near = true;
+    } else if (strcmp(argv[i], "--within") == 0 && i + 1 < argc && atof(argv[i + 1]) >= 0.0) {
+      withinKm = (float)atof(argv[++i]);
+    } else if (strcmp(argv[i], "--nearest") == 0 && i + 1 < argc && atol(argv[i + 1]) > 0) {
+      nearestK = atol(argv[++i]);
+    } else if (argv[i][0] != '-' && !inputPath) {
+      inputPath = argv[i];
+    } else {
+      fprintf(stderr, "Usage: %s [--csv path] [--threads n] [--mode border|centroid] "
+              "[--format csv|binary] [--output file] [--quantize] [--solve] "
+              "[--field degrees] [--field-report] [--validate] [--engines list] "
+              "[--max-error km] [--max-p99 km] [--max-bucket-changes n] [--near] "
+              "[--within km] [--nearest k] [input]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  if (near && withinKm < 0.0f && nearestK == 0) nearestK = 5;
+  if (threadCount < 1) threadCount = 1;
+  if (threadCount > MAX_BATCH_THREADS) threadCount = MAX_BATCH_THREADS;
+
+  if (fieldReport || validate) {
+    solve = false;
+    useFields = false;  // The report needs exact distances to compare against
+    defaultMode = DISTANCE_MODE_BORDER_TO_BORDER;
+  }
+  bool allPairs = solve || fieldReport || validate;
+  FILE *in = allPairs ? NULL : inputPath ? fopen(inputPath, "r") : stdin;
+  FILE *out = outputPath ? fopen(outputPath, binary ? "wb" : "w") : stdout;
+  if ((!in && !allPairs) || !out) {
+    fprintf(stderr, "Error: Could not open %s\n", !in ? inputPath : outputPath);
+    return 1;
+  }
+
+  // The loader reports progress on stdout; keep it out of piped results
+  setGameLogging(false);
+  int savedStdout = -1;
+  if (out == stdout) {
+    fflush(stdout);
+    savedStdout = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+  }
+  db = loadCountryDatabase(csvPath);
+  if (db) printGeometryQuantization(db);
+  if (savedStdout >= 0) {
+    fflush(stdout);
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+  }
+  if (!db) {
+    fprintf(stderr, "Failed to load country database!\n");
+    return 1;
+  }
+
+  NameIndex names;
+  buildNameIndex(&names);
+  PairArray pairs;
+  PairArray_init(&pairs);
+  uint64_t skipped = 0;
+  if (allPairs) {
+    addAllPairs(&pairs, defaultMode);
+  } else if (!near) {
+    readPairs(in, &names, defaultMode, &pairs, &skipped);
+    if (in != stdin) fclose(in);
+  }
+
+  JobArray jobList;
+  buildJobs(&pairs, &jobList);
+  jobs = JobArray_data(&jobList);
+  jobCount = jobList.size;
+  order = memAlloc(MEM_TAG_GAME, (jobCount ? jobCount : 1) * sizeof(uint32_t));
+  for (uint32_t i = 0; i < jobCount; i++) order[i] = i;
+  qsort(order, jobCount, sizeof(uint32_t), compareCost);
+
+  fieldNeed = memCalloc(MEM_TAG_FIELDS, db->count ? db->count : 1, 1);
+  double start = now();
+  if (useFields) {
+    initFieldGrid(&fieldGrid, fieldDegrees);
+    markFieldNeeds();
+    uint64_t bytes = buildFields((int)threadCount);
+    uint32_t built = 0;
+    for (uint64_t i = 0; i < db->count; i++) built += fieldNeed[i] == FIELD_FULL;
+    fprintf(stderr, "Fields: %u at %.2f degrees (within about %.0f km), %.1f MB, %.3f s\n",
+            built, fieldGrid.cellDegrees, fieldCellErrorKm(&fieldGrid),
+            bytes / (1024.0 * 1024.0), now() - start);
+  }
+
+  // Largest first: the long border jobs start early and the cheap ones fill
+  // in around them, so no core is left finishing one big job alone
+  WorkerStats stats[MAX_BATCH_THREADS];
+  memset(stats, 0, sizeof(stats));
+  int started = runWorkers(workerMain, stats, (int)threadCount);
+  double wall = now() - start;
+
+  bool passed = true;
+  if (validate) {
+    passed = runValidation(out, (int)threadCount, stats, started, engineList, &limits);
+  } else if (fieldReport) {
+    runFieldReport(out, (int)threadCount);
+  } else if (solve) {
+    runSolveBenchmark(out, &pairs, defaultMode);
+  } else if (near) {
+    runNearQueries(in, out, &names, withinKm, nearestK, &skipped);
+    if (in != stdin) fclose(in);
+  } else {
+    writeResults(out, binary, &pairs);
+  }
+  if (out != stdout) fclose(out); else fflush(out);
+
+  fprintf(stderr, "Pairs: %u read, %llu skipped, %u distinct jobs on %d thread(s), "
+          "%.3f s wall\n", pairs.size, (unsigned long long)skipped, jobCount, started, wall);
+  for (int m = 0; m < DISTANCE_MODE_COUNT; m++) {
+    ModeCost total = {0};
+    for (int t = 0; t < started; t++) {
+      total.jobs += stats[t].cost[m].jobs;
+      total.seconds += stats[t].cost[m].seconds;
+      if (stats[t].cost[m].maxSeconds > total.maxSeconds) {
+        total.maxSeconds = stats[t].cost[m].maxSeconds;
+      }
+    }
+    if (total.jobs == 0) continue;
+    fprintf(stderr, "  %-8s %llu jobs, %.3f s compute, %.3f ms avg, %.3f ms max\n",
+            modeName((DistanceMode)m), (unsigned long long)total.jobs, total.seconds,
+            total.seconds * 1000.0 / total.jobs, total.maxSeconds * 1000.0);
+  }
+
+  if (useFields) {
+    freeFields();
+    freeFieldGrid(&fieldGrid);
+  }
+  memFree(fieldNeed);
+  memFree(order);
+  JobArray_free(&jobList);
+  PairArray_free(&pairs);
+  NameIndex_free(&names);
+  freeCountryDatabase(db);
+  return passed ? 0 : 2;
+}
@@ -0,0 +1,289 @@
+#include "distfield.h"
+#include "geomath.h"
+#include "memtrack.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FIELD_PI 3.14159265358979323846
+#define FIELD_MAX_PASSES 8  // Sweeps rarely need more than three to settle
+
+// Border sample: unit vector plus the cell it falls in
+typedef struct {
+  float x, y, z;
+  uint32_t cell;
+} FieldSeed;
+
+DEFINE_ARRAY(SeedArray, FieldSeed, 1, MEM_TAG_FIELDS)
+
+void initFieldGrid(FieldGrid *grid, float cellDegrees) {
+  if (cellDegrees < FIELD_MIN_DEGREES) cellDegrees = FIELD_MIN_DEGREES;
+  if (cellDegrees > FIELD_MAX_DEGREES) cellDegrees = FIELD_MAX_DEGREES;
+  grid->rows = (uint32_t)ceilf(180.0f / cellDegrees - 1e-3f);
+  grid->cols = grid->rows * 2;
+  grid->cellDegrees = 180.0f / (float)grid->rows;
+
+  grid->sinLat = memAlloc(MEM_TAG_FIELDS, grid->rows * sizeof(float));
+  grid->cosLat = memAlloc(MEM_TAG_FIELDS, grid->rows * sizeof(float));
+  grid->sinLon = memAlloc(MEM_TAG_FIELDS, grid->cols * sizeof(float));
+  grid->cosLon = memAlloc(MEM_TAG_FIELDS, grid->cols * sizeof(float));
+  double step = grid->cellDegrees * FIELD_PI / 180.0;
+  for (uint32_t r = 0; r < grid->rows; r++) {
+    double lat = FIELD_PI / 2.0 - (r + 0.5) * step;
+    grid->sinLat[r] = (float)sin(lat);
+    grid->cosLat[r] = (float)cos(lat);
+  }
+  for (uint32_t c = 0; c < grid->cols; c++) {
+    double lon = -FIELD_PI + (c + 0.5) * step;
+    grid->sinLon[c] = (float)sin(lon);
+    grid->cosLon[c] = (float)cos(lon);
+  }
+}
+
+void freeFieldGrid(FieldGrid *grid) {
+  memFree(grid->sinLat);
+  memFree(grid->cosLat);
+  memFree(grid->sinLon);
+  memFree(grid->cosLon);
+  memset(grid, 0, sizeof(*grid));
+}
+
+uint32_t fieldCellAt(const FieldGrid *grid, GeoPoint p) {
+  int row = (int)floorf((90.0f - p.lat) / grid->cellDegrees);
+  int col = (int)floorf((p.lon + 180.0f) / grid->cellDegrees);
+  if (row < 0) row = 0;
+  if (row >= (int)grid->rows) row = (int)grid->rows - 1;
+  col %= (int)grid->cols;
+  if (col < 0) col += (int)grid->cols;
+  return (uint32_t)row * grid->cols + (uint32_t)col;
+}
+
+GeoPoint fieldCellCenter(const FieldGrid *grid, uint32_t cell) {
+  uint32_t row = cell / grid->cols;
+  uint32_t col = cell % grid->cols;
+  return (GeoPoint){90.0f - (row + 0.5f) * grid->cellDegrees,
+                    -180.0f + (col + 0.5f) * grid->cellDegrees};
+}
+
+float fieldCellErrorKm(const FieldGrid *grid) {
+  double diagonal = grid->cellDegrees * 1.41421356237309505 * FIELD_PI / 180.0;
+  return (float)(0.5 * diagonal * GEO_EARTH_RADIUS_KM);
+}
+
+// Squared chord from a cell's center to a seed
+static inline float chord2(const FieldGrid *grid, uint32_t row, uint32_t col,
+                           const FieldSeed *s) {
+  float x = grid->cosLat[row] * grid->cosLon[col] - s->x;
+  float y = grid->cosLat[row] * grid->sinLon[col] - s->y;
+  float z = grid->sinLat[row] - s->z;
+  return x * x + y * y + z * z;
+}
+
+static void addSeed(const FieldGrid *grid, SeedArray *seeds, GeoPoint p) {
+  double lat = p.lat * FIELD_PI / 180.0;
+  double lon = p.lon * FIELD_PI / 180.0;
+  SeedArray_push(seeds, (FieldSeed){(float)(cos(lat) * cos(lon)), (float)(cos(lat) * sin(lon)),
+                                    (float)sin(lat), fieldCellAt(grid, p)});
+}
+
+// Points along every ring, at most half a cell apart. Segments are walked
+// in lat/lon like the exact engine's, so both measure the same border.
+static void seedBorder(const FieldGrid *grid, const CountryData *country, SeedArray *seeds) {
+  float spacing = grid->cellDegrees * 0.5f;
+  Polygon **polys = countryPolygons(country);
+  for (uint32_t i = 0; i < countryRingCount(country); i++) {
+    GeoPointArray scratch;
+    GeoPointArray_init(&scratch);
+    const GeoPoint *points = polygonPoints(polys[i], &scratch);
+    uint64_t count = polygonPointCount(polys[i]);
+    for (uint64_t j = 0; j < count; j++) {
+      GeoPoint a = points[j];
+      GeoPoint b = points[(j + 1) % count];
+      float span = fmaxf(fabsf(b.lat - a.lat), fabsf(b.lon - a.lon));
+      int steps = (int)ceilf(span / spacing);
+      if (steps < 1) steps = 1;
+      for (int s = 0; s < steps; s++) {
+        float t = (float)s / (float)steps;
+        addSeed(grid, seeds, (GeoPoint){a.lat + t * (b.lat - a.lat), a.lon + t * (b.lon - a.lon)});
+      }
+    }
+    GeoPointArray_free(&scratch);
+  }
+}
+
+static int compareCells(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+void buildBorderCells(const FieldGrid *grid, const CountryData *country, CellList *cells) {
+  SeedArray seeds;
+  SeedArray_init(&seeds);
+  seedBorder(grid, country, &seeds);
+
+  CellList_init(cells);
+  CellList_reserve(cells, seeds.size);
+  uint32_t *out = CellList_data(cells);
+  const FieldSeed *s = SeedArray_data(&seeds);
+  for (uint32_t i = 0; i < seeds.size; i++) {
+    out[i] = s[i].cell;
+  }
+  qsort(out, seeds.size, sizeof(uint32_t), compareCells);
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < seeds.size; i++) {
+    if (n == 0 || out[n - 1] != out[i]) out[n++] = out[i];
+  }
+  cells->size = n;
+  CellList_shrink(cells);
+  SeedArray_free(&seeds);
+}
+
+// Propagation state: each cell's nearest seed so far and its squared chord
+typedef struct {
+  const FieldGrid *grid;
+  const FieldSeed *seeds;
+  int32_t *nearest;
+  float *best;
+  bool changed;
+} Sweep;
+
+// Offer cell (row, col) the nearest seed of cell `from`
+static inline void offer(Sweep *s, uint32_t row, uint32_t col, uint32_t from) {
+  int32_t seed = s->nearest[from];
+  if (seed < 0) return;
+  uint32_t cell = row * s->grid->cols + col;
+  if (s->nearest[cell] == seed) return;
+  float d2 = chord2(s->grid, row, col, &s->seeds[seed]);
+  if (d2 < s->best[cell]) {
+    s->best[cell] = d2;
+    s->nearest[cell] = seed;
+    s->changed = true;
+  }
+}
+
+// One sweep in each direction. Each cell takes the nearest seed of its
+// already-visited neighbours (vector distance transform); columns wrap at
+// the antimeridian, and the polar rows also look across the pole.
+static void sweep(Sweep *s) {
+  const FieldGrid *g = s->grid;
+  uint32_t rows = g->rows, cols = g->cols;
+  for (uint32_t r = 0; r < rows; r++) {
+    for (uint32_t c = 0; c < cols; c++) {
+      uint32_t left = (c + cols - 1) % cols;
+      uint32_t right = (c + 1) % cols;
+      if (r > 0) {
+        uint32_t up = (r - 1) * cols;
+        offer(s, r, c, up + left);
+        offer(s, r, c, up + c);
+        offer(s, r, c, up + right);
+      } else {
+        offer(s, r, c, (c + cols / 2) % cols);
+      }
+      offer(s, r, c, r * cols + left);
+    }
+    for (uint32_t c = cols; c-- > 0;) {
+      offer(s, r, c, r * cols + (c + 1) % cols);
+    }
+  }
+  for (uint32_t r = rows; r-- > 0;) {
+    for (uint32_t c = cols; c-- > 0;) {
+      uint32_t left = (c + cols - 1) % cols;
+      uint32_t right = (c + 1) % cols;
+      if (r + 1 < rows) {
+        uint32_t down = (r + 1) * cols;
+        offer(s, r, c, down + right);
+        offer(s, r, c, down + c);
+        offer(s, r, c, down + left);
+      } else {
+        offer(s, r, c, r * cols + (c + cols / 2) % cols);
+      }
+      offer(s, r, c, r * cols + right);
+    }
+    for (uint32_t c = 0; c < cols; c++) {
+      offer(s, r, c, r * cols + (c + cols - 1) % cols);
+    }
+  }
+}
+
+void buildCountryField(const FieldGrid *grid, const CountryData *country,
+                       CountryField *field) {
+  field->km = NULL;
+  CellList_init(&field->border);
+
+  SeedArray seeds;
+  SeedArray_init(&seeds);
+  seedBorder(grid, country, &seeds);
+  if (seeds.size == 0) {
+    SeedArray_free(&seeds);
+    return;
+  }
+
+  uint32_t cells = fieldCellCount(grid);
+  Sweep s = {grid, SeedArray_data(&seeds), NULL, NULL, false};
+  s.nearest = memAlloc(MEM_TAG_FIELDS, cells * sizeof(int32_t));
+  s.best = memAlloc(MEM_TAG_FIELDS, cells * sizeof(float));
+  for (uint32_t i = 0; i < cells; i++) {
+    s.nearest[i] = -1;
+    s.best[i] = INFINITY;
+  }
+
+  // Seed cells start from their own closest sample
+  for (uint32_t i = 0; i < seeds.size; i++) {
+    const FieldSeed *seed = &s.seeds[i];
+    float d2 = chord2(grid, seed->cell / grid->cols, seed->cell % grid->cols, seed);
+    if (d2 < s.best[seed->cell]) {
+      s.best[seed->cell] = d2;
+      s.nearest[seed->cell] = (int32_t)i;
+    }
+  }
+  for (uint32_t i = 0; i < cells; i++) {
+    if (s.nearest[i] >= 0) CellList_push(&field->border, i);
+  }
+  CellList_shrink(&field->border);
+
+  for (int pass = 0; pass < FIELD_MAX_PASSES; pass++) {
+    s.changed = false;
+    sweep(&s);
+    if (!s.changed) break;
+  }
+
+  // Chord to great-circle kilometres
+  field->km = memAlloc(MEM_TAG_FIELDS, cells * sizeof(uint16_t));
+  for (uint32_t i = 0; i < cells; i++) {
+    float half = fminf(sqrtf(s.best[i]) * 0.5f, 1.0f);
+    float km = 2.0f * asinf(half) * (float)GEO_EARTH_RADIUS_KM;
+    field->km[i] = km > 65535.0f ? 65535 : (uint16_t)(km + 0.5f);
+  }
+
+  memFree(s.nearest);
+  memFree(s.best);
+  SeedArray_free(&seeds);
+}
+
+void freeCountryField(CountryField *field) {
+  memFree(field->km);
+  field->km = NULL;
+  CellList_free(&field->border);
+}
+
+uint64_t countryFieldBytes(const FieldGrid *grid, const CountryField *field) {
+  uint64_t bytes = CellList_heapBytes(&field->border, NULL);
+  if (field->km) {
+    bytes += (uint64_t)fieldCellCount(grid) * sizeof(uint16_t);
+  }
+  return bytes;
+}
+
+float fieldBorderDistance(const CountryField *a, const CellList *bBorder) {
+  if (!a->km || bBorder->size == 0) {
+    return 0.0f;
+  }
+  const uint32_t *cells = CellList_data(bBorder);
+  uint16_t best = UINT16_MAX;
+  for (uint32_t i = 0; i < bBorder->size; i++) {
+    uint16_t km = a->km[cells[i]];
+    if (km < best) best = km;
+  }
+  return (float)best;
+}
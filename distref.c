@@ -0,0 +1,186 @@
+#include "distref.h"
+#include "geomath.h"
+#include <math.h>
+
+#define REF_BLOCK_ARCS 32  // Arcs per bounding cap
+#define REF_DEG_TO_RAD (3.14159265358979323846 / 180.0)
+
+static inline RefVec refVec(double lat, double lon) {
+  double latRad = lat * REF_DEG_TO_RAD;
+  double lonRad = lon * REF_DEG_TO_RAD;
+  return (RefVec){cos(latRad) * cos(lonRad), cos(latRad) * sin(lonRad), sin(latRad)};
+}
+
+static inline double refDot(RefVec a, RefVec b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline RefVec refCross(RefVec a, RefVec b) {
+  return (RefVec){a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+static inline double refLength(RefVec a) {
+  return sqrt(refDot(a, a));
+}
+
+// Angle between unit vectors; atan2 keeps it exact near 0 and pi
+static inline double refAngle(RefVec a, RefVec b) {
+  return atan2(refLength(refCross(a, b)), refDot(a, b));
+}
+
+// p lies on the arc's great circle: is it between the endpoints?
+static inline bool refWithinArc(RefVec p, const RefArc *arc) {
+  return refDot(refCross(arc->a, p), arc->n) >= 0.0 &&
+         refDot(refCross(p, arc->b), arc->n) >= 0.0;
+}
+
+static double pointArcAngle(RefVec p, const RefArc *arc) {
+  // Nearest point of the great circle is p with its normal component removed
+  double offset = refDot(p, arc->n);
+  RefVec foot = {p.x - offset * arc->n.x, p.y - offset * arc->n.y, p.z - offset * arc->n.z};
+  if (refLength(foot) > 1e-15 && refWithinArc(foot, arc)) {
+    return asin(fmin(fabs(offset), 1.0));
+  }
+  return fmin(refAngle(p, arc->a), refAngle(p, arc->b));
+}
+
+static bool arcsCross(const RefArc *p, const RefArc *q) {
+  RefVec line = refCross(p->n, q->n);
+  double length = refLength(line);
+  if (length < 1e-15) return false;  // Same circle: overlap shows up as 0 below
+  line = (RefVec){line.x / length, line.y / length, line.z / length};
+  if (refWithinArc(line, p) && refWithinArc(line, q)) return true;
+  line = (RefVec){-line.x, -line.y, -line.z};
+  return refWithinArc(line, p) && refWithinArc(line, q);
+}
+
+static double arcArcAngle(const RefArc *p, const RefArc *q) {
+  if (arcsCross(p, q)) return 0.0;
+  double best = pointArcAngle(p->a, q);
+  best = fmin(best, pointArcAngle(p->b, q));
+  best = fmin(best, pointArcAngle(q->a, p));
+  return fmin(best, pointArcAngle(q->b, p));
+}
+
+static void addArc(RefShape *shape, RefVec a, RefVec b) {
+  RefVec n = refCross(a, b);
+  double length = refLength(n);
+  if (length < 1e-15) return;  // Repeated vertex
+  RefArcArray_push(&shape->arcs, (RefArc){a, b, {n.x / length, n.y / length, n.z / length}});
+}
+
+static void closeBlock(RefShape *shape, uint32_t first) {
+  uint32_t count = (uint32_t)shape->arcs.size - first;
+  if (count == 0) return;
+  const RefArc *arcs = RefArcArray_data(&shape->arcs) + first;
+
+  RefVec sum = {0, 0, 0};
+  for (uint32_t i = 0; i < count; i++) {
+    sum.x += arcs[i].a.x + arcs[i].b.x;
+    sum.y += arcs[i].a.y + arcs[i].b.y;
+    sum.z += arcs[i].a.z + arcs[i].b.z;
+  }
+  double length = refLength(sum);
+  RefVec center = length > 1e-15 ? (RefVec){sum.x / length, sum.y / length, sum.z / length}
+                                 : arcs[0].a;
+
+  // An arc can bow out of the cap holding its endpoints by at most half its
+  // length, so pad the radius by that much
+  double radius = 0.0;
+  for (uint32_t i = 0; i < count; i++) {
+    double bulge = 0.5 * refAngle(arcs[i].a, arcs[i].b);
+    radius = fmax(radius, refAngle(center, arcs[i].a) + bulge);
+    radius = fmax(radius, refAngle(center, arcs[i].b) + bulge);
+  }
+  RefBlockArray_push(&shape->blocks, (RefBlock){center, radius, first, count});
+}
+
+void buildRefShape(const CountryData *country, RefShape *shape) {
+  RefArcArray_init(&shape->arcs);
+  RefBlockArray_init(&shape->blocks);
+
+  Polygon **rings = countryPolygons(country);
+  uint32_t ringCount = countryRingCount(country);
+  uint32_t blockStart = 0;
+  for (uint32_t r = 0; r < ringCount; r++) {
+    uint64_t n = polygonPointCount(rings[r]);
+    if (n < 2) continue;
+    for (uint64_t i = 0; i < n; i++) {
+      // Closing segment included, as the game's engine walks it too
+      GeoPoint p1 = polygonPoint(rings[r], i);
+      GeoPoint p2 = polygonPoint(rings[r], (i + 1) % n);
+      double dLat = (double)p2.lat - p1.lat;
+      double dLon = (double)p2.lon - p1.lon;
+      double span = fmax(fabs(dLat), fabs(dLon));
+      uint32_t steps = (uint32_t)ceil(span / REF_STEP_DEGREES);
+      if (steps == 0) steps = 1;
+
+      RefVec prev = refVec(p1.lat, p1.lon);
+      for (uint32_t s = 1; s <= steps; s++) {
+        double t = (double)s / steps;
+        RefVec next = refVec(p1.lat + dLat * t, p1.lon + dLon * t);
+        addArc(shape, prev, next);
+        prev = next;
+        if (shape->arcs.size - blockStart == REF_BLOCK_ARCS) {
+          closeBlock(shape, blockStart);
+          blockStart = (uint32_t)shape->arcs.size;
+        }
+      }
+    }
+    // Blocks never straddle rings, which keeps their caps tight
+    closeBlock(shape, blockStart);
+    blockStart = (uint32_t)shape->arcs.size;
+  }
+}
+
+void freeRefShape(RefShape *shape) {
+  RefArcArray_free(&shape->arcs);
+  RefBlockArray_free(&shape->blocks);
+}
+
+double refBorderDistanceKm(const RefShape *a, const RefShape *b) {
+  const RefBlock *blocksA = RefBlockArray_data(&a->blocks);
+  const RefBlock *blocksB = RefBlockArray_data(&b->blocks);
+  const RefArc *arcsA = RefArcArray_data(&a->arcs);
+  const RefArc *arcsB = RefArcArray_data(&b->arcs);
+  uint64_t countA = a->blocks.size;
+  uint64_t countB = b->blocks.size;
+  if (countA == 0 || countB == 0) return 0.0;
+
+  // Any pair of caps bounds the answer from above; start from the tightest
+  double best = INFINITY;
+  for (uint64_t i = 0; i < countA; i++) {
+    for (uint64_t j = 0; j < countB; j++) {
+      double gap = refAngle(blocksA[i].center, blocksB[j].center);
+      best = fmin(best, gap + blocksA[i].radius + blocksB[j].radius);
+    }
+  }
+
+  for (uint64_t i = 0; i < countA; i++) {
+    const RefBlock *blockA = &blocksA[i];
+    for (uint64_t j = 0; j < countB; j++) {
+      const RefBlock *blockB = &blocksB[j];
+      double gap = refAngle(blockA->center, blockB->center);
+      if (gap - blockA->radius - blockB->radius >= best) continue;
+
+      for (uint32_t p = 0; p < blockA->count; p++) {
+        const RefArc *arcA = &arcsA[blockA->first + p];
+        for (uint32_t q = 0; q < blockB->count; q++) {
+          best = fmin(best, arcArcAngle(arcA, &arcsB[blockB->first + q]));
+        }
+      }
+      if (best == 0.0) return 0.0;
+    }
+  }
+  return best * GEO_EARTH_RADIUS_KM;
+}
+
+double refCentroidDistanceKm(GeoPoint a, GeoPoint b) {
+  double lat1 = a.lat * REF_DEG_TO_RAD;
+  double lat2 = b.lat * REF_DEG_TO_RAD;
+  double dLon = ((double)b.lon - a.lon) * REF_DEG_TO_RAD;
+  double y1 = cos(lat2) * sin(dLon);
+  double y2 = cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(dLon);
+  double x = sin(lat1) * sin(lat2) + cos(lat1) * cos(lat2) * cos(dLon);
+  return atan2(sqrt(y1 * y1 + y2 * y2), x) * GEO_EARTH_RADIUS_KM;
+}
@@ -0,0 +1,54 @@
+#ifndef DISTREF_H
+#define DISTREF_H
+
+#include "geodata.h"
+#include "array.h"
+#include <stdint.h>
+
+// Reference distances for validating the faster engines (distbatch
+// --validate). Everything is double precision and nothing is sampled:
+// border segments are split into lat/lon steps of at most REF_STEP_DEGREES
+// (the game walks segments linearly in lat/lon), each step is treated as a
+// great-circle arc, and the border distance is the exact minimum over every
+// pair of arcs, zero where two arcs cross. Arcs are grouped into blocks
+// under a bounding cap, and block pairs that can't beat the best distance so
+// far are skipped whole.
+
+#define REF_STEP_DEGREES 0.05  // At most ~1 m between the step and its arc
+
+typedef struct {
+  double x, y, z;
+} RefVec;
+
+typedef struct {
+  RefVec a, b;  // Unit vectors
+  RefVec n;     // Unit normal of the arc's great circle (a x b)
+} RefArc;
+
+typedef struct {
+  RefVec center;  // Unit vector
+  double radius;  // Angle covering every arc in the block
+  uint32_t first;
+  uint32_t count;
+} RefBlock;
+
+DEFINE_ARRAY(RefArcArray, RefArc, 1, MEM_TAG_GAME)
+DEFINE_ARRAY(RefBlockArray, RefBlock, 1, MEM_TAG_GAME)
+
+typedef struct {
+  RefArcArray arcs;
+  RefBlockArray blocks;
+} RefShape;
+
+// Densified arcs of every ring; build once per country, share across threads
+void buildRefShape(const CountryData *country, RefShape *shape);
+void freeRefShape(RefShape *shape);
+
+// Border-to-border km; 0 if either has no rings, like the game's engine
+double refBorderDistanceKm(const RefShape *a, const RefShape *b);
+
+// Centroid km by the atan2 form of the great-circle distance, which stays
+// accurate for nearby and antipodal points alike
+double refCentroidDistanceKm(GeoPoint a, GeoPoint b);
+
+#endif // DISTREF_H
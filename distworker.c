@@ -0,0 +1,182 @@
+#include "distworker.h"
+#include "game.h"
+#include "memtrack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Threads are available natively and in the -pthread web flavor
+#if !defined(PLATFORM_WEB) || defined(__EMSCRIPTEN_PTHREADS__)
+  #define DISTWORKER_THREADS 1
+  #include <pthread.h>
+#endif
+
+#define MAX_DISTANCE_WORKERS 8
+
+// Pending or finished job (singly linked FIFO)
+typedef struct DistanceJob {
+  uint32_t jobId;
+  CountryData *a;
+  CountryData *b;
+  float distance;
+  struct DistanceJob *next;
+} DistanceJob;
+
+typedef struct {
+  DistanceJob *head;
+  DistanceJob *tail;
+} JobQueue;
+
+static void queuePush(JobQueue *q, DistanceJob *job) {
+  job->next = NULL;
+  if (q->tail) {
+    q->tail->next = job;
+  } else {
+    q->head = job;
+  }
+  q->tail = job;
+}
+
+static DistanceJob *queuePop(JobQueue *q) {
+  DistanceJob *job = q->head;
+  if (job) {
+    q->head = job->next;
+    if (!q->head) q->tail = NULL;
+  }
+  return job;
+}
+
+static JobQueue pendingJobs;
+static JobQueue finishedJobs;
+static uint32_t nextJobId = 1;
+static uint32_t outstanding = 0;  // Submitted but not yet collected
+static bool running = false;
+
+#ifdef DISTWORKER_THREADS
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueReady = PTHREAD_COND_INITIALIZER;
+static pthread_t workers[MAX_DISTANCE_WORKERS];
+static int workerCount = 0;
+static bool stopping = false;
+
+static void *workerMain(void *arg) {
+  for (;;) {
+    pthread_mutex_lock(&queueLock);
+    while (!pendingJobs.head && !stopping) {
+      pthread_cond_wait(&queueReady, &queueLock);
+    }
+    if (stopping) {
+      pthread_mutex_unlock(&queueLock);
+      return NULL;
+    }
+    DistanceJob *job = queuePop(&pendingJobs);
+    pthread_mutex_unlock(&queueLock);
+
+    // Geometry is read-only once loaded, so no lock is held while computing
+    job->distance = calculateBorderToBorderDistance(job->a, job->b);
+
+    pthread_mutex_lock(&queueLock);
+    queuePush(&finishedJobs, job);
+    pthread_mutex_unlock(&queueLock);
+  }
+}
+#endif
+
+bool startDistanceWorkers(int threadCount) {
+#ifdef DISTWORKER_THREADS
+  if (running) return true;
+  if (threadCount < 1) threadCount = 1;
+  if (threadCount > MAX_DISTANCE_WORKERS) threadCount = MAX_DISTANCE_WORKERS;
+
+  stopping = false;
+  for (workerCount = 0; workerCount < threadCount; workerCount++) {
+    if (pthread_create(&workers[workerCount], NULL, workerMain, NULL) != 0) {
+      break;
+    }
+  }
+  running = workerCount > 0;
+  if (running) {
+    printf("Started %d distance worker(s)\n", workerCount);
+  }
+  return running;
+#else
+  return false;
+#endif
+}
+
+void stopDistanceWorkers(void) {
+#ifdef DISTWORKER_THREADS
+  if (running) {
+    pthread_mutex_lock(&queueLock);
+    stopping = true;
+    pthread_cond_broadcast(&queueReady);
+    pthread_mutex_unlock(&queueLock);
+
+    for (int i = 0; i < workerCount; i++) {
+      pthread_join(workers[i], NULL);
+    }
+    workerCount = 0;
+    running = false;
+  }
+#endif
+
+  // Drop anything left over
+  DistanceJob *job;
+  while ((job = queuePop(&pendingJobs))) memFree(job);
+  while ((job = queuePop(&finishedJobs))) memFree(job);
+  outstanding = 0;
+}
+
+bool distanceWorkersRunning(void) {
+  return running;
+}
+
+uint32_t countOutstandingDistanceJobs(void) {
+  return outstanding;
+}
+
+uint32_t submitBorderDistanceJob(CountryData *a, CountryData *b) {
+  DistanceJob *job = memCalloc(MEM_TAG_GAME, 1, sizeof(DistanceJob));
+  job->a = a;
+  job->b = b;
+  outstanding++;
+
+#ifdef DISTWORKER_THREADS
+  if (running) {
+    pthread_mutex_lock(&queueLock);
+    job->jobId = nextJobId++;
+    queuePush(&pendingJobs, job);
+    pthread_cond_signal(&queueReady);
+    pthread_mutex_unlock(&queueLock);
+    return job->jobId;
+  }
+#endif
+
+  // No workers: compute now, deliver on the next collect
+  job->jobId = nextJobId++;
+  job->distance = calculateBorderToBorderDistance(a, b);
+  queuePush(&finishedJobs, job);
+  return job->jobId;
+}
+
+int collectDistanceResults(DistanceResult *out, int max) {
+  int count = 0;
+
+#ifdef DISTWORKER_THREADS
+  pthread_mutex_lock(&queueLock);
+#endif
+  while (count < max) {
+    DistanceJob *job = queuePop(&finishedJobs);
+    if (!job) break;
+    out[count].jobId = job->jobId;
+    out[count].distance = job->distance;
+    count++;
+    memFree(job);
+  }
+  outstanding -= (uint32_t)count;
+#ifdef DISTWORKER_THREADS
+  pthread_mutex_unlock(&queueLock);
+#endif
+
+  return count;
+}
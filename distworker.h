@@ -0,0 +1,33 @@
+#ifndef DISTWORKER_H
+#define DISTWORKER_H
+
+#include "geodata.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Background evaluation of border-to-border distances so large countries do
+// not stall the frame loop. Uses a pthread pool natively and in the -pthread
+// web build; the single-threaded web build computes jobs inline on submit,
+// so results still come back through collectDistanceResults.
+
+typedef struct {
+  uint32_t jobId;
+  float distance;  // Kilometers
+} DistanceResult;
+
+// Start the worker pool; returns false if threads are unavailable
+bool startDistanceWorkers(int threadCount);
+void stopDistanceWorkers(void);
+bool distanceWorkersRunning(void);
+
+// Queue calculateBorderToBorderDistance(a, b); returns a nonzero job id
+uint32_t submitBorderDistanceJob(CountryData *a, CountryData *b);
+
+// Drain up to max finished jobs into out; returns how many were written
+int collectDistanceResults(DistanceResult *out, int max);
+
+// Jobs submitted but not yet collected; while nonzero, workers may still be
+// reading the countries those jobs were given
+uint32_t countOutstandingDistanceJobs(void);
+
+#endif // DISTWORKER_H
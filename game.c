@@ -3,36 +3,33 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
-#define EARTH_RADIUS_KM 6371.0
+// raylib's GREEN and LIGHTGRAY, spelled out so headless builds need no raylib
+static const Color correctColor = {0, 228, 48, 255};
+static const Color pendingColor = {200, 200, 200, 255};
+
+static bool logging = true;
 
 // Haversine formula for great circle distance
+// Scored distances always use the exact (double) tier
 float calculateDistance(GeoPoint p1, GeoPoint p2) {
-  float lat1 = p1.lat * DEG2RAD;
-  float lon1 = p1.lon * DEG2RAD;
-  float lat2 = p2.lat * DEG2RAD;
-  float lon2 = p2.lon * DEG2RAD;
-
-  float dlat = lat2 - lat1;
-  float dlon = lon2 - lon1;
-
-  float a = sin(dlat / 2) * sin(dlat / 2) +
-            cos(lat1) * cos(lat2) * sin(dlon / 2) * sin(dlon / 2);
-
-  float c = 2 * atan2(sqrt(a), sqrt(1 - a));
-  float distance = EARTH_RADIUS_KM * c;
-
-  return distance;
+  return greatCircleKm(p1, p2, PRECISION_EXACT);
 }
 
 // Calculate minimum distance from a point to a line segment on a sphere
-float distanceToSegment(GeoPoint point, GeoPoint segStart, GeoPoint segEnd) {
+// Used for pruning, so samples are compared with the fast tier; the closest
+// sample is written to *closest for an exact distance afterwards
+static float distanceToSegment(GeoPoint point, GeoPoint segStart, GeoPoint segEnd,
+                               GeoPoint *closest) {
   // For simplicity, we'll sample points along the segment and find minimum distance
   // This is an approximation but works well for border detection
-  float minDist = calculateDistance(point, segStart);
-  float endDist = calculateDistance(point, segEnd);
-  if (endDist < minDist) minDist = endDist;
+  float minDist = greatCircleKm(point, segStart, PRECISION_FAST);
+  *closest = segStart;
+  float endDist = greatCircleKm(point, segEnd, PRECISION_FAST);
+  if (endDist < minDist) {
+    minDist = endDist;
+    *closest = segEnd;
+  }
 
   // Sample 20 points along the segment for better accuracy
   for (int i = 1; i < 20; i++) {
@@ -41,75 +38,104 @@ float distanceToSegment(GeoPoint point, GeoPoint segStart, GeoPoint segEnd) {
     samplePoint.lat = segStart.lat + t * (segEnd.lat - segStart.lat);
     samplePoint.lon = segStart.lon + t * (segEnd.lon - segStart.lon);
 
-    float dist = calculateDistance(point, samplePoint);
+    float dist = greatCircleKm(point, samplePoint, PRECISION_FAST);
     if (dist < minDist) {
       minDist = dist;
+      *closest = samplePoint;
     }
   }
 
   return minDist;
 }
 
+// A ring's vertices as floats, decoded once per distance query
+typedef struct {
+  const GeoPoint *points;
+  uint32_t count;
+  GeoPointArray scratch;
+} RingView;
+
 // Helper: One-directional border distance
 // Finds minimum distance from points in c1 to segments in c2
 static float minDistanceOneDirection(CountryData *c1, CountryData *c2) {
   float minDistance = 1000000.0f;  // Very large initial value
+  GeoPoint bestFrom = {0}, bestTo = {0};  // Closest pair found by the fast tier
+
+  // Resolve c2's rings up front so the inner loops are plain pointer walks
+  uint32_t ringCount2 = countryRingCount(c2);
+  Polygon **polys2 = countryPolygons(c2);
+  RingView *rings2 = memCalloc(MEM_TAG_GAME, ringCount2 ? ringCount2 : 1, sizeof(RingView));
+  for (uint32_t k = 0; k < ringCount2; k++) {
+    if (!polys2[k]) continue;
+    rings2[k].points = polygonPoints(polys2[k], &rings2[k].scratch);
+    rings2[k].count = (uint32_t)polygonPointCount(polys2[k]);
+  }
 
   // Check distance from each point in c1 to each segment in c2
-  for (uint64_t i = 0; i < c1->polygons->size; i++) {
-    Polygon **poly1Ptr = (Polygon **)c1->polygons->p + i;
-    Polygon *poly1 = *poly1Ptr;
-    if (!poly1 || !poly1->points) continue;
+  Polygon **polys1 = countryPolygons(c1);
+  for (uint32_t i = 0; i < countryRingCount(c1) && minDistance >= 5.0f; i++) {
+    Polygon *poly1 = polys1[i];
+    if (!poly1) continue;
+
+    GeoPointArray scratch1;
+    GeoPointArray_init(&scratch1);
+    const GeoPoint *points1 = polygonPoints(poly1, &scratch1);
+    uint64_t count1 = polygonPointCount(poly1);
 
     // For each point in polygon 1
-    for (uint64_t j = 0; j < poly1->points->size; j++) {
-      GeoPoint *p1 = (GeoPoint *)poly1->points->p + j;
+    for (uint64_t j = 0; j < count1 && minDistance >= 5.0f; j++) {
+      GeoPoint p1 = points1[j];
 
       // Check against all segments in country 2
-      for (uint64_t k = 0; k < c2->polygons->size; k++) {
-        Polygon **poly2Ptr = (Polygon **)c2->polygons->p + k;
-        Polygon *poly2 = *poly2Ptr;
-        if (!poly2 || !poly2->points || poly2->points->size < 2) continue;
-
-        // Check distance to each segment in polygon 2
-        for (uint64_t l = 0; l < poly2->points->size - 1; l++) {
-          GeoPoint *seg1 = (GeoPoint *)poly2->points->p + l;
-          GeoPoint *seg2 = (GeoPoint *)poly2->points->p + l + 1;
-
-          float dist = distanceToSegment(*p1, *seg1, *seg2);
+      for (uint32_t k = 0; k < ringCount2 && minDistance >= 5.0f; k++) {
+        const GeoPoint *seg = rings2[k].points;
+        uint32_t count2 = rings2[k].count;
+        if (count2 < 2) continue;
+
+        // Check distance to each segment in polygon 2, then the closing one
+        // Early exit: if we find points within 5km, that's close enough
+        const GeoPoint *end = seg + count2 - 1;
+        for (; seg < end; seg++) {
+          GeoPoint closest;
+          float dist = distanceToSegment(p1, seg[0], seg[1], &closest);
           if (dist < minDistance) {
             minDistance = dist;
-
-            // Early exit: if we find points within 5km, that's close enough
-            if (minDistance < 5.0f) {
-              return minDistance;
-            }
+            bestFrom = p1;
+            bestTo = closest;
+            if (minDistance < 5.0f) break;
           }
         }
-
-        // Check closing segment
-        if (poly2->points->size > 2) {
-          GeoPoint *first = (GeoPoint *)poly2->points->p;
-          GeoPoint *last = (GeoPoint *)poly2->points->p + (poly2->points->size - 1);
-          float dist = distanceToSegment(*p1, *last, *first);
+        if (count2 > 2 && minDistance >= 5.0f) {
+          GeoPoint closest;
+          float dist = distanceToSegment(p1, rings2[k].points[count2 - 1],
+                                         rings2[k].points[0], &closest);
           if (dist < minDistance) {
             minDistance = dist;
-            if (minDistance < 5.0f) {
-              return minDistance;
-            }
+            bestFrom = p1;
+            bestTo = closest;
           }
         }
       }
     }
+    GeoPointArray_free(&scratch1);
   }
 
+  for (uint32_t k = 0; k < ringCount2; k++) {
+    GeoPointArray_free(&rings2[k].scratch);
+  }
+  memFree(rings2);
+
+  // Score the winning pair with the exact tier
+  if (minDistance < 1000000.0f) {
+    minDistance = calculateDistance(bestFrom, bestTo);
+  }
   return minDistance;
 }
 
 // Border-to-border distance calculation (bidirectional)
 // Finds minimum distance between borders of two countries
 float calculateBorderToBorderDistance(CountryData *c1, CountryData *c2) {
-  if (!c1 || !c2 || !c1->polygons || !c2->polygons) {
+  if (!c1 || !c2 || countryRingCount(c1) == 0 || countryRingCount(c2) == 0) {
     return 0.0f;
   }
 
@@ -127,10 +153,21 @@ float calculateBorderToBorderDistance(CountryData *c1, CountryData *c2) {
   return (dist1 < dist2) ? dist1 : dist2;
 }
 
+int getColorBucket(float distance, float maxDistance) {
+  if (distance < 1.0f) return 0;
+  float t = distance / maxDistance;
+  if (t > 0.8f) return 5;
+  if (t > 0.6f) return 4;
+  if (t > 0.4f) return 3;
+  if (t > 0.2f) return 2;
+  return 1;
+}
+
 // Color gradient: white -> blue -> yellow -> orange -> red -> green (for correct)
 Color getColorForDistance(float distance, float maxDistance) {
-  if (distance < 1.0f) {
-    return GREEN; // Correct!
+  int bucket = getColorBucket(distance, maxDistance);
+  if (bucket == 0) {
+    return correctColor; // Correct!
   }
 
   // Normalize distance to 0-1 range
@@ -146,7 +183,7 @@ Color getColorForDistance(float distance, float maxDistance) {
   Color red = {220, 20, 60, 255};       // Crimson
 
   // 5 segments: white->blue->yellow->orange->red
-  if (t > 0.8f) {
+  if (bucket == 5) {
     // Far away: white to light blue
     float segment = (t - 0.8f) / 0.2f;
     return (Color){
@@ -155,7 +192,7 @@ Color getColorForDistance(float distance, float maxDistance) {
       (uint8_t)(white.b + (blue.b - white.b) * (1 - segment)),
       255
     };
-  } else if (t > 0.6f) {
+  } else if (bucket == 4) {
     // Blue to yellow
     float segment = (t - 0.6f) / 0.2f;
     return (Color){
@@ -164,7 +201,7 @@ Color getColorForDistance(float distance, float maxDistance) {
       (uint8_t)(yellow.b + (blue.b - yellow.b) * segment),
       255
     };
-  } else if (t > 0.4f) {
+  } else if (bucket == 3) {
     // Yellow to orange
     float segment = (t - 0.4f) / 0.2f;
     return (Color){
@@ -173,7 +210,7 @@ Color getColorForDistance(float distance, float maxDistance) {
       (uint8_t)(orange.b + (yellow.b - orange.b) * segment),
       255
     };
-  } else if (t > 0.2f) {
+  } else if (bucket == 2) {
     // Orange to red
     float segment = (t - 0.2f) / 0.2f;
     return (Color){
@@ -205,20 +242,43 @@ void initGame(GameState *game, CountryDatabase *db) {
   memset(game->guesses, 0, sizeof(game->guesses));
 }
 
+// Seed the mystery country picker once per session (recorded for replays)
+void seedGameRandom(uint32_t seed) {
+  srand(seed);
+}
+
 // Select random mystery country
 void selectRandomMysteryCountry(GameState *game) {
   if (!game->db || game->db->count == 0) {
     return;
   }
 
-  srand(time(NULL));
   uint64_t randomIndex = rand() % game->db->count;
   game->mysteryCountry = &game->db->countries[randomIndex];
 
-  printf("Mystery country selected: %s (at %.2f, %.2f)\n",
-         game->mysteryCountry->englishName,
-         game->mysteryCountry->centroid.lat,
-         game->mysteryCountry->centroid.lon);
+  if (logging) {
+    printf("Mystery country selected: %s (at %.2f, %.2f)\n",
+           game->mysteryCountry->englishName,
+           game->mysteryCountry->centroid.lat,
+           game->mysteryCountry->centroid.lon);
+  }
+}
+
+// Select the mystery country from a seed (splitmix64 finalizer)
+void selectSeededMysteryCountry(GameState *game, uint32_t seed) {
+  if (!game->db || game->db->count == 0) {
+    return;
+  }
+
+  uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  z ^= z >> 31;
+  game->mysteryCountry = &game->db->countries[z % game->db->count];
+}
+
+void setGameLogging(bool enabled) {
+  logging = enabled;
 }
 
 // Check if country has already been guessed
@@ -238,26 +298,39 @@ void updateClosestGuess(GameState *game) {
     return;
   }
 
-  float minDistance = game->guesses[0].distance;
-  game->closestGuessIndex = 0;
+  float minDistance = 0.0f;
+  game->closestGuessIndex = -1;
 
-  for (int i = 1; i < game->guessCount; i++) {
-    if (game->guesses[i].distance < minDistance) {
+  // Pending guesses have no distance yet
+  for (int i = 0; i < game->guessCount; i++) {
+    if (game->guesses[i].pending) {
+      continue;
+    }
+    if (game->closestGuessIndex < 0 || game->guesses[i].distance < minDistance) {
       minDistance = game->guesses[i].distance;
       game->closestGuessIndex = i;
     }
   }
 }
 
-// Make a guess
-bool makeGuess(GameState *game, CountryData *country) {
+// Check whether a country can be guessed right now
+static bool canGuess(GameState *game, CountryData *country) {
   if (!country || !game->mysteryCountry || game->won) {
     return false;
   }
 
   // Check if already guessed
   if (hasGuessed(game, country)) {
-    printf("Already guessed: %s\n", country->englishName);
+    if (logging) printf("Already guessed: %s\n", country->englishName);
+    return false;
+  }
+
+  return true;
+}
+
+// Make a guess
+bool makeGuess(GameState *game, CountryData *country) {
+  if (!canGuess(game, country)) {
     return false;
   }
 
@@ -275,14 +348,15 @@ bool makeGuess(GameState *game, CountryData *country) {
   }
 
   // Maximum possible distance on Earth is ~20,000 km (half circumference)
-  float maxDistance = 20000.0f;
-  Color color = getColorForDistance(distance, maxDistance);
+  Color color = getColorForDistance(distance, MAX_DISTANCE_KM);
 
   // Add guess
   if (game->guessCount < MAX_GUESSES) {
     game->guesses[game->guessCount].country = country;
     game->guesses[game->guessCount].distance = distance;
     game->guesses[game->guessCount].color = color;
+    game->guesses[game->guessCount].pending = false;
+    game->guesses[game->guessCount].jobId = 0;
     game->guessCount++;
   }
 
@@ -292,9 +366,11 @@ bool makeGuess(GameState *game, CountryData *country) {
   // Check if won
   if (country == game->mysteryCountry) {
     game->won = true;
-    printf("Congratulations! You found %s in %d guesses!\n",
-           game->mysteryCountry->englishName, game->guessCount);
-  } else {
+    if (logging) {
+      printf("Congratulations! You found %s in %d guesses!\n",
+             game->mysteryCountry->englishName, game->guessCount);
+    }
+  } else if (logging) {
     printf("Guessed: %s - Distance: %.0f km\n",
            country->englishName, distance);
   }
@@ -302,6 +378,56 @@ bool makeGuess(GameState *game, CountryData *country) {
   return true;
 }
 
+// Record a guess whose distance is being computed elsewhere (see distworker.h)
+// The mystery country itself is never pending, so winning is still immediate
+bool makePendingGuess(GameState *game, CountryData *country, uint32_t jobId) {
+  if (!canGuess(game, country) || country == game->mysteryCountry) {
+    return false;
+  }
+  if (game->guessCount >= MAX_GUESSES) {
+    return false;
+  }
+
+  Guess *guess = &game->guesses[game->guessCount++];
+  guess->country = country;
+  guess->distance = 0.0f;
+  guess->color = pendingColor;
+  guess->pending = true;
+  guess->jobId = jobId;
+
+  if (logging) printf("Guessed: %s - Distance pending\n", country->englishName);
+  return true;
+}
+
+// Fill in a pending guess once its distance is known
+// Returns false if no guess is waiting on jobId (e.g. the game was restarted)
+bool resolvePendingGuess(GameState *game, uint32_t jobId, float distance) {
+  for (int i = 0; i < game->guessCount; i++) {
+    Guess *guess = &game->guesses[i];
+    if (guess->pending && guess->jobId == jobId) {
+      guess->distance = distance;
+      guess->color = getColorForDistance(distance, MAX_DISTANCE_KM);
+      guess->pending = false;
+      updateClosestGuess(game);
+      if (logging) {
+        printf("Guessed: %s - Distance: %.0f km\n", guess->country->englishName,
+               distance);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool hasPendingGuesses(GameState *game) {
+  for (int i = 0; i < game->guessCount; i++) {
+    if (game->guesses[i].pending) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // Calculate final score based on guesses, distance, and time
 // Higher score is better (max 10000 points)
 int calculateScore(GameState *game) {
@@ -2,11 +2,23 @@
 #define GAME_H
 
 #include "geodata.h"
-#include "raylib/src/raylib.h"
+#include "geomath.h"
+
+// The game logic only needs raylib's Color layout. Headless builds (the
+// server) define GLOBLE_HEADLESS and get the same struct without raylib.
+#ifdef GLOBLE_HEADLESS
+  #if !defined(RL_COLOR_TYPE)
+    typedef struct Color { unsigned char r, g, b, a; } Color;
+    #define RL_COLOR_TYPE
+  #endif
+#else
+  #include "raylib/src/raylib.h"
+#endif
 #include <stdbool.h>
 #include <stdint.h>
 
 #define MAX_GUESSES 500
+#define MAX_DISTANCE_KM 20000.0f  // Half the Earth's circumference
 
 // Distance calculation modes
 typedef enum {
@@ -20,6 +32,8 @@ typedef struct {
   CountryData *country;
   float distance; // Distance in kilometers
   Color color;    // Color based on distance
+  bool pending;   // Distance still being computed on a worker
+  uint32_t jobId; // Worker job that will resolve a pending guess
 } Guess;
 
 // Game state
@@ -47,11 +61,22 @@ float calculateBorderToBorderDistance(CountryData *c1, CountryData *c2);
 
 // Color calculation based on distance
 Color getColorForDistance(float distance, float maxDistance);
+// Band of the gradient a distance falls in: 0 correct, then 1 (closest, red)
+// to 5 (farthest, white-blue). Two distances in one band get nearby colors.
+int getColorBucket(float distance, float maxDistance);
 
 // Game functions
 void initGame(GameState *game, CountryDatabase *db);
+void seedGameRandom(uint32_t seed);
 void selectRandomMysteryCountry(GameState *game);
+// Same seed, same country; uses no shared state, so sessions can pick
+// concurrently (the server seeds with the day number for a daily puzzle)
+void selectSeededMysteryCountry(GameState *game, uint32_t seed);
+void setGameLogging(bool enabled);  // Per-guess messages on stdout (default on)
 bool makeGuess(GameState *game, CountryData *country);
+bool makePendingGuess(GameState *game, CountryData *country, uint32_t jobId);
+bool resolvePendingGuess(GameState *game, uint32_t jobId, float distance);
+bool hasPendingGuesses(GameState *game);
 bool hasGuessed(GameState *game, CountryData *country);
 void updateClosestGuess(GameState *game);
 int calculateScore(GameState *game);
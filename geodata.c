@@ -3,38 +3,40 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+
+#ifdef GEODATA_EMBEDDED
+  #include "geoembed.h"
+#endif
+
+// Threads are available natively and in the -pthread web flavor
+#if !defined(PLATFORM_WEB) || defined(__EMSCRIPTEN_PTHREADS__)
+  #define GEODATA_THREADS 1
+  #include <pthread.h>
+#endif
 
 #define COORDINATES_FILE_SIZE (9 * 1000 * 1000 * 1000ll)
+#define GEO_PI 3.14159265358979323846
+#define METERS_PER_DEGREE 111320.0
+#define QUANT_STEPS 65535
+#define CSV_COLUMNS 10  // Including French Name, which is skipped
 
-// Vector functions
-vec *vec_init(uint64_t item_size, uint64_t capacity) {
-  vec *v = calloc(sizeof(vec), 1);
-  v->size = 0;
-  v->itemSize = item_size;
-  v->capacity = capacity;
-  v->p = calloc(capacity, item_size);
-  return v;
-}
+static bool quantizeGeometry = false;
 
-void vec_append(vec *vec, void *item) {
-  if (vec->size >= vec->capacity) {
-    // Grow capacity
-    vec->capacity *= 2;
-    vec->p = realloc(vec->p, vec->capacity * vec->itemSize);
-  }
-  memcpy(vec->p + (vec->size * vec->itemSize), item, vec->itemSize);
-  vec->size += 1;
-}
+#ifdef GEODATA_THREADS
+static pthread_mutex_t decodeLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t prefetchThread;
+static bool prefetchStarted = false;
+#endif
+static const CountryDatabase *prefetchDb = NULL;
+static CountryData *prefetchList;  // prefetchDb's countries
+static uint64_t prefetchCount;
+static atomic_bool prefetchStop;
+static atomic_bool prefetchDone;
 
-void vec_free(vec *v) {
-  if (v) {
-    free(v->p);
-    free(v);
-  }
-}
 
 // File loading
-static char *loadFile(const char *path) {
+char *loadCsvFile(const char *path) {
   FILE *p = fopen(path, "r");
   if (!p) {
     fprintf(stderr, "Error: Could not open file %s\n", path);
@@ -46,17 +48,19 @@ static char *loadFile(const char *path) {
   long fileSize = ftell(p);
   fseek(p, 0, SEEK_SET);
 
-  char *buffer = (char *)malloc(fileSize + 1);
+  char *buffer = (char *)memAlloc(MEM_TAG_PARSE, fileSize + 1);
   size_t bytesRead = fread(buffer, 1, fileSize, p);
   buffer[bytesRead] = '\0';
   fclose(p);
   return buffer;
 }
 
+static int skipColumn(int start, const char *fileData);
+
 // CSV parsing helpers
 static char *readColumn(int *start, char *fileData) {
-  // Increased buffer size to handle large geoshape data (Indonesia has ~400KB!)
-  char *b = malloc(500000);  // Increased to handle Indonesia's massive geoshape
+  // Unescaping only shrinks a field, so its raw span bounds the copy
+  char *b = memAlloc(MEM_TAG_STRINGS, skipColumn(*start, fileData) - *start + 1);
   int idx = 0;
   int fieldStartsWithQuote = 0;
 
@@ -101,6 +105,33 @@ static char *readColumn(int *start, char *fileData) {
   return b;
 }
 
+// Same walk as readColumn without copying the field
+static int skipColumn(int start, const char *fileData) {
+  bool quoted = fileData[start] == '"';
+  if (quoted) start++;
+
+  while (fileData[start] != '\0') {
+    char c = fileData[start];
+    if (quoted && c == '"') {
+      if (fileData[start + 1] == '"') {
+        start += 2;
+        continue;
+      }
+      start++;
+      break;
+    }
+    if (!quoted && (c == ';' || c == '\n')) {
+      break;
+    }
+    start++;
+  }
+
+  if (fileData[start] == ';' || fileData[start] == '\n') {
+    start++;
+  }
+  return start;
+}
+
 static int isNum(char c) {
   // Only digits start numbers reliably; '-' and '.' alone can cause issues
   return ('0' <= c && c <= '9') || c == '-';
@@ -109,7 +140,7 @@ static int isNum(char c) {
 static Polygon *parsePolygon(char *shape, char **endptr) {
   // Use heap allocation for large arrays to avoid stack overflow
   // Indonesia has extremely detailed coastlines requiring huge buffer
-  double *arr = malloc(sizeof(double) * 50000000);
+  double *arr = memAlloc(MEM_TAG_PARSE, sizeof(double) * 50000000);
   int cnt = 0;
 
   while (*shape != '\0' && cnt < 50000000) {
@@ -153,28 +184,200 @@ static Polygon *parsePolygon(char *shape, char **endptr) {
 
   *endptr = shape;
 
-  Polygon *poly = malloc(sizeof(Polygon));
-  poly->points = vec_init(sizeof(GeoPoint), cnt / 2 + 1);
+  Polygon *poly = createPolygon(cnt / 2);
 
   // Parse as [lon, lat] pairs
   for (int i = 0; i < cnt; i += 2) {
     GeoPoint p;
     p.lon = arr[i];      // First value is longitude
     p.lat = arr[i + 1];  // Second value is latitude
-    vec_append(poly->points, &p);
+    GeoPointArray_push(&poly->points, p);
+  }
+
+  memFree(arr);  // Free the temporary array
+  finishPolygon(poly);
+  return poly;
+}
+
+// Compute the bounding cap and lat/lon box of a ring from its points
+// Cap center is the normalized mean of the unit vectors; radius is the
+// largest angle from it to any vertex
+void computePolygonBounds(Polygon *poly) {
+  poly->capCenter.lat = 0.0f;
+  poly->capCenter.lon = 0.0f;
+  poly->capRadius = 0.0f;
+  uint64_t count = polygonPointCount(poly);
+  if (count == 0) {
+    poly->boxMin = poly->boxMax = (GeoPoint){0.0f, 0.0f};
+    return;
+  }
+
+  // Decode before touching the box: quantized points are relative to it
+  GeoPoint first = polygonPoint(poly, 0);
+  GeoPoint boxMin = first, boxMax = first;
+  double sx = 0.0, sy = 0.0, sz = 0.0;
+  for (uint64_t i = 0; i < count; i++) {
+    GeoPoint pt = polygonPoint(poly, i);
+    if (pt.lat < boxMin.lat) boxMin.lat = pt.lat;
+    if (pt.lat > boxMax.lat) boxMax.lat = pt.lat;
+    if (pt.lon < boxMin.lon) boxMin.lon = pt.lon;
+    if (pt.lon > boxMax.lon) boxMax.lon = pt.lon;
+
+    double lat = pt.lat * GEO_PI / 180.0;
+    double lon = pt.lon * GEO_PI / 180.0;
+    sx += cos(lat) * cos(lon);
+    sy += cos(lat) * sin(lon);
+    sz += sin(lat);
+  }
+
+  double len = sqrt(sx * sx + sy * sy + sz * sz);
+  if (len < 1e-9) {
+    // Degenerate (points spread evenly around the globe): cover everything
+    if (!poly->quantized) {
+      poly->boxMin = boxMin;
+      poly->boxMax = boxMax;
+    }
+    poly->capCenter = first;
+    poly->capRadius = (float)GEO_PI;
+    return;
   }
+  sx /= len;
+  sy /= len;
+  sz /= len;
+
+  double minDot = 1.0;
+  for (uint64_t i = 0; i < count; i++) {
+    GeoPoint pt = polygonPoint(poly, i);
+    double lat = pt.lat * GEO_PI / 180.0;
+    double lon = pt.lon * GEO_PI / 180.0;
+    double dot = sx * cos(lat) * cos(lon) + sy * cos(lat) * sin(lon) + sz * sin(lat);
+    if (dot < minDot) minDot = dot;
+  }
+  if (minDot < -1.0) minDot = -1.0;
+
+  poly->capCenter.lat = (float)(asin(sz) * 180.0 / GEO_PI);
+  poly->capCenter.lon = (float)(atan2(sy, sx) * 180.0 / GEO_PI);
+  poly->capRadius = (float)acos(minDot) + 1e-4f;  // Margin for float rounding
+  if (!poly->quantized) {
+    poly->boxMin = boxMin;  // A quantized ring's box is its decode origin
+    poly->boxMax = boxMax;
+  }
+}
+
+void setGeometryQuantization(bool enabled) {
+  quantizeGeometry = enabled;
+}
+
+bool isGeometryQuantized(void) {
+  return quantizeGeometry;
+}
+
+// Replace a ring's float points with 16-bit steps across its bounding box
+static void quantizePolygon(Polygon *poly) {
+  if (poly->quantized) {
+    return;
+  }
+
+  uint32_t count = poly->points.size;
+  const GeoPoint *pts = GeoPointArray_data(&poly->points);
+  poly->qStep.lat = (poly->boxMax.lat - poly->boxMin.lat) / QUANT_STEPS;
+  poly->qStep.lon = (poly->boxMax.lon - poly->boxMin.lon) / QUANT_STEPS;
+
+  QuantPointArray_reserve(&poly->qpoints, count);
+  QuantPoint *out = QuantPointArray_data(&poly->qpoints);
+  for (uint32_t i = 0; i < count; i++) {
+    QuantPoint q = {0, 0};
+    if (poly->qStep.lat > 0.0f) {
+      q.lat = (uint16_t)lroundf((pts[i].lat - poly->boxMin.lat) / poly->qStep.lat);
+    }
+    if (poly->qStep.lon > 0.0f) {
+      q.lon = (uint16_t)lroundf((pts[i].lon - poly->boxMin.lon) / poly->qStep.lon);
+    }
+    out[i] = q;
+  }
+  poly->qpoints.size = count;
+
+  GeoPointArray_free(&poly->points);
+  poly->quantized = true;
+}
 
-  free(arr);  // Free the temporary array
+Polygon *createPolygon(uint32_t pointCapacity) {
+  Polygon *poly = memCalloc(MEM_TAG_GEOMETRY, 1, sizeof(Polygon));
+  GeoPointArray_reserve(&poly->points, pointCapacity);
   return poly;
 }
 
+void finishPolygon(Polygon *poly) {
+  GeoPointArray_shrink(&poly->points);
+  computePolygonBounds(poly);
+  if (quantizeGeometry) {
+    quantizePolygon(poly);
+  }
+}
+
+void freePolygon(Polygon *poly) {
+  if (!poly) return;
+  GeoPointArray_free(&poly->points);
+  QuantPointArray_free(&poly->qpoints);
+  memFree(poly);
+}
+
+const GeoPoint *polygonPoints(const Polygon *poly, GeoPointArray *scratch) {
+  if (!poly->quantized) {
+    return GeoPointArray_data(&poly->points);
+  }
+
+  uint32_t count = poly->qpoints.size;
+  GeoPointArray_reserve(scratch, count);
+  GeoPoint *out = GeoPointArray_data(scratch);
+  const QuantPoint *in = QuantPointArray_data(&poly->qpoints);
+  for (uint32_t i = 0; i < count; i++) {
+    out[i].lat = poly->boxMin.lat + in[i].lat * poly->qStep.lat;
+    out[i].lon = poly->boxMin.lon + in[i].lon * poly->qStep.lon;
+  }
+  scratch->size = count;
+  return out;
+}
+
+float polygonQuantizationError(const Polygon *poly) {
+  if (!poly->quantized) {
+    return 0.0f;
+  }
+  // Half a step per axis; a degree of longitude is at most a degree of latitude
+  double halfLat = poly->qStep.lat * 0.5 * METERS_PER_DEGREE;
+  double halfLon = poly->qStep.lon * 0.5 * METERS_PER_DEGREE;
+  return (float)sqrt(halfLat * halfLat + halfLon * halfLon);
+}
+
+void printGeometryQuantization(CountryDatabase *db) {
+  if (!db || !quantizeGeometry) {
+    return;
+  }
+
+  uint64_t points = 0;
+  float worst = 0.0f;
+  for (uint64_t i = 0; i < db->count; i++) {
+    CountryData *c = &db->countries[i];
+    Polygon **polys = countryPolygons(c);
+    for (uint32_t j = 0; j < countryRingCount(c); j++) {
+      Polygon *poly = polys[j];
+      points += polygonPointCount(poly);
+      float err = polygonQuantizationError(poly);
+      if (err > worst) worst = err;
+    }
+  }
+  printf("Quantized geometry: %llu points, %.1f KB saved, worst error %.1f m\n",
+         (unsigned long long)points,
+         points * (sizeof(GeoPoint) - sizeof(QuantPoint)) / 1024.0, worst);
+}
+
 static void parseGeoShape(char *shape, CountryData *d) {
   // After CSV unescaping, the format is: {"coordinates": ...}
   const char *prefix = "{\"coordinates\": ";
   int len = strlen(prefix);
   shape += len;
 
-  d->polygons = vec_init(sizeof(Polygon *), 100);
+  PolygonList_init(&d->polygons);
 
   while (*shape != '\0') {
     // Look for the start of a polygon: [[[ (but not [[[[)
@@ -206,11 +409,10 @@ static void parseGeoShape(char *shape, CountryData *d) {
 
     char *endptr;
     Polygon *p = parsePolygon(shape, &endptr);
-    if (p->points->size > 0) {
-      vec_append(d->polygons, &p);
+    if (polygonPointCount(p) > 0) {
+      PolygonList_push(&d->polygons, p);
     } else {
-      vec_free(p->points);
-      free(p);
+      freePolygon(p);
     }
     shape = endptr;
 
@@ -219,6 +421,73 @@ static void parseGeoShape(char *shape, CountryData *d) {
       break;
     }
   }
+  PolygonList_shrink(&d->polygons);
+}
+
+void decodeCountryGeometry(CountryData *country) {
+#ifdef GEODATA_THREADS
+  pthread_mutex_lock(&decodeLock);
+#endif
+  if (!atomic_load_explicit(&country->decoded, memory_order_relaxed)) {
+    if (country->geoShape) {
+      parseGeoShape(country->geoShape, country);
+      memFree(country->geoShape);  // The rings replace it
+      country->geoShape = NULL;
+    }
+    atomic_store_explicit(&country->decoded, true, memory_order_release);
+  }
+#ifdef GEODATA_THREADS
+  pthread_mutex_unlock(&decodeLock);
+#endif
+}
+
+// Geometry prefetch
+
+static void prefetchCountries(void) {
+  for (uint64_t i = 0; i < prefetchCount && !atomic_load(&prefetchStop); i++) {
+    ensureCountryGeometry(&prefetchList[i]);
+  }
+  atomic_store(&prefetchDone, true);
+}
+
+#ifdef GEODATA_THREADS
+static void *prefetchMain(void *arg) {
+  (void)arg;
+  prefetchCountries();
+  return NULL;
+}
+#endif
+
+void startGeometryPrefetch(CountryDatabase *db) {
+  stopGeometryPrefetch(prefetchDb);
+  atomic_store(&prefetchStop, false);
+  atomic_store(&prefetchDone, false);
+  prefetchDb = db;
+  prefetchList = db->countries;
+  prefetchCount = db->count;
+#ifdef GEODATA_THREADS
+  if (pthread_create(&prefetchThread, NULL, prefetchMain, NULL) == 0) {
+    prefetchStarted = true;
+    return;
+  }
+#endif
+  prefetchCountries();
+}
+
+bool isGeometryPrefetchRunning(void) {
+  return prefetchDb && !atomic_load(&prefetchDone);
+}
+
+void stopGeometryPrefetch(const CountryDatabase *db) {
+  if (!db || db != prefetchDb) return;
+  atomic_store(&prefetchStop, true);
+#ifdef GEODATA_THREADS
+  if (prefetchStarted) {
+    pthread_join(prefetchThread, NULL);
+    prefetchStarted = false;
+  }
+#endif
+  prefetchDb = NULL;
 }
 
 // Parse centroid from the Geo Point column (format: "lat, lon")
@@ -240,63 +509,79 @@ void calculateCentroid(CountryData *country) {
   }
 }
 
+// Offset of the row after the one at start
+int skipCountryRow(const char *fileData, int start) {
+  for (int col = 0; col < CSV_COLUMNS; col++) {
+    start = skipColumn(start, fileData);
+  }
+  return start;
+}
+
+// Parse the row at *start and advance past it; false (nothing kept) for the
+// header row and empty entries
+bool parseCountryRow(char *fileData, int *start, bool header, CountryData *out) {
+  CountryData d = {
+    .geoPoint = readColumn(start, fileData),
+    .geoShape = readColumn(start, fileData),
+    .territoryCode = readColumn(start, fileData),
+    .status = readColumn(start, fileData),
+    .countryCode = readColumn(start, fileData),
+    .englishName = readColumn(start, fileData),
+    .continent = readColumn(start, fileData),
+    .region = readColumn(start, fileData),
+    .alpha2 = readColumn(start, fileData),
+    .poly_count = 0
+  };
+
+  // Skip French Name column (last column in CSV)
+  char *frenchName = readColumn(start, fileData);
+  memFree(frenchName);
+
+  // Skip header row and empty entries
+  if (header || strlen(d.englishName) == 0 ||
+      strcmp(d.englishName, "English Name") == 0 ||
+      strcmp(d.englishName, "\"\"") == 0) {
+    freeCountryData(&d);
+    return false;
+  }
+
+  // Rings wait in geoShape until first use (decodeCountryGeometry)
+  calculateCentroid(&d);
+
+  // Validate centroid
+  if (d.centroid.lat == 0.0 && d.centroid.lon == 0.0) {
+    printf("Warning: Invalid centroid for %s\n", d.englishName);
+  }
+
+  *out = d;
+  return true;
+}
+
 // Load country database from CSV
 CountryDatabase *loadCountryDatabase(const char *csv_path) {
-  char *fileData = loadFile(csv_path);
+#ifdef GEODATA_EMBEDDED
+  (void)csv_path;
+  printf("Total countries loaded: %llu (embedded)\n",
+         (unsigned long long)embeddedCountryDatabase.count);
+  return (CountryDatabase *)&embeddedCountryDatabase;
+#endif
+  char *fileData = loadCsvFile(csv_path);
   if (!fileData) {
     return NULL;
   }
 
-  CountryDatabase *db = malloc(sizeof(CountryDatabase));
-  db->countries = malloc(sizeof(CountryData) * 300); // Pre-allocate for ~250 countries
+  CountryDatabase *db = memCalloc(MEM_TAG_DATABASE, 1, sizeof(CountryDatabase));
+  db->countries = memAlloc(MEM_TAG_DATABASE, sizeof(CountryData) * 300); // Pre-allocate for ~250 countries
   db->count = 0;
 
   int i = 0;
   int rowNum = 0;
 
   while (fileData[i] != '\0') {
-    CountryData d = {
-      .geoPoint = readColumn(&i, fileData),
-      .geoShape = readColumn(&i, fileData),
-      .territoryCode = readColumn(&i, fileData),
-      .status = readColumn(&i, fileData),
-      .countryCode = readColumn(&i, fileData),
-      .englishName = readColumn(&i, fileData),
-      .continent = readColumn(&i, fileData),
-      .region = readColumn(&i, fileData),
-      .alpha2 = readColumn(&i, fileData),
-      .poly_count = 0
-    };
-
-    // Skip French Name column (last column in CSV)
-    char *frenchName = readColumn(&i, fileData);
-    free(frenchName);
-
+    CountryData d;
     rowNum++;
-
-    // Skip header row and empty entries
-    if (rowNum == 1 || strlen(d.englishName) == 0 ||
-        strcmp(d.englishName, "English Name") == 0 ||
-        strcmp(d.englishName, "\"\"") == 0) {
-      free(d.geoPoint);
-      free(d.geoShape);
-      free(d.territoryCode);
-      free(d.status);
-      free(d.countryCode);
-      free(d.englishName);
-      free(d.continent);
-      free(d.region);
-      free(d.alpha2);
-      continue;
-    }
-
-    // Parse geographic data
-    parseGeoShape(d.geoShape, &d);
-    calculateCentroid(&d);
-
-    // Validate centroid
-    if (d.centroid.lat == 0.0 && d.centroid.lon == 0.0) {
-      printf("Warning: Invalid centroid for %s\n", d.englishName);
+    if (!parseCountryRow(fileData, &i, rowNum == 1, &d)) {
+      continue;  // Header row or empty entry
     }
 
     db->countries[db->count++] = d;
@@ -306,11 +591,75 @@ CountryDatabase *loadCountryDatabase(const char *csv_path) {
     }
   }
 
-  free(fileData);
+  memFree(fileData);
   printf("Total countries loaded: %llu\n", db->count);
   return db;
 }
 
+// Heap bytes behind a country's decoded geometry; unused capacity goes to *slack
+static uint64_t countryGeometryBytes(const CountryData *c, uint64_t *slack) {
+  uint64_t bytes = PolygonList_heapBytes(&c->polygons, slack);
+  Polygon **polys = PolygonList_data(&c->polygons);
+  for (uint32_t j = 0; j < c->polygons.size; j++) {
+    Polygon *poly = polys[j];
+    bytes += sizeof(Polygon) + GeoPointArray_heapBytes(&poly->points, slack) +
+             QuantPointArray_heapBytes(&poly->qpoints, slack);
+  }
+  return bytes;
+}
+
+typedef struct {
+  const CountryData *country;
+  uint64_t bytes;
+} CountryBytes;
+
+static int compareCountryBytes(const void *a, const void *b) {
+  uint64_t ba = ((const CountryBytes *)a)->bytes;
+  uint64_t bb = ((const CountryBytes *)b)->bytes;
+  return (ba < bb) - (ba > bb);  // Largest first
+}
+
+void printGeometryMemoryReport(CountryDatabase *db) {
+  if (!db || db->count == 0) {
+    return;
+  }
+  if (db->embedded) {
+    printf("Geometry: embedded in the binary for %llu countries, no heap\n",
+           (unsigned long long)db->count);
+    return;
+  }
+
+  CountryBytes *sizes = memAlloc(MEM_TAG_PARSE, db->count * sizeof(CountryBytes));
+  uint64_t total = 0, slack = 0, shapeText = 0, undecoded = 0;
+#ifdef GEODATA_THREADS
+  pthread_mutex_lock(&decodeLock);  // A prefetch may be decoding meanwhile
+#endif
+  for (uint64_t i = 0; i < db->count; i++) {
+    sizes[i].country = &db->countries[i];
+    sizes[i].bytes = countryGeometryBytes(&db->countries[i], &slack);
+    total += sizes[i].bytes;
+    if (db->countries[i].geoShape) {
+      shapeText += strlen(db->countries[i].geoShape) + 1;
+      undecoded++;
+    }
+  }
+#ifdef GEODATA_THREADS
+  pthread_mutex_unlock(&decodeLock);
+#endif
+  qsort(sizes, db->count, sizeof(CountryBytes), compareCountryBytes);
+
+  const double kb = 1024.0;
+  printf("Geometry: %.1f KB in %llu countries, %.1f KB array slack, "
+         "%.1f KB of shape text held by %llu undecoded countries\n",
+         total / kb, (unsigned long long)db->count, slack / kb, shapeText / kb,
+         (unsigned long long)undecoded);
+  uint64_t shown = db->count < 10 ? db->count : 10;
+  for (uint64_t i = 0; i < shown; i++) {
+    printf("  %-32s %10.1f KB\n", sizes[i].country->englishName, sizes[i].bytes / kb);
+  }
+  memFree(sizes);
+}
+
 // Find country by name (case-insensitive)
 CountryData *getCountryByName(CountryDatabase *db, const char *name) {
   for (uint64_t i = 0; i < db->count; i++) {
@@ -322,32 +671,32 @@ CountryData *getCountryByName(CountryDatabase *db, const char *name) {
 }
 
 // Free country database
+void freeCountryData(CountryData *c) {
+  memFree(c->geoPoint);
+  memFree(c->geoShape);
+  memFree(c->territoryCode);
+  memFree(c->status);
+  memFree(c->countryCode);
+  memFree(c->englishName);
+  memFree(c->continent);
+  memFree(c->region);
+  memFree(c->alpha2);
+
+  Polygon **polys = PolygonList_data(&c->polygons);  // Decoded or empty
+  for (uint32_t j = 0; j < c->polygons.size; j++) {
+    freePolygon(polys[j]);
+  }
+  PolygonList_free(&c->polygons);
+}
+
 void freeCountryDatabase(CountryDatabase *db) {
-  if (!db) return;
+  if (!db || db->embedded) return;
+  stopGeometryPrefetch(db);
 
   for (uint64_t i = 0; i < db->count; i++) {
-    CountryData *c = &db->countries[i];
-    free(c->geoPoint);
-    free(c->geoShape);
-    free(c->territoryCode);
-    free(c->status);
-    free(c->countryCode);
-    free(c->englishName);
-    free(c->continent);
-    free(c->region);
-    free(c->alpha2);
-
-    if (c->polygons) {
-      for (uint64_t j = 0; j < c->polygons->size; j++) {
-        Polygon **polyPtr = (Polygon **)c->polygons->p + j;
-        Polygon *poly = *polyPtr;
-        vec_free(poly->points);
-        free(poly);
-      }
-      vec_free(c->polygons);
-    }
+    freeCountryData(&db->countries[i]);
   }
 
-  free(db->countries);
-  free(db);
+  memFree(db->countries);
+  memFree(db);
 }
@@ -1,6 +1,10 @@
 #ifndef GEODATA_H
 #define GEODATA_H
 
+#include "array.h"
+#include "memtrack.h"
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 // Point in 2D space (latitude, longitude)
@@ -9,23 +13,38 @@ typedef struct {
   float lon;  // Longitude
 } GeoPoint;
 
-// Generic dynamic array
+// Quantized point: lat/lon as 16-bit steps from the ring's bounding-box
+// corner, with the box span divided into 65535 steps per axis
 typedef struct {
-  uint64_t size;
-  uint64_t itemSize;
-  uint64_t capacity;
-  void *p;
-} vec;
+  uint16_t lat;
+  uint16_t lon;
+} QuantPoint;
+
+// Vertex storage; a few points fit inline so tiny islands skip the heap
+DEFINE_ARRAY(GeoPointArray, GeoPoint, 4, MEM_TAG_GEOMETRY)
+DEFINE_ARRAY(QuantPointArray, QuantPoint, 8, MEM_TAG_GEOMETRY)
 
 // Polygon made of geographic points
+// Stored either as floats (points) or quantized (qpoints); read vertices
+// through polygonPointCount/polygonPoint so either form works
 typedef struct {
-  vec *points;  // vec of GeoPoint
+  GeoPointArray points;     // Float vertices (empty when quantized)
+  QuantPointArray qpoints;  // Quantized vertices (empty unless quantized)
+  bool quantized;
+  GeoPoint qStep;       // Degrees per quantization step (lat, lon)
+  GeoPoint capCenter;   // Center of a spherical cap enclosing every point
+  float capRadius;      // Angular radius of that cap (radians)
+  GeoPoint boxMin;      // Lat/lon bounding box
+  GeoPoint boxMax;
 } Polygon;
 
+// A country's rings; most countries have one, which is kept inline
+DEFINE_ARRAY(PolygonList, Polygon *, 1, MEM_TAG_GEOMETRY)
+
 // Country data with metadata and geographic boundaries
 typedef struct {
   char *geoPoint;
-  char *geoShape;
+  char *geoShape;        // Shape text until its rings are decoded, then NULL
   char *territoryCode;
   char *status;
   char *countryCode;
@@ -34,25 +53,92 @@ typedef struct {
   char *region;
   char *alpha2;
   uint64_t poly_count;
-  vec *polygons;       // vec of Polygon*
+  PolygonList polygons;  // Read through countryPolygons/countryRingCount
   GeoPoint centroid;   // Center point of country
+  atomic_bool decoded;   // geoShape has been parsed into polygons
 } CountryData;
 
 // Global country database
 typedef struct {
   CountryData *countries;
   uint64_t count;
+  bool embedded;  // Compiled into the binary (geoembed.h): read-only, never freed
 } CountryDatabase;
 
-// Vector functions
-vec *vec_init(uint64_t item_size, uint64_t capacity);
-void vec_append(vec *vec, void *item);
-void vec_free(vec *v);
+// Rows are parsed without their geometry; a country's shape text is decoded
+// the first time its rings are asked for. Safe from any thread: callers
+// racing on an undecoded country wait for one decode.
+void decodeCountryGeometry(CountryData *country);
+
+static inline void ensureCountryGeometry(const CountryData *country) {
+  if (!atomic_load_explicit(&country->decoded, memory_order_acquire)) {
+    decodeCountryGeometry((CountryData *)country);
+  }
+}
+
+// Rings of a country as a plain array
+static inline Polygon **countryPolygons(const CountryData *country) {
+  ensureCountryGeometry(country);
+  return PolygonList_data(&country->polygons);
+}
+
+static inline uint32_t countryRingCount(const CountryData *country) {
+  ensureCountryGeometry(country);
+  return country->polygons.size;
+}
+
+// Vertex access for either storage form
+static inline uint64_t polygonPointCount(const Polygon *poly) {
+  return poly->quantized ? poly->qpoints.size : poly->points.size;
+}
+
+static inline GeoPoint polygonPoint(const Polygon *poly, uint64_t i) {
+  if (poly->quantized) {
+    QuantPoint q = QuantPointArray_data(&poly->qpoints)[i];
+    return (GeoPoint){poly->boxMin.lat + q.lat * poly->qStep.lat,
+                      poly->boxMin.lon + q.lon * poly->qStep.lon};
+  }
+  return GeoPointArray_data(&poly->points)[i];
+}
+
+// All of a ring's vertices as floats for tight loops: the stored array, or
+// the quantized ring decoded into scratch (which the caller frees)
+const GeoPoint *polygonPoints(const Polygon *poly, GeoPointArray *scratch);
+
+// Quantized geometry halves vertex memory. Vertices round to the nearest
+// step, so the worst-case error per axis is half a step: span / 131070
+// degrees, about 0.85 m per degree of ring span (150 m for a ring spanning
+// 180 degrees, under 1 m for rings within a degree). Applies to polygons
+// loaded after the call.
+void setGeometryQuantization(bool enabled);
+bool isGeometryQuantized(void);
+float polygonQuantizationError(const Polygon *poly);  // Worst case, metres
+
+// Decode every country on a background thread (right away where threads are
+// unavailable) so the first border guess or pick doesn't pay for it. One
+// prefetch runs at a time; freeing its database stops it.
+void startGeometryPrefetch(CountryDatabase *db);
+bool isGeometryPrefetchRunning(void);
+void stopGeometryPrefetch(const CountryDatabase *db);  // No-op for another db
 
 // Country data functions
+// Metadata; rings decode lazily. Built with GEODATA_EMBEDDED, returns the
+// embedded database instead and ignores csv_path (see geoembed.h).
 CountryDatabase *loadCountryDatabase(const char *csv_path);
 void freeCountryDatabase(CountryDatabase *db);
 CountryData *getCountryByName(CountryDatabase *db, const char *name);
 void calculateCentroid(CountryData *country);
+void computePolygonBounds(Polygon *poly);
+Polygon *createPolygon(uint32_t pointCapacity);
+void finishPolygon(Polygon *poly);  // Bounds, then quantize if enabled
+void freePolygon(Polygon *poly);
+void printGeometryQuantization(CountryDatabase *db);  // Decodes every country
+void printGeometryMemoryReport(CountryDatabase *db);  // Per-country bytes, array slack
+
+// Row-level CSV access, for reloading only the rows that changed
+char *loadCsvFile(const char *path);                  // Whole file; memFree it
+int skipCountryRow(const char *fileData, int start);  // Offset of the next row
+bool parseCountryRow(char *fileData, int *start, bool header, CountryData *out);
+void freeCountryData(CountryData *country);
 
 #endif // GEODATA_H
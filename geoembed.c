@@ -0,0 +1,171 @@
+#include "geoembed.h"
+#include <stdio.h>
+#include <string.h>
+
+#define EMBED_POINTS_PER_LINE 4
+
+// C string literal, or NULL. Octal escapes have a fixed length so a digit
+// after one can't run into it, and '?' is escaped to keep trigraphs out.
+static void writeCString(FILE *f, const char *s) {
+  if (!s) {
+    fputs("NULL", f);
+    return;
+  }
+  fputs("(char *)\"", f);
+  for (const unsigned char *p = (const unsigned char *)s; *p; p++) {
+    if (*p == '"' || *p == '\\' || *p == '?') {
+      fprintf(f, "\\%c", *p);
+    } else if (*p < 0x20 || *p >= 0x7f) {
+      fprintf(f, "\\%03o", *p);
+    } else {
+      fputc(*p, f);
+    }
+  }
+  fputc('"', f);
+}
+
+// Hex floats round-trip exactly and always take an 'f' suffix
+static void writePoint(FILE *f, GeoPoint p) {
+  fprintf(f, "{%af, %af}", (double)p.lat, (double)p.lon);
+}
+
+// Flat vertex arrays, rings in database order
+static void writeVertices(FILE *f, const CountryDatabase *db, bool quantized) {
+  fprintf(f, "static const %s %s[] = {\n", quantized ? "QuantPoint" : "GeoPoint",
+          quantized ? "qvertices" : "vertices");
+  uint32_t onLine = 0;
+  for (uint64_t i = 0; i < db->count; i++) {
+    const CountryData *c = &db->countries[i];
+    Polygon **polys = countryPolygons(c);
+    for (uint32_t j = 0; j < countryRingCount(c); j++) {
+      const Polygon *poly = polys[j];
+      if (poly->quantized != quantized) continue;
+      for (uint64_t k = 0; k < polygonPointCount(poly); k++) {
+        fputs(onLine == 0 ? "  " : " ", f);
+        if (quantized) {
+          QuantPoint q = QuantPointArray_data(&poly->qpoints)[k];
+          fprintf(f, "{%u, %u},", q.lat, q.lon);
+        } else {
+          writePoint(f, GeoPointArray_data(&poly->points)[k]);
+          fputc(',', f);
+        }
+        if (++onLine == EMBED_POINTS_PER_LINE) {
+          fputc('\n', f);
+          onLine = 0;
+        }
+      }
+    }
+  }
+  fputs(onLine ? "\n};\n\n" : "};\n\n", f);
+}
+
+bool writeCountryDatabaseSource(CountryDatabase *db, const char *path) {
+  // Decode everything up front and see which vertex forms are present
+  uint64_t floatPoints = 0, quantPoints = 0, ringTotal = 0;
+  for (uint64_t i = 0; i < db->count; i++) {
+    const CountryData *c = &db->countries[i];
+    Polygon **polys = countryPolygons(c);
+    for (uint32_t j = 0; j < countryRingCount(c); j++) {
+      if (polys[j]->quantized) {
+        quantPoints += polygonPointCount(polys[j]);
+      } else {
+        floatPoints += polygonPointCount(polys[j]);
+      }
+    }
+    ringTotal += countryRingCount(c);
+  }
+
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    fprintf(stderr, "Error: Could not write %s\n", path);
+    return false;
+  }
+  fprintf(f, "// Generated by packdata --embed; do not edit. See geoembed.h.\n");
+  fprintf(f, "#include \"geoembed.h\"\n\n");
+  if (floatPoints) writeVertices(f, db, false);
+  if (quantPoints) writeVertices(f, db, true);
+
+  // Rings, pointing into the vertex arrays
+  if (ringTotal) {
+    fputs("static const Polygon rings[] = {\n", f);
+    uint64_t floatOffset = 0, quantOffset = 0;
+    for (uint64_t i = 0; i < db->count; i++) {
+      const CountryData *c = &db->countries[i];
+      Polygon **polys = countryPolygons(c);
+      for (uint32_t j = 0; j < countryRingCount(c); j++) {
+        const Polygon *poly = polys[j];
+        uint64_t n = polygonPointCount(poly);
+        fputs("  {", f);
+        if (n == 0) {
+          fputs(".quantized = false", f);
+        } else if (poly->quantized) {
+          fprintf(f, ".qpoints = {%llu, %llu, {.heap = (QuantPoint *)(qvertices + %llu)}}, "
+                  ".quantized = true, .qStep = ", (unsigned long long)n, (unsigned long long)n,
+                  (unsigned long long)quantOffset);
+          writePoint(f, poly->qStep);
+          quantOffset += n;
+        } else {
+          fprintf(f, ".points = {%llu, %llu, {.heap = (GeoPoint *)(vertices + %llu)}}",
+                  (unsigned long long)n, (unsigned long long)n, (unsigned long long)floatOffset);
+          floatOffset += n;
+        }
+        fputs(",\n   .capCenter = ", f);
+        writePoint(f, poly->capCenter);
+        fprintf(f, ", .capRadius = %af, .boxMin = ", (double)poly->capRadius);
+        writePoint(f, poly->boxMin);
+        fputs(", .boxMax = ", f);
+        writePoint(f, poly->boxMax);
+        fputs("},\n", f);
+      }
+    }
+    fputs("};\n\n", f);
+
+    fputs("static Polygon *const ringTable[] = {\n", f);
+    for (uint64_t r = 0; r < ringTotal; r++) {
+      fprintf(f, "  (Polygon *)(rings + %llu),\n", (unsigned long long)r);
+    }
+    fputs("};\n\n", f);
+  }
+
+  // Countries: metadata as literals, rings through the ring table
+  fputs("static const CountryData countries[] = {\n", f);
+  uint64_t ringOffset = 0;
+  for (uint64_t i = 0; i < db->count; i++) {
+    const CountryData *c = &db->countries[i];
+    uint32_t ringCount = countryRingCount(c);
+    const char *names[] = {"geoPoint", "territoryCode", "status", "countryCode", "englishName",
+                           "continent", "region", "alpha2"};
+    const char *values[] = {c->geoPoint, c->territoryCode, c->status, c->countryCode,
+                            c->englishName, c->continent, c->region, c->alpha2};
+    fputs("  {", f);
+    for (size_t k = 0; k < sizeof(names) / sizeof(names[0]); k++) {
+      fprintf(f, "%s.%s = ", k ? ",\n   " : "", names[k]);
+      writeCString(f, values[k]);
+    }
+    fprintf(f, ",\n   .poly_count = %llu", (unsigned long long)c->poly_count);
+    if (ringCount) {
+      fprintf(f, ", .polygons = {%u, %u, {.heap = (Polygon **)(ringTable + %llu)}}", ringCount,
+              ringCount, (unsigned long long)ringOffset);
+    }
+    fputs(",\n   .centroid = ", f);
+    writePoint(f, c->centroid);
+    fputs(", .decoded = true},\n", f);
+    ringOffset += ringCount;
+  }
+  if (db->count == 0) fputs("  {.decoded = true},\n", f);  // No empty initializers in C11
+  fputs("};\n\n", f);
+
+  fprintf(f, "const CountryDatabase embeddedCountryDatabase = {(CountryData *)countries, %llu, true};\n",
+          (unsigned long long)db->count);
+
+  bool ok = !ferror(f);
+  ok = fclose(f) == 0 && ok;
+  if (ok) {
+    printf("Embedded %llu countries, %llu rings, %llu float and %llu quantized vertices in %s\n",
+           (unsigned long long)db->count, (unsigned long long)ringTotal,
+           (unsigned long long)floatPoints, (unsigned long long)quantPoints, path);
+  } else {
+    fprintf(stderr, "Error: Failed writing %s\n", path);
+  }
+  return ok;
+}
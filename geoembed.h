@@ -0,0 +1,28 @@
+#ifndef GEOEMBED_H
+#define GEOEMBED_H
+
+#include "geodata.h"
+#include <stdbool.h>
+
+// The country database compiled into the executable. packdata --embed writes
+// the loaded dataset out as a C source file of static const tables: flat
+// vertex arrays that the rings point into, a ring table per country, string
+// literals for the metadata and the precomputed centroids, ring bounds and
+// caps, with every country already decoded. Building with
+// -DGEODATA_EMBEDDED and that file makes loadCountryDatabase return this
+// database without reading or parsing anything; it is read-only and
+// freeCountryDatabase leaves it alone.
+//
+//   ./packdata --embed geoembed_data.c coordinates/ccc.csv
+//   cc -DGEODATA_EMBEDDED ... geoembed_data.c ...
+//
+// Rings keep the storage form they were loaded in, so packdata --quantize
+// embeds 16-bit vertices at half the size.
+
+extern const CountryDatabase embeddedCountryDatabase;
+
+// Write db (all geometry decoded first) as a C source file defining
+// embeddedCountryDatabase
+bool writeCountryDatabaseSource(CountryDatabase *db, const char *path);
+
+#endif // GEOEMBED_H
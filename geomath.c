@@ -0,0 +1,142 @@
+#include "geomath.h"
+#include <stdio.h>
+#include <string.h>
+
+#define GEO_PI 3.14159265358979323846
+
+static Precision renderPrecision = GEO_RENDER_PRECISION;
+
+static const char *precisionNames[PRECISION_COUNT] = {"exact", "float", "fast"};
+
+static double haversineKm(GeoPoint p1, GeoPoint p2) {
+  double lat1 = p1.lat * GEO_PI / 180.0;
+  double lat2 = p2.lat * GEO_PI / 180.0;
+  double dlat = lat2 - lat1;
+  double dlon = (p2.lon - p1.lon) * GEO_PI / 180.0;
+  double a = sin(dlat / 2) * sin(dlat / 2) +
+             cos(lat1) * cos(lat2) * sin(dlon / 2) * sin(dlon / 2);
+  return GEO_EARTH_RADIUS_KM * 2 * atan2(sqrt(a), sqrt(1 - a));
+}
+
+float greatCircleKm(GeoPoint p1, GeoPoint p2, Precision tier) {
+  if (tier == PRECISION_EXACT) {
+    return (float)haversineKm(p1, p2);
+  }
+
+  float lat1 = p1.lat * (GEO_PI_F / 180.0f);
+  float lat2 = p2.lat * (GEO_PI_F / 180.0f);
+  float dlat = lat2 - lat1;
+  float dlon = (p2.lon - p1.lon) * (GEO_PI_F / 180.0f);
+  float a, c;
+  if (tier == PRECISION_FLOAT) {
+    float sLat = sinf(dlat / 2);
+    float sLon = sinf(dlon / 2);
+    a = sLat * sLat + cosf(lat1) * cosf(lat2) * sLon * sLon;
+    a = fminf(fmaxf(a, 0.0f), 1.0f);
+    c = 2 * atan2f(sqrtf(a), sqrtf(1 - a));
+  } else {
+    float sLat = fastSin(dlat / 2);
+    float sLon = fastSin(dlon / 2);
+    a = sLat * sLat + fastCos(lat1) * fastCos(lat2) * sLon * sLon;
+    a = fminf(fmaxf(a, 0.0f), 1.0f);
+    c = 2 * fastAtan2(sqrtf(a), sqrtf(1 - a));
+  }
+  return (float)GEO_EARTH_RADIUS_KM * c;
+}
+
+void setRenderPrecision(Precision tier) {
+  renderPrecision = tier;
+}
+
+Precision getRenderPrecision(void) {
+  return renderPrecision;
+}
+
+const char *getPrecisionName(Precision tier) {
+  return tier < PRECISION_COUNT ? precisionNames[tier] : "?";
+}
+
+bool parsePrecision(const char *name, Precision *tier) {
+  for (int i = 0; i < PRECISION_COUNT; i++) {
+    if (strcmp(name, precisionNames[i]) == 0) {
+      *tier = (Precision)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Surface distance between a vertex projected at this tier and the double
+// projection (same angles as latLonToSphere)
+static double projectionErrorKm(GeoPoint p, Precision tier) {
+  double phi = (90.0 - p.lat) / 180.0 * GEO_PI;
+  double theta = (p.lon + 180.0) / 360.0 * GEO_PI * 2.0;
+  double ex = cos(theta) * sin(phi);
+  double ey = sin(theta) * sin(phi);
+  double ez = cos(phi);
+
+  float phiF = (90.0f - p.lat) / 180.0f * GEO_PI_F;
+  float thetaF = (p.lon + 180.0f) / 360.0f * 2.0f * GEO_PI_F;
+  double x = tierCos(thetaF, tier) * tierSin(phiF, tier);
+  double y = tierSin(thetaF, tier) * tierSin(phiF, tier);
+  double z = tierCos(phiF, tier);
+
+  double dx = x - ex, dy = y - ey, dz = z - ez;
+  return sqrt(dx * dx + dy * dy + dz * dz) * GEO_EARTH_RADIUS_KM;
+}
+
+void printPrecisionReport(CountryDatabase *db) {
+  if (!db) return;
+
+  double distErr[PRECISION_COUNT] = {0};
+  uint64_t worstPair[PRECISION_COUNT][2] = {{0}};
+  uint64_t pairs = 0;
+  for (uint64_t i = 0; i < db->count; i++) {
+    for (uint64_t j = i + 1; j < db->count; j++) {
+      GeoPoint a = db->countries[i].centroid;
+      GeoPoint b = db->countries[j].centroid;
+      double reference = haversineKm(a, b);
+      for (int t = 0; t < PRECISION_COUNT; t++) {
+        double err = fabs(greatCircleKm(a, b, (Precision)t) - reference);
+        if (err > distErr[t]) {
+          distErr[t] = err;
+          worstPair[t][0] = i;
+          worstPair[t][1] = j;
+        }
+      }
+      pairs++;
+    }
+  }
+
+  double projErr[PRECISION_COUNT] = {0};
+  uint64_t vertices = 0;
+  for (uint64_t i = 0; i < db->count; i++) {
+    Polygon **polys = countryPolygons(&db->countries[i]);
+    for (uint32_t j = 0; j < countryRingCount(&db->countries[i]); j++) {
+      GeoPointArray scratch;
+      GeoPointArray_init(&scratch);
+      const GeoPoint *points = polygonPoints(polys[j], &scratch);
+      uint64_t count = polygonPointCount(polys[j]);
+      for (uint64_t k = 0; k < count; k++) {
+        for (int t = 0; t < PRECISION_COUNT; t++) {
+          double err = projectionErrorKm(points[k], (Precision)t);
+          if (err > projErr[t]) projErr[t] = err;
+        }
+      }
+      vertices += count;
+      GeoPointArray_free(&scratch);
+    }
+  }
+
+  // Both are measured against unrounded double math, so the exact tier shows
+  // only the cost of returning floats
+  printf("Precision report: %llu country pairs, %llu border vertices\n",
+         (unsigned long long)pairs, (unsigned long long)vertices);
+  printf("  tier     distance max err (km)   projection max err (km)   worst pair\n");
+  for (int t = 0; t < PRECISION_COUNT; t++) {
+    const char *a = pairs ? db->countries[worstPair[t][0]].englishName : "-";
+    const char *b = pairs ? db->countries[worstPair[t][1]].englishName : "-";
+    printf("  %-6s %16.6f %25.6f       %s / %s\n", getPrecisionName((Precision)t),
+           distErr[t], projErr[t], a, b);
+  }
+}
@@ -0,0 +1,120 @@
+#ifndef GEOMATH_H
+#define GEOMATH_H
+
+#include "geodata.h"
+#include <math.h>
+#include <stdbool.h>
+
+// Precision tiers for spherical math. Scored distances always use
+// PRECISION_EXACT; render paths use the render tier (fast by default) and
+// coarse pruning uses PRECISION_FAST directly.
+typedef enum {
+  PRECISION_EXACT = 0,  // double sin/cos/atan2/acos
+  PRECISION_FLOAT,      // float libm calls (sinf, cosf, ...)
+  PRECISION_FAST,       // Polynomial approximations below
+  PRECISION_COUNT
+} Precision;
+
+// Default render tier; build with -DGEO_RENDER_PRECISION=PRECISION_FLOAT (or
+// PRECISION_EXACT) to change it, or pick one at runtime with setRenderPrecision
+#ifndef GEO_RENDER_PRECISION
+#define GEO_RENDER_PRECISION PRECISION_FAST
+#endif
+
+#define GEO_EARTH_RADIUS_KM 6371.0
+#define GEO_PI_F 3.14159265f
+#define GEO_HALF_PI_F 1.57079633f
+
+// Fast approximations. Worst-case absolute error against double libm,
+// measured in float: fastSin 4e-7 and fastCos 7e-7 for |x| <= 4*pi (range
+// reduction loses precision beyond a few turns), fastAtan2 3e-7 rad,
+// fastAcos 4e-7 rad. On the globe 1e-6 rad is about 6 m.
+
+// sin on [-pi/2, pi/2] by an odd degree-9 least-squares fit (3.4e-9 in exact
+// arithmetic), after folding the argument into that range
+static inline float fastSin(float x) {
+  // Branch-free: round to the nearest turn, then mirror about +-pi/2
+  float turns = x * (0.5f / GEO_PI_F);
+  x -= 2.0f * GEO_PI_F * (float)(int)(turns + copysignf(0.5f, turns));  // [-pi, pi]
+  float folded = copysignf(GEO_PI_F, x) - x;
+  x = fabsf(x) > GEO_HALF_PI_F ? folded : x;
+  float x2 = x * x;
+  return x * (9.9999997653e-01f +
+              x2 * (-1.6666647603e-01f +
+                    x2 * (8.3328993552e-03f +
+                          x2 * (-1.9800872310e-04f + x2 * 2.5904424473e-06f))));
+}
+
+static inline float fastCos(float x) {
+  return fastSin(x + GEO_HALF_PI_F);
+}
+
+// atan on [0, 1] (Abramowitz & Stegun 4.4.49, 2e-8), extended by octant
+static inline float fastAtan2(float y, float x) {
+  float ax = fabsf(x);
+  float ay = fabsf(y);
+  float hi = ax > ay ? ax : ay;
+  if (hi == 0.0f) return 0.0f;
+  float t = (ax > ay ? ay : ax) / hi;
+  float t2 = t * t;
+  float r = t * (1.0f +
+                 t2 * (-0.3333314528f +
+                       t2 * (0.1999355085f +
+                             t2 * (-0.1420889944f +
+                                   t2 * (0.1065626393f +
+                                         t2 * (-0.0752896400f +
+                                               t2 * (0.0429096138f +
+                                                     t2 * (-0.0161657367f +
+                                                           t2 * 0.0028662257f))))))));
+  if (ay > ax) r = GEO_HALF_PI_F - r;
+  if (x < 0.0f) r = GEO_PI_F - r;
+  return y < 0.0f ? -r : r;
+}
+
+// acos (Abramowitz & Stegun 4.4.46, 2e-8); input is clamped to [-1, 1]
+static inline float fastAcos(float x) {
+  bool negative = x < 0.0f;
+  x = fabsf(x);
+  if (x > 1.0f) x = 1.0f;
+  float r = sqrtf(1.0f - x) *
+            (1.5707963050f +
+             x * (-0.2145988016f +
+                  x * (0.0889789874f +
+                       x * (-0.0501743046f +
+                            x * (0.0308918810f +
+                                 x * (-0.0170881256f +
+                                      x * (0.0066700901f + x * -0.0012624911f)))))));
+  return negative ? GEO_PI_F - r : r;
+}
+
+static inline float tierSin(float x, Precision tier) {
+  switch (tier) {
+    case PRECISION_EXACT: return (float)sin((double)x);
+    case PRECISION_FLOAT: return sinf(x);
+    default: return fastSin(x);
+  }
+}
+
+static inline float tierCos(float x, Precision tier) {
+  switch (tier) {
+    case PRECISION_EXACT: return (float)cos((double)x);
+    case PRECISION_FLOAT: return cosf(x);
+    default: return fastCos(x);
+  }
+}
+
+// Great-circle distance in km (haversine) at the given tier
+float greatCircleKm(GeoPoint p1, GeoPoint p2, Precision tier);
+
+// Tier for globe and border projection
+void setRenderPrecision(Precision tier);
+Precision getRenderPrecision(void);
+
+const char *getPrecisionName(Precision tier);
+bool parsePrecision(const char *name, Precision *tier);  // "exact", "float", "fast"
+
+// Max error of each tier against double math: centroid distance over every
+// country pair (km) and border vertex projection (km on the surface)
+void printPrecisionReport(CountryDatabase *db);
+
+#endif // GEOMATH_H
@@ -0,0 +1,278 @@
+#include "geopack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(GeoPoint) == 2 * sizeof(float), "GeoPoint must match the pack layout");
+
+// Bounds-checked cursor over a packed blob
+typedef struct {
+  const unsigned char *data;
+  size_t size;
+  size_t pos;
+  bool failed;
+} PackReader;
+
+static bool readBytes(PackReader *r, void *out, size_t n) {
+  if (r->failed || r->pos + n > r->size) {
+    r->failed = true;
+    return false;
+  }
+  memcpy(out, r->data + r->pos, n);
+  r->pos += n;
+  return true;
+}
+
+static uint32_t readU32(PackReader *r) {
+  uint32_t v = 0;
+  readBytes(r, &v, sizeof(v));
+  return v;
+}
+
+static float readF32(PackReader *r) {
+  float v = 0.0f;
+  readBytes(r, &v, sizeof(v));
+  return v;
+}
+
+static char *readString(PackReader *r) {
+  uint16_t len = 0;
+  readBytes(r, &len, sizeof(len));
+  char *s = memAlloc(MEM_TAG_STRINGS, len + 1);
+  if (!readBytes(r, s, len)) {
+    len = 0;
+  }
+  s[len] = '\0';
+  return s;
+}
+
+static void writeU32(FILE *f, uint32_t v) { fwrite(&v, sizeof(v), 1, f); }
+static void writeF32(FILE *f, float v) { fwrite(&v, sizeof(v), 1, f); }
+
+static void writeString(FILE *f, const char *s) {
+  size_t len = s ? strlen(s) : 0;
+  if (len > UINT16_MAX) len = UINT16_MAX;
+  uint16_t len16 = (uint16_t)len;
+  fwrite(&len16, sizeof(len16), 1, f);
+  if (len > 0) fwrite(s, 1, len, f);
+}
+
+// Serialized size of one country's geometry inside a chunk
+static size_t countryGeometryBytes(CountryData *c) {
+  size_t bytes = sizeof(uint32_t);
+  Polygon **polys = countryPolygons(c);
+  for (uint32_t j = 0; j < countryRingCount(c); j++) {
+    Polygon *poly = polys[j];
+    bytes += sizeof(uint32_t) + polygonPointCount(poly) * 2 * sizeof(float);
+  }
+  return bytes;
+}
+
+static bool writeGeometryChunk(CountryDatabase *db, const char *dir,
+                               uint32_t index, uint32_t first, uint32_t count) {
+  char path[512];
+  char name[64];
+  snprintf(name, sizeof(name), GEOPACK_CHUNK_FILE, index);
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    fprintf(stderr, "Error: Could not write %s\n", path);
+    return false;
+  }
+
+  writeU32(f, GEOPACK_MAGIC);
+  writeU32(f, GEOPACK_VERSION);
+  writeU32(f, first);
+  writeU32(f, count);
+
+  for (uint32_t i = first; i < first + count; i++) {
+    CountryData *c = &db->countries[i];
+    uint32_t polyCount = countryRingCount(c);
+    Polygon **polys = countryPolygons(c);
+    writeU32(f, polyCount);
+    for (uint32_t j = 0; j < polyCount; j++) {
+      Polygon *poly = polys[j];
+      uint64_t pointCount = polygonPointCount(poly);
+      writeU32(f, (uint32_t)pointCount);
+      for (uint64_t k = 0; k < pointCount; k++) {
+        GeoPoint pt = polygonPoint(poly, k);
+        writeF32(f, pt.lat);
+        writeF32(f, pt.lon);
+      }
+    }
+  }
+
+  fclose(f);
+  return true;
+}
+
+bool writeCountryDatabasePack(CountryDatabase *db, const char *dir) {
+  if (!db) return false;
+
+  // Group countries into chunks of roughly GEOPACK_CHUNK_BYTES each
+  // (a single huge country still gets a chunk of its own)
+  uint32_t chunkCount = 0;
+  size_t chunkBytes = 0;
+  uint32_t chunkFirst = 0;
+  for (uint32_t i = 0; i < db->count; i++) {
+    size_t bytes = countryGeometryBytes(&db->countries[i]);
+    if (i > chunkFirst && chunkBytes + bytes > GEOPACK_CHUNK_BYTES) {
+      if (!writeGeometryChunk(db, dir, chunkCount++, chunkFirst, i - chunkFirst)) {
+        return false;
+      }
+      chunkFirst = i;
+      chunkBytes = 0;
+    }
+    chunkBytes += bytes;
+  }
+  if (db->count > chunkFirst) {
+    if (!writeGeometryChunk(db, dir, chunkCount++, chunkFirst,
+                            (uint32_t)db->count - chunkFirst)) {
+      return false;
+    }
+  }
+
+  // Metadata goes last so it can record the chunk count
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s", dir, GEOPACK_META_FILE);
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    fprintf(stderr, "Error: Could not write %s\n", path);
+    return false;
+  }
+
+  writeU32(f, GEOPACK_MAGIC);
+  writeU32(f, GEOPACK_VERSION);
+  writeU32(f, (uint32_t)db->count);
+  writeU32(f, chunkCount);
+
+  for (uint64_t i = 0; i < db->count; i++) {
+    CountryData *c = &db->countries[i];
+    writeF32(f, c->centroid.lat);
+    writeF32(f, c->centroid.lon);
+    writeString(f, c->geoPoint);
+    writeString(f, c->territoryCode);
+    writeString(f, c->status);
+    writeString(f, c->countryCode);
+    writeString(f, c->englishName);
+    writeString(f, c->continent);
+    writeString(f, c->region);
+    writeString(f, c->alpha2);
+  }
+
+  fclose(f);
+  printf("Packed %llu countries into %u geometry chunks\n",
+         (unsigned long long)db->count, chunkCount);
+  return true;
+}
+
+static bool readHeader(PackReader *r) {
+  uint32_t magic = readU32(r);
+  uint32_t version = readU32(r);
+  if (r->failed || magic != GEOPACK_MAGIC || version != GEOPACK_VERSION) {
+    fprintf(stderr, "Error: Not a version %d dataset pack\n", GEOPACK_VERSION);
+    return false;
+  }
+  return true;
+}
+
+CountryDatabase *loadCountryDatabaseMeta(const unsigned char *data, size_t size,
+                                         uint32_t *chunkCount) {
+  PackReader r = {data, size, 0, false};
+  if (!readHeader(&r)) {
+    return NULL;
+  }
+
+  uint32_t count = readU32(&r);
+  uint32_t chunks = readU32(&r);
+  if (r.failed) return NULL;
+
+  CountryDatabase *db = memCalloc(MEM_TAG_DATABASE, 1, sizeof(CountryDatabase));
+  db->countries = memCalloc(MEM_TAG_DATABASE, count ? count : 1, sizeof(CountryData));
+  db->count = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    CountryData d = {0};
+    d.centroid.lat = readF32(&r);
+    d.centroid.lon = readF32(&r);
+    d.geoPoint = readString(&r);
+    d.territoryCode = readString(&r);
+    d.status = readString(&r);
+    d.countryCode = readString(&r);
+    d.englishName = readString(&r);
+    d.continent = readString(&r);
+    d.region = readString(&r);
+    d.alpha2 = readString(&r);
+    PolygonList_init(&d.polygons);  // Filled in by loadCountryGeometryChunk
+    d.decoded = true;               // No shape text to decode
+    db->countries[db->count++] = d;
+
+    if (r.failed) {
+      fprintf(stderr, "Error: Truncated dataset metadata\n");
+      freeCountryDatabase(db);
+      return NULL;
+    }
+  }
+
+  if (chunkCount) *chunkCount = chunks;
+  printf("Total countries loaded: %llu (geometry pending)\n",
+         (unsigned long long)db->count);
+  return db;
+}
+
+bool loadCountryGeometryChunk(CountryDatabase *db, const unsigned char *data,
+                              size_t size) {
+  PackReader r = {data, size, 0, false};
+  if (!db || !readHeader(&r)) {
+    return false;
+  }
+
+  uint32_t first = readU32(&r);
+  uint32_t count = readU32(&r);
+  if (r.failed || first + count > db->count) {
+    fprintf(stderr, "Error: Geometry chunk does not match metadata\n");
+    return false;
+  }
+
+  for (uint32_t i = first; i < first + count; i++) {
+    uint32_t polyCount = readU32(&r);
+    PolygonList polygons;
+    PolygonList_init(&polygons);
+    if ((size_t)polyCount * sizeof(uint32_t) > r.size - r.pos) {
+      r.failed = true;  // Each ring needs at least its point count
+    } else {
+      PolygonList_reserve(&polygons, polyCount);
+    }
+
+    for (uint32_t j = 0; j < polyCount && !r.failed; j++) {
+      uint32_t pointCount = readU32(&r);
+      if (r.failed || (size_t)pointCount * 2 * sizeof(float) > r.size - r.pos) {
+        r.failed = true;
+        break;
+      }
+
+      // (lat, lon) f32 pairs are GeoPoint's layout, so copy them in one go
+      Polygon *poly = createPolygon(pointCount);
+      readBytes(&r, GeoPointArray_data(&poly->points), pointCount * sizeof(GeoPoint));
+      poly->points.size = pointCount;
+      finishPolygon(poly);
+      PolygonList_push(&polygons, poly);
+    }
+
+    // Publish only complete geometry
+    CountryData *c = &db->countries[i];
+    if (r.failed) {
+      Polygon **polys = PolygonList_data(&polygons);
+      for (uint32_t j = 0; j < polygons.size; j++) {
+        freePolygon(polys[j]);
+      }
+      PolygonList_free(&polygons);
+      fprintf(stderr, "Error: Truncated geometry chunk\n");
+      return false;
+    }
+    c->polygons = polygons;
+  }
+
+  return true;
+}
@@ -0,0 +1,31 @@
+#ifndef GEOPACK_H
+#define GEOPACK_H
+
+#include "geodata.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Compact binary form of the country database, split so it can be streamed:
+//   meta.bin     - names, codes and centroids for every country (small)
+//   geo_NNN.bin  - border geometry for a run of countries, ~GEOPACK_CHUNK_BYTES each
+// All values are little-endian; strings are u16 length + bytes (no terminator)
+#define GEOPACK_MAGIC 0x50424C47u  // "GLBP"
+#define GEOPACK_VERSION 1
+#define GEOPACK_CHUNK_BYTES (512 * 1024)
+#define GEOPACK_META_FILE "meta.bin"
+#define GEOPACK_CHUNK_FILE "geo_%03u.bin"
+
+// Write the metadata file and geometry chunks into an existing directory
+bool writeCountryDatabasePack(CountryDatabase *db, const char *dir);
+
+// Build a database from a metadata blob; countries have no polygons yet
+// chunkCount receives the number of geometry chunks to fetch afterwards
+CountryDatabase *loadCountryDatabaseMeta(const unsigned char *data, size_t size,
+                                         uint32_t *chunkCount);
+
+// Attach the geometry from one chunk to the countries it covers
+bool loadCountryGeometryChunk(CountryDatabase *db, const unsigned char *data,
+                              size_t size);
+
+#endif // GEOPACK_H
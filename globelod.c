@@ -0,0 +1,350 @@
+#include "globelod.h"
+#include "viewcull.h"
+#include "memtrack.h"
+#include "raylib/src/raymath.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PATCH_GRID 16             // Quads per patch side
+#define LOD_MAX_LEVEL 8           // Deepest quadtree level
+#define LOD_SPLIT_THRESHOLD 0.35f // Split when patch size / distance exceeds this
+#define LOD_PRUNE_FRAMES 120      // Free patches unused for this many frames
+#define LOD_UPLOADS_PER_FRAME 24  // Limit new patch meshes per frame to avoid hitches
+
+struct GlobeLodNode {
+  int face;
+  int level;
+  int x, y;              // Position within the face at this level
+  Vector3 center;        // Unit direction to the patch center (model space)
+  float angularRadius;   // Radians from center to the farthest corner
+  bool hasMesh;
+  Mesh mesh;
+  unsigned int lastVisited;
+  unsigned int lastDrawn;
+  GlobeLodNode *children[4];  // NULL until the node is first split
+};
+
+// Cube face frames: normal, s axis, t axis (s x t = normal so the
+// triangles wind counter-clockwise seen from outside)
+static const Vector3 faceAxes[6][3] = {
+  {{ 1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+  {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+  {{ 0, 1, 0}, {0, 0, 1}, {1, 0, 0}},
+  {{ 0,-1, 0}, {1, 0, 0}, {0, 0, 1}},
+  {{ 0, 0, 1}, {1, 0, 0}, {0, 1, 0}},
+  {{ 0, 0,-1}, {0, 1, 0}, {1, 0, 0}},
+};
+
+// Map face coordinates (s, t in [-1, 1]) to the unit sphere
+// Uses the "spherified cube" mapping, which spreads triangles more evenly
+// than plain normalization
+static Vector3 cubeToSphere(int face, float s, float t) {
+  Vector3 n = faceAxes[face][0];
+  Vector3 a = faceAxes[face][1];
+  Vector3 b = faceAxes[face][2];
+  Vector3 p = {n.x + s * a.x + t * b.x, n.y + s * a.y + t * b.y,
+               n.z + s * a.z + t * b.z};
+
+  float x2 = p.x * p.x, y2 = p.y * p.y, z2 = p.z * p.z;
+  return (Vector3){
+    p.x * sqrtf(1.0f - y2 / 2.0f - z2 / 2.0f + y2 * z2 / 3.0f),
+    p.y * sqrtf(1.0f - z2 / 2.0f - x2 / 2.0f + z2 * x2 / 3.0f),
+    p.z * sqrtf(1.0f - x2 / 2.0f - y2 / 2.0f + x2 * y2 / 3.0f),
+  };
+}
+
+// Face coordinate of a grid line at this node's level
+static float faceCoord(int cell, float frac, int level) {
+  return -1.0f + 2.0f * (cell + frac) / (float)(1 << level);
+}
+
+static float angleBetween(Vector3 a, Vector3 b) {
+  float d = Vector3DotProduct(a, b);
+  if (d > 1.0f) d = 1.0f;
+  if (d < -1.0f) d = -1.0f;
+  return acosf(d);
+}
+
+static GlobeLodNode *createNode(int face, int level, int x, int y) {
+  GlobeLodNode *node = memCalloc(MEM_TAG_RENDER, 1, sizeof(GlobeLodNode));
+  node->face = face;
+  node->level = level;
+  node->x = x;
+  node->y = y;
+  node->center = cubeToSphere(face, faceCoord(x, 0.5f, level),
+                              faceCoord(y, 0.5f, level));
+
+  // Bounding cap over the corners and edge midpoints
+  float maxAngle = 0.0f;
+  for (int i = 0; i <= 2; i++) {
+    for (int j = 0; j <= 2; j++) {
+      Vector3 p = cubeToSphere(face, faceCoord(x, i * 0.5f, level),
+                               faceCoord(y, j * 0.5f, level));
+      float angle = angleBetween(node->center, p);
+      if (angle > maxAngle) maxAngle = angle;
+    }
+  }
+  node->angularRadius = maxAngle * 1.05f;  // Margin for curved patch edges
+  return node;
+}
+
+// Bytes a patch mesh occupies on the GPU (positions, normals, UVs, indices)
+static int64_t meshGpuBytes(const Mesh *mesh) {
+  return (int64_t)mesh->vertexCount * 8 * sizeof(float) +
+         (int64_t)mesh->triangleCount * 3 * sizeof(unsigned short);
+}
+
+static void releaseNodeMesh(GlobeLodNode *node) {
+  if (node->hasMesh) {
+    memTrackExternal(MEM_TAG_GPU, -meshGpuBytes(&node->mesh));
+    UnloadMesh(node->mesh);
+    node->hasMesh = false;
+  }
+}
+
+static void freeNode(GlobeLodNode *node) {
+  if (!node) return;
+  for (int i = 0; i < 4; i++) {
+    freeNode(node->children[i]);
+  }
+  releaseNodeMesh(node);
+  memFree(node);
+}
+
+// Build and upload the grid mesh for a patch
+// Texture coordinates use the par_shapes sphere convention:
+//   u = polar angle / PI, v = azimuth / (2 PI)
+static void buildNodeMesh(GlobeLodNode *node, float radius) {
+  const int side = PATCH_GRID + 1;
+  Mesh mesh = {0};
+  mesh.vertexCount = side * side;
+  mesh.triangleCount = PATCH_GRID * PATCH_GRID * 2;
+  mesh.vertices = (float *)MemAlloc(mesh.vertexCount * 3 * sizeof(float));
+  mesh.normals = (float *)MemAlloc(mesh.vertexCount * 3 * sizeof(float));
+  mesh.texcoords = (float *)MemAlloc(mesh.vertexCount * 2 * sizeof(float));
+  mesh.indices = (unsigned short *)MemAlloc(mesh.triangleCount * 3 * sizeof(unsigned short));
+
+  float minV = 1.0f, maxV = 0.0f;
+  for (int j = 0; j < side; j++) {
+    for (int i = 0; i < side; i++) {
+      int k = j * side + i;
+      Vector3 p = cubeToSphere(node->face,
+                               faceCoord(node->x, (float)i / PATCH_GRID, node->level),
+                               faceCoord(node->y, (float)j / PATCH_GRID, node->level));
+
+      mesh.vertices[k * 3 + 0] = p.x * radius;
+      mesh.vertices[k * 3 + 1] = p.y * radius;
+      mesh.vertices[k * 3 + 2] = p.z * radius;
+      mesh.normals[k * 3 + 0] = p.x;
+      mesh.normals[k * 3 + 1] = p.y;
+      mesh.normals[k * 3 + 2] = p.z;
+
+      float z = p.z;
+      if (z > 1.0f) z = 1.0f;
+      if (z < -1.0f) z = -1.0f;
+      float phi = acosf(z);
+      float theta = atan2f(p.y, p.x);
+      if (theta < 0.0f) theta += 2.0f * PI;
+
+      float u = phi / PI;
+      float v = theta / (2.0f * PI);
+      mesh.texcoords[k * 2 + 0] = u;
+      mesh.texcoords[k * 2 + 1] = v;
+      if (v < minV) minV = v;
+      if (v > maxV) maxV = v;
+    }
+  }
+
+  // Patches straddling the azimuth seam: keep v continuous (texture repeats)
+  if (maxV - minV > 0.5f) {
+    for (int k = 0; k < mesh.vertexCount; k++) {
+      if (mesh.texcoords[k * 2 + 1] < 0.5f) {
+        mesh.texcoords[k * 2 + 1] += 1.0f;
+      }
+    }
+  }
+
+  int idx = 0;
+  for (int j = 0; j < PATCH_GRID; j++) {
+    for (int i = 0; i < PATCH_GRID; i++) {
+      unsigned short v00 = (unsigned short)(j * side + i);
+      unsigned short v10 = (unsigned short)(j * side + i + 1);
+      unsigned short v01 = (unsigned short)((j + 1) * side + i);
+      unsigned short v11 = (unsigned short)((j + 1) * side + i + 1);
+      mesh.indices[idx++] = v00;
+      mesh.indices[idx++] = v10;
+      mesh.indices[idx++] = v11;
+      mesh.indices[idx++] = v00;
+      mesh.indices[idx++] = v11;
+      mesh.indices[idx++] = v01;
+    }
+  }
+
+  UploadMesh(&mesh, false);
+  memTrackExternal(MEM_TAG_GPU, meshGpuBytes(&mesh));
+
+  // The GPU copy is all DrawMesh needs
+  MemFree(mesh.vertices);
+  MemFree(mesh.normals);
+  MemFree(mesh.texcoords);
+  MemFree(mesh.indices);
+  mesh.vertices = NULL;
+  mesh.normals = NULL;
+  mesh.texcoords = NULL;
+  mesh.indices = NULL;
+
+  node->mesh = mesh;
+  node->hasMesh = true;
+}
+
+// Per-frame view data
+typedef struct {
+  ViewCull cull;
+  int uploadBudget;
+} LodView;
+
+// True if the patch cap is entirely behind the horizon or off screen
+static bool isNodeCulled(GlobeLod *lod, LodView *view, GlobeLodNode *node) {
+  return isCapCulled(&view->cull, node->center, node->angularRadius, lod->radius);
+}
+
+static bool shouldSplit(GlobeLod *lod, LodView *view, GlobeLodNode *node) {
+  if (node->level >= LOD_MAX_LEVEL) {
+    return false;
+  }
+  float boundRadius = 2.0f * lod->radius * sinf(node->angularRadius * 0.5f);
+  Vector3 center = Vector3Scale(node->center, lod->radius);
+  float dist = Vector3Distance(view->cull.cameraLocal, center) - boundRadius;
+  if (dist < 0.001f) dist = 0.001f;
+  return boundRadius / dist > LOD_SPLIT_THRESHOLD;
+}
+
+static void drawNode(GlobeLod *lod, LodView *view, GlobeLodNode *node) {
+  if (!node->hasMesh) {
+    buildNodeMesh(node, lod->radius);
+    view->uploadBudget--;
+    lod->stats.patchesCached++;
+  }
+  node->lastDrawn = lod->frame;
+  DrawMesh(node->mesh, lod->material, view->cull.transform);
+  lod->stats.patchesDrawn++;
+  lod->stats.triangles += node->mesh.triangleCount;
+}
+
+static void visitNode(GlobeLod *lod, LodView *view, GlobeLodNode *node) {
+  node->lastVisited = lod->frame;
+
+  if (isNodeCulled(lod, view, node)) {
+    lod->stats.patchesCulled++;
+    return;
+  }
+
+  if (shouldSplit(lod, view, node)) {
+    bool childrenReady = true;
+    for (int i = 0; i < 4; i++) {
+      if (!node->children[i]) {
+        node->children[i] = createNode(node->face, node->level + 1,
+                                       node->x * 2 + (i & 1), node->y * 2 + (i >> 1));
+      }
+      if (!node->children[i]->hasMesh) childrenReady = false;
+    }
+
+    // Refine unless out of upload budget and this patch can stand in
+    if (childrenReady || view->uploadBudget > 0 || !node->hasMesh) {
+      for (int i = 0; i < 4; i++) {
+        visitNode(lod, view, node->children[i]);
+      }
+      return;
+    }
+    lod->stats.refining = true;
+  }
+
+  drawNode(lod, view, node);
+}
+
+// Release subtrees and meshes that have not been needed recently
+static void pruneNode(GlobeLod *lod, GlobeLodNode *node) {
+  if (node->children[0]) {
+    if (lod->frame - node->children[0]->lastVisited > LOD_PRUNE_FRAMES) {
+      for (int i = 0; i < 4; i++) {
+        freeNode(node->children[i]);
+        node->children[i] = NULL;
+      }
+    } else {
+      for (int i = 0; i < 4; i++) {
+        pruneNode(lod, node->children[i]);
+      }
+    }
+  }
+
+  if (node->hasMesh && lod->frame - node->lastDrawn > LOD_PRUNE_FRAMES) {
+    releaseNodeMesh(node);
+  }
+}
+
+static int countCachedMeshes(GlobeLodNode *node) {
+  if (!node) return 0;
+  int count = node->hasMesh ? 1 : 0;
+  for (int i = 0; i < 4; i++) {
+    count += countCachedMeshes(node->children[i]);
+  }
+  return count;
+}
+
+void initGlobeLod(GlobeLod *lod, float radius, Texture2D texture) {
+  memset(lod, 0, sizeof(GlobeLod));
+  lod->radius = radius;
+  lod->material = LoadMaterialDefault();
+  lod->defaultShader = lod->material.shader;
+  lod->material.maps[MATERIAL_MAP_DIFFUSE].texture = texture;
+  for (int f = 0; f < 6; f++) {
+    lod->faces[f] = createNode(f, 0, 0, 0);
+  }
+}
+
+void unloadGlobeLod(GlobeLod *lod) {
+  for (int f = 0; f < 6; f++) {
+    freeNode(lod->faces[f]);
+    lod->faces[f] = NULL;
+  }
+  // Textures and shader belong to the caller; don't let UnloadMaterial free them
+  setGlobeLodShader(lod, (Shader){0}, (Texture2D){0}, (Texture2D){0});
+  lod->material.maps[MATERIAL_MAP_DIFFUSE].texture = (Texture2D){0};
+  UnloadMaterial(lod->material);
+}
+
+void setGlobeLodTexture(GlobeLod *lod, Texture2D texture) {
+  lod->material.maps[MATERIAL_MAP_DIFFUSE].texture = texture;
+}
+
+void setGlobeLodShader(GlobeLod *lod, Shader shader, Texture2D map1, Texture2D map2) {
+  lod->material.shader = shader.id ? shader : lod->defaultShader;
+  lod->material.maps[MATERIAL_MAP_METALNESS].texture = map1;  // Bound to texture1
+  lod->material.maps[MATERIAL_MAP_NORMAL].texture = map2;     // ... and texture2
+}
+
+void drawGlobeLod(GlobeLod *lod, Camera3D camera, Matrix transform) {
+  lod->frame++;
+  lod->stats.patchesDrawn = 0;
+  lod->stats.patchesCulled = 0;
+  lod->stats.triangles = 0;
+  lod->stats.refining = false;
+
+  LodView view = {0};
+  setupViewCull(&view.cull, camera, transform, lod->radius);
+  view.uploadBudget = LOD_UPLOADS_PER_FRAME;
+
+  for (int f = 0; f < 6; f++) {
+    visitNode(lod, &view, lod->faces[f]);
+  }
+
+  // Pruning is cheap but needn't run every frame
+  if (lod->frame % 30 == 0) {
+    lod->stats.patchesCached = 0;
+    for (int f = 0; f < 6; f++) {
+      pruneNode(lod, lod->faces[f]);
+      lod->stats.patchesCached += countCachedMeshes(lod->faces[f]);
+    }
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef GLOBELOD_H
+#define GLOBELOD_H
+
+#include "raylib/src/raylib.h"
+#include <stdbool.h>
+
+// Adaptive level-of-detail globe built from a quadtree per cube face.
+// Each leaf is a small grid patch projected onto the sphere; patches split as
+// the camera gets closer and patches that are behind the horizon or outside
+// the view frustum are skipped. Texture coordinates follow the par_shapes
+// convention used by GenMeshSphere and latLonToSphere, so earth2.jpg and the
+// country outlines line up exactly as before.
+
+typedef struct GlobeLodNode GlobeLodNode;
+
+typedef struct {
+  int patchesDrawn;
+  int patchesCulled;
+  int triangles;      // Triangles submitted this frame
+  int patchesCached;  // Patch meshes currently resident on the GPU
+  bool refining;      // Some patches wait on a later frame's upload budget
+} GlobeLodStats;
+
+typedef struct {
+  float radius;
+  Material material;
+  Shader defaultShader;  // Restored before the material is unloaded
+  GlobeLodNode *faces[6];
+  unsigned int frame;
+  GlobeLodStats stats;
+} GlobeLod;
+
+void initGlobeLod(GlobeLod *lod, float radius, Texture2D texture);
+void unloadGlobeLod(GlobeLod *lod);
+void setGlobeLodTexture(GlobeLod *lod, Texture2D texture);
+// Shade with a caller-owned shader; map1 and map2 are bound as texture1 and
+// texture2. A zero shader restores the default shading.
+void setGlobeLodShader(GlobeLod *lod, Shader shader, Texture2D map1, Texture2D map2);
+
+// Draw the visible patches; call inside BeginMode3D with the same camera
+void drawGlobeLod(GlobeLod *lod, Camera3D camera, Matrix transform);
+
+#endif // GLOBELOD_H
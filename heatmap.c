@@ -0,0 +1,112 @@
+#include "heatmap.h"
+#include "memtrack.h"
+#include <math.h>
+#include <string.h>
+
+// What one resolved guess contributes to every cell
+typedef struct {
+  const uint16_t *km;  // Border mode: the guessed country's field
+  GeoPoint centroid;   // Centroid mode
+  float distance;      // Reported distance
+} HeatGuess;
+
+void initHeatMap(HeatMap *map, float cellDegrees) {
+  memset(map, 0, sizeof(*map));
+  initFieldGrid(&map->grid, cellDegrees);
+  HeatFieldArray_init(&map->fields);
+  HeatCellArray_init(&map->cells);
+}
+
+void clearHeatMap(HeatMap *map) {
+  HeatField *fields = HeatFieldArray_data(&map->fields);
+  for (uint32_t i = 0; i < map->fields.size; i++) {
+    freeCountryField(&fields[i].field);
+  }
+  HeatFieldArray_free(&map->fields);
+  HeatCellArray_free(&map->cells);
+  map->mystery = NULL;
+  map->resolved = 0;
+}
+
+void freeHeatMap(HeatMap *map) {
+  clearHeatMap(map);
+  freeFieldGrid(&map->grid);
+}
+
+static const CountryField *findField(const HeatMap *map, const CountryData *country) {
+  const HeatField *fields = HeatFieldArray_data(&map->fields);
+  for (uint32_t i = 0; i < map->fields.size; i++) {
+    if (fields[i].country == country) return &fields[i].field;
+  }
+  return NULL;
+}
+
+static void findHotCells(HeatMap *map, const HeatGuess *guesses, int count, bool border) {
+  map->cells.size = 0;
+  if (count == 0) return;
+
+  uint32_t cells = fieldCellCount(&map->grid);
+  for (uint32_t cell = 0; cell < cells; cell++) {
+    GeoPoint center = border ? (GeoPoint){0} : fieldCellCenter(&map->grid, cell);
+    float misfit = 0.0f;
+    // Most cells miss the first guess's ring, so this loop rarely runs long
+    for (int i = 0; i < count && misfit <= HEAT_RANGE_KM; i++) {
+      float km = border ? guesses[i].km[cell] : calculateDistance(center, guesses[i].centroid);
+      float gap = fabsf(km - guesses[i].distance);
+      if (gap > misfit) misfit = gap;
+    }
+    if (misfit <= HEAT_RANGE_KM) {
+      HeatCellArray_push(&map->cells, (HeatCell){cell, misfit});
+    }
+  }
+}
+
+bool updateHeatMap(HeatMap *map, const GameState *game) {
+  bool changed = false;
+  if (game->mysteryCountry != map->mystery || game->currentDistanceMode != map->mode) {
+    changed = map->cells.size > 0;
+    clearHeatMap(map);
+    map->mystery = game->mysteryCountry;
+    map->mode = game->currentDistanceMode;
+  }
+  if (!game->mysteryCountry) return changed;
+
+  bool border = game->currentDistanceMode == DISTANCE_MODE_BORDER_TO_BORDER;
+  HeatGuess *guesses = memAlloc(MEM_TAG_FIELDS, (game->guessCount ? game->guessCount : 1) *
+                                                    sizeof(HeatGuess));
+  int count = 0;
+  int resolved = 0;
+  bool built = false;
+  for (int i = 0; i < game->guessCount; i++) {
+    const Guess *guess = &game->guesses[i];
+    if (guess->pending || guess->country == game->mysteryCountry) continue;
+    resolved++;
+
+    HeatGuess g = {NULL, guess->country->centroid, guess->distance};
+    if (border) {
+      const CountryField *field = findField(map, guess->country);
+      if (!field) {
+        if (built) {
+          memFree(guesses);
+          return changed;  // One field per update keeps frames short
+        }
+        HeatField entry = {guess->country, {0}};
+        buildCountryField(&map->grid, guess->country, &entry.field);
+        HeatFieldArray_push(&map->fields, entry);
+        field = &HeatFieldArray_data(&map->fields)[map->fields.size - 1].field;
+        built = true;
+      }
+      if (!field->km) continue;  // No rings to measure from
+      g.km = field->km;
+    }
+    guesses[count++] = g;
+  }
+
+  if (resolved != map->resolved) {
+    findHotCells(map, guesses, count, border);
+    map->resolved = resolved;
+    changed = true;
+  }
+  memFree(guesses);
+  return changed;
+}
@@ -0,0 +1,47 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include "distfield.h"
+#include "game.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Heat map hint (F2): the cells where the mystery country can be, given
+// every resolved guess. A cell is hot when its distance from each guessed
+// country is close to the distance that guess reported. Border mode reads
+// the guessed countries' distance fields (so hot cells trace where the
+// mystery's border can run); centroid mode measures to their centroids.
+
+#define HEAT_RANGE_KM 600.0f  // Cells misfitting any guess by more are cold
+
+typedef struct {
+  uint32_t cell;
+  float misfit;  // Largest gap between a guess's distance and this cell's, km
+} HeatCell;
+
+typedef struct {
+  const CountryData *country;
+  CountryField field;
+} HeatField;
+
+DEFINE_ARRAY(HeatCellArray, HeatCell, 1, MEM_TAG_FIELDS)
+DEFINE_ARRAY(HeatFieldArray, HeatField, 4, MEM_TAG_FIELDS)
+
+typedef struct {
+  FieldGrid grid;
+  HeatFieldArray fields;  // Guessed countries' fields, built one per update
+  HeatCellArray cells;    // Hot cells
+  const CountryData *mystery;  // Round the map belongs to
+  DistanceMode mode;
+  int resolved;                // Resolved guesses the cells reflect
+} HeatMap;
+
+void initHeatMap(HeatMap *map, float cellDegrees);
+void freeHeatMap(HeatMap *map);
+void clearHeatMap(HeatMap *map);  // Drop fields and cells (e.g. new database)
+
+// Catch up with the game's resolved guesses, building at most one field per
+// call; returns true when the hot cells changed
+bool updateHeatMap(HeatMap *map, const GameState *game);
+
+#endif // HEATMAP_H
@@ -0,0 +1,264 @@
+#include "hotreload.h"
+#include "memtrack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+  #include <sys/inotify.h>
+#endif
+
+#define RELOAD_QUIET_TIME 0.2  // Seconds without writes before re-parsing
+#define POLL_INTERVAL 1.0      // Seconds between mtime checks without inotify
+
+static double wallTime(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// FNV-1a over the row's bytes
+static uint64_t hashRow(const char *row, int length) {
+  uint64_t h = 14695981039346656037ull;
+  for (int i = 0; i < length; i++) {
+    h ^= (unsigned char)row[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+// Live country with this row hash not already claimed, or -1; the country
+// at the same position is tried first since most rows stay put
+static int32_t findLiveRow(const DatasetWatch *w, uint64_t hash, uint32_t hint,
+                           const bool *claimed) {
+  uint32_t count = w->db ? (uint32_t)w->db->count : 0;
+  if (hint < count && !claimed[hint] && w->rowHash[hint] == hash) {
+    return (int32_t)hint;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    if (!claimed[i] && w->rowHash[i] == hash) return (int32_t)i;
+  }
+  return -1;
+}
+
+// Countries the pending snapshot parsed itself (the rest belong to the live one)
+static void discardPending(DatasetWatch *w) {
+  if (!w->pending) return;
+  for (uint64_t i = 0; i < w->pending->count; i++) {
+    if (w->pendingSource[i] < 0) {
+      freeCountryData(&w->pending->countries[i]);
+    }
+  }
+  memFree(w->pending->countries);
+  memFree(w->pending);
+  memFree(w->pendingHash);
+  memFree(w->pendingSource);
+  w->pending = NULL;
+  w->pendingHash = NULL;
+  w->pendingSource = NULL;
+}
+
+// Build the pending snapshot from the file's text, reusing unchanged rows.
+// Returns false if nothing changed.
+static bool buildSnapshot(DatasetWatch *w, char *text) {
+  double start = wallTime();
+
+  uint32_t rows = 0;
+  for (int i = 0; text[i] != '\0'; i = skipCountryRow(text, i)) {
+    rows++;
+  }
+  uint32_t liveCount = w->db ? (uint32_t)w->db->count : 0;
+
+  CountryDatabase *db = memCalloc(MEM_TAG_DATABASE, 1, sizeof(CountryDatabase));
+  db->countries = memAlloc(MEM_TAG_DATABASE, (rows ? rows : 1) * sizeof(CountryData));
+  db->count = 0;
+  uint64_t *hashes = memAlloc(MEM_TAG_DATABASE, (rows ? rows : 1) * sizeof(uint64_t));
+  int32_t *source = memAlloc(MEM_TAG_DATABASE, (rows ? rows : 1) * sizeof(int32_t));
+  bool *claimed = memCalloc(MEM_TAG_DATABASE, liveCount ? liveCount : 1, sizeof(bool));
+
+  uint32_t parsed = 0;
+  uint32_t kept = 0;
+  bool moved = false;
+  int row = 0;
+  for (int i = 0; text[i] != '\0'; row++) {
+    int end = skipCountryRow(text, i);
+    uint64_t hash = hashRow(text + i, end - i);
+    uint32_t slot = (uint32_t)db->count;
+
+    int32_t live = row == 0 ? -1 : findLiveRow(w, hash, slot, claimed);
+    if (live >= 0) {
+      claimed[live] = true;
+      // Both snapshots hold the same rings, so decode before sharing: a copy
+      // decoded later would free shape text the other still points at
+      decodeCountryGeometry(&w->db->countries[live]);
+      db->countries[slot] = w->db->countries[live];
+      moved |= (uint32_t)live != slot;
+      kept++;
+    } else {
+      int next = i;
+      if (!parseCountryRow(text, &next, row == 0, &db->countries[slot])) {
+        i = end;
+        continue;  // Header row or empty entry
+      }
+      parsed++;
+    }
+    hashes[slot] = hash;
+    source[slot] = live;
+    db->count++;
+    i = end;
+  }
+  memFree(claimed);
+
+  if (w->db && parsed == 0 && !moved && kept == liveCount) {
+    discardPending(w);  // Edited and changed back
+    memFree(db->countries);
+    memFree(db);
+    memFree(hashes);
+    memFree(source);
+    return false;
+  }
+
+  discardPending(w);
+  w->pending = db;
+  w->pendingHash = hashes;
+  w->pendingSource = source;
+
+  if (w->db) {
+    printf("Dataset changed: %u of %llu countries re-parsed in %.1f ms, %u of %u kept\n",
+           parsed, (unsigned long long)db->count, (wallTime() - start) * 1000.0, kept,
+           liveCount);
+  }
+  return true;
+}
+
+CountryDatabase *applyDatasetSnapshot(DatasetWatch *w) {
+  if (!w->pending) return w->db;
+
+  if (w->db) {
+    stopGeometryPrefetch(w->db);
+    bool *shared = memCalloc(MEM_TAG_DATABASE, w->db->count ? w->db->count : 1, sizeof(bool));
+    for (uint64_t i = 0; i < w->pending->count; i++) {
+      if (w->pendingSource[i] >= 0) shared[w->pendingSource[i]] = true;
+    }
+    for (uint64_t i = 0; i < w->db->count; i++) {
+      if (!shared[i]) freeCountryData(&w->db->countries[i]);
+    }
+    memFree(shared);
+    memFree(w->db->countries);
+    memFree(w->db);
+    memFree(w->rowHash);
+  }
+
+  w->db = w->pending;
+  w->rowHash = w->pendingHash;
+  memFree(w->pendingSource);
+  w->pending = NULL;
+  w->pendingHash = NULL;
+  w->pendingSource = NULL;
+  return w->db;
+}
+
+static bool statFile(const char *path, int64_t *mtime, int64_t *size) {
+  struct stat st;
+  if (stat(path, &st) != 0) return false;
+  *mtime = (int64_t)st.st_mtime;
+  *size = (int64_t)st.st_size;
+  return true;
+}
+
+CountryDatabase *startDatasetWatch(DatasetWatch *w, const char *path) {
+  memset(w, 0, sizeof(*w));
+  w->notifyFd = -1;
+  snprintf(w->path, sizeof(w->path), "%s", path);
+
+  char *text = loadCsvFile(path);
+  if (!text) return NULL;
+  buildSnapshot(w, text);
+  memFree(text);
+  applyDatasetSnapshot(w);
+  printf("Total countries loaded: %llu\n", (unsigned long long)w->db->count);
+
+  // Watch the directory rather than the file: editors often save by
+  // writing a new file and renaming it over the old one
+  char dir[512];
+  snprintf(dir, sizeof(dir), "%s", path);
+  char *slash = strrchr(dir, '/');
+  snprintf(w->name, sizeof(w->name), "%s", slash ? slash + 1 : dir);
+  if (slash) {
+    *slash = '\0';
+  } else {
+    snprintf(dir, sizeof(dir), ".");
+  }
+
+#ifdef __linux__
+  w->notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (w->notifyFd >= 0 &&
+      inotify_add_watch(w->notifyFd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    close(w->notifyFd);
+    w->notifyFd = -1;
+  }
+#endif
+  if (w->notifyFd < 0) {
+    statFile(w->path, &w->mtime, &w->size);
+  }
+  printf("Watching %s for changes%s\n", path, w->notifyFd < 0 ? " (polling)" : "");
+  return w->db;
+}
+
+void stopDatasetWatch(DatasetWatch *w) {
+  discardPending(w);
+  if (w->notifyFd >= 0) {
+    close(w->notifyFd);
+  }
+  freeCountryDatabase(w->db);
+  memFree(w->rowHash);
+  memset(w, 0, sizeof(*w));
+  w->notifyFd = -1;
+}
+
+// Whether the file was written since the last check
+static bool fileChanged(DatasetWatch *w, double now) {
+  bool changed = false;
+#ifdef __linux__
+  if (w->notifyFd >= 0) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t length;
+    while ((length = read(w->notifyFd, buffer, sizeof(buffer))) > 0) {
+      for (char *p = buffer; p < buffer + length;) {
+        const struct inotify_event *event = (const struct inotify_event *)p;
+        if (event->len && strcmp(event->name, w->name) == 0) changed = true;
+        p += sizeof(struct inotify_event) + event->len;
+      }
+    }
+    return changed;
+  }
+#endif
+  if (now - w->lastPoll < POLL_INTERVAL) return false;
+  w->lastPoll = now;
+  int64_t mtime, size;
+  if (statFile(w->path, &mtime, &size) && (mtime != w->mtime || size != w->size)) {
+    w->mtime = mtime;
+    w->size = size;
+    changed = true;
+  }
+  return changed;
+}
+
+bool pollDatasetWatch(DatasetWatch *w, double now) {
+  if (fileChanged(w, now)) {
+    w->changed = true;
+    w->changedAt = now;  // Each write pushes the re-parse back
+  }
+  if (w->changed && now - w->changedAt >= RELOAD_QUIET_TIME) {
+    w->changed = false;
+    char *text = loadCsvFile(w->path);
+    if (text) {
+      buildSnapshot(w, text);
+      memFree(text);
+    }
+  }
+  return w->pending != NULL;
+}
@@ -0,0 +1,43 @@
+#ifndef HOTRELOAD_H
+#define HOTRELOAD_H
+
+#include "geodata.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Watches the dataset CSV while the game runs (--watch, desktop only). Every
+// country row is hashed; when the file changes, rows whose bytes are the
+// same keep their parsed CountryData and only the others are re-parsed into
+// a new database snapshot. The snapshot waits until the caller applies it,
+// so a round in progress keeps the database it started with. Uses inotify
+// on Linux and polls the file's modification time elsewhere.
+typedef struct {
+  char path[512];
+  char name[512];    // File name within the watched directory
+  int notifyFd;      // inotify descriptor, or -1 when polling
+  int64_t mtime;     // Polling: modification time and size last seen
+  int64_t size;
+  double lastPoll;
+  bool changed;      // Written since the last re-parse
+  double changedAt;  // Time of the latest write
+
+  CountryDatabase *db;       // Live snapshot
+  uint64_t *rowHash;         // Per live country
+  CountryDatabase *pending;  // Next snapshot, or NULL
+  uint64_t *pendingHash;
+  int32_t *pendingSource;    // Per pending country: live index it shares, or -1
+} DatasetWatch;
+
+// Load the dataset and start watching it; returns the live database
+CountryDatabase *startDatasetWatch(DatasetWatch *watch, const char *path);
+void stopDatasetWatch(DatasetWatch *watch);  // Frees every snapshot
+
+// Check for edits without blocking; changed rows are re-parsed once the file
+// has been quiet for a moment. True while a snapshot is waiting.
+bool pollDatasetWatch(DatasetWatch *watch, double now);
+
+// Make the pending snapshot live and free the countries it no longer shares.
+// Move caches across with pendingSource before calling this.
+CountryDatabase *applyDatasetSnapshot(DatasetWatch *watch);
+
+#endif // HOTRELOAD_H
@@ -0,0 +1,277 @@
+// Load generator for the headless server: each client thread keeps several
+// sessions open and round-robins random guesses across them, then reports
+// throughput and request latency percentiles.
+// Usage: ./loadgen [--socket path] [--clients n] [--sessions n] [--seconds s]
+//                  [--guesses n] [--mode border|centroid]
+#include "server.h"
+#include "array.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_CLIENTS 1024
+
+DEFINE_ARRAY(LatencyArray, double, 1, MEM_TAG_GAME)
+DEFINE_ARRAY(NameList, char *, 1, MEM_TAG_GAME)
+
+typedef struct {
+  int fd;
+  char buf[4096];
+  size_t len;
+  size_t pos;
+} LineReader;
+
+typedef struct {
+  unsigned long long id;
+  int guesses;
+  bool open;
+} ClientSession;
+
+typedef struct {
+  int index;
+  LatencyArray latencies;  // Milliseconds per request
+  uint64_t sessions;
+  uint64_t guesses;
+  uint64_t wins;
+  uint64_t errors;
+  bool failed;
+} Client;
+
+static const char *socketPath = SERVER_SOCKET_PATH;
+static int sessionsPerClient = 16;
+static int guessesPerSession = 20;
+static const char *mode = "border";
+static double deadline;
+static NameList countries;  // Filled once before the clients start
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int connectServer(void) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Next reply line without its newline; false when the server hangs up
+static bool readLine(LineReader *r, char *out, size_t cap) {
+  size_t n = 0;
+  for (;;) {
+    if (r->pos == r->len) {
+      ssize_t got = read(r->fd, r->buf, sizeof(r->buf));
+      if (got <= 0) return false;
+      r->len = (size_t)got;
+      r->pos = 0;
+    }
+    char c = r->buf[r->pos++];
+    if (c == '\n') break;
+    if (n + 1 < cap) out[n++] = c;
+  }
+  out[n] = '\0';
+  return true;
+}
+
+// Send one request and read its first reply line, timing the round trip
+static bool request(Client *client, LineReader *r, const char *line, char *reply,
+                    size_t cap) {
+  double start = now();
+  size_t len = strlen(line);
+  if (write(r->fd, line, len) != (ssize_t)len || !readLine(r, reply, cap)) {
+    client->failed = true;
+    return false;
+  }
+  LatencyArray_push(&client->latencies, (now() - start) * 1000.0);
+  if (strncmp(reply, "OK", 2) != 0) {
+    client->errors++;
+    return false;
+  }
+  return true;
+}
+
+static bool fetchCountries(void) {
+  int fd = connectServer();
+  if (fd < 0) return false;
+  LineReader r = {fd, {0}, 0, 0};
+  char line[SERVER_MAX_LINE];
+  unsigned long long count = 0;
+  bool ok = write(fd, "COUNTRIES\n", 10) == 10 && readLine(&r, line, sizeof(line)) &&
+            sscanf(line, "OK %llu", &count) == 1;
+  for (unsigned long long i = 0; ok && i < count; i++) {
+    ok = readLine(&r, line, sizeof(line));
+    if (ok) NameList_push(&countries, strdup(line));
+  }
+  close(fd);
+  return ok && countries.size > 0;
+}
+
+static uint32_t nextRandom(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+static void *clientMain(void *arg) {
+  Client *client = arg;
+  LineReader r = {connectServer(), {0}, 0, 0};
+  if (r.fd < 0) {
+    client->failed = true;
+    return NULL;
+  }
+
+  uint32_t rng = 2463534242u + (uint32_t)client->index * 7919u;
+  ClientSession *slots = calloc((size_t)sessionsPerClient, sizeof(ClientSession));
+  char line[SERVER_MAX_LINE];
+  char reply[SERVER_MAX_LINE];
+  char **names = NameList_data(&countries);
+
+  for (int turn = 0; now() < deadline && !client->failed; turn++) {
+    ClientSession *s = &slots[turn % sessionsPerClient];
+    if (!s->open) {
+      snprintf(line, sizeof(line), "NEW %u %s\n", nextRandom(&rng), mode);
+      if (!request(client, &r, line, reply, sizeof(reply))) continue;
+      s->id = strtoull(reply + 3, NULL, 10);
+      s->guesses = 0;
+      s->open = true;
+      client->sessions++;
+      continue;
+    }
+
+    const char *name = names[nextRandom(&rng) % countries.size];
+    snprintf(line, sizeof(line), "GUESS %llu %s\n", s->id, name);
+    bool won = false;
+    if (request(client, &r, line, reply, sizeof(reply))) {
+      float km;
+      int wonFlag, guesses, score;
+      won = sscanf(reply, "OK %f %d %d %d", &km, &wonFlag, &guesses, &score) == 4 && wonFlag;
+      client->guesses++;
+      client->wins += won;
+    }
+    if (won || ++s->guesses >= guessesPerSession) {
+      snprintf(line, sizeof(line), "END %llu\n", s->id);
+      request(client, &r, line, reply, sizeof(reply));
+      s->open = false;
+    }
+  }
+
+  // Leave nothing behind on the server
+  for (int i = 0; i < sessionsPerClient && !client->failed; i++) {
+    if (slots[i].open) {
+      snprintf(line, sizeof(line), "END %llu\n", slots[i].id);
+      request(client, &r, line, reply, sizeof(reply));
+    }
+  }
+  free(slots);
+  close(r.fd);
+  return NULL;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+int main(int argc, char **argv) {
+  int clientCount = 8;
+  double seconds = 5.0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+      socketPath = argv[++i];
+    } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+      clientCount = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) {
+      sessionsPerClient = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      seconds = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--guesses") == 0 && i + 1 < argc) {
+      guessesPerSession = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+      mode = argv[++i];
+    } else {
+      fprintf(stderr, "Usage: %s [--socket path] [--clients n] [--sessions n] "
+              "[--seconds s] [--guesses n] [--mode border|centroid]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (clientCount < 1) clientCount = 1;
+  if (clientCount > MAX_CLIENTS) clientCount = MAX_CLIENTS;
+  if (sessionsPerClient < 1) sessionsPerClient = 1;
+  if (guessesPerSession < 1) guessesPerSession = 1;
+
+  if (!fetchCountries()) {
+    fprintf(stderr, "Error: Could not reach the server at %s\n", socketPath);
+    return 1;
+  }
+
+  printf("Load: %d clients x %d sessions for %.1f s (%u countries, %s distances)\n",
+         clientCount, sessionsPerClient, seconds, countries.size, mode);
+  Client *clients = calloc((size_t)clientCount, sizeof(Client));
+  pthread_t *threads = calloc((size_t)clientCount, sizeof(pthread_t));
+  double start = now();
+  deadline = start + seconds;
+  int started = 0;
+  for (; started < clientCount; started++) {
+    clients[started].index = started;
+    if (pthread_create(&threads[started], NULL, clientMain, &clients[started]) != 0) break;
+  }
+  for (int i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  double elapsed = now() - start;
+
+  // Merge every client's latencies for the percentiles
+  LatencyArray all;
+  LatencyArray_init(&all);
+  uint64_t sessions = 0, guesses = 0, wins = 0, errors = 0;
+  int failed = 0;
+  for (int i = 0; i < started; i++) {
+    Client *c = &clients[i];
+    LatencyArray_append(&all, LatencyArray_data(&c->latencies), c->latencies.size);
+    LatencyArray_free(&c->latencies);
+    sessions += c->sessions;
+    guesses += c->guesses;
+    wins += c->wins;
+    errors += c->errors;
+    failed += c->failed;
+  }
+
+  uint32_t n = all.size;
+  double *ms = LatencyArray_data(&all);
+  qsort(ms, n, sizeof(double), compareDoubles);
+  printf("Requests: %u in %.2f s, %.0f req/s (%.0f guesses/s)\n", n, elapsed,
+         n / elapsed, guesses / elapsed);
+  printf("Sessions: %llu started, %llu won, %llu error replies, %d client(s) lost\n",
+         (unsigned long long)sessions, (unsigned long long)wins,
+         (unsigned long long)errors, failed);
+  if (n > 0) {
+    printf("Latency ms: p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n", ms[n / 2],
+           ms[(uint64_t)n * 90 / 100], ms[(uint64_t)n * 99 / 100], ms[n - 1]);
+  }
+
+  LatencyArray_free(&all);
+  char **names = NameList_data(&countries);
+  for (uint32_t i = 0; i < countries.size; i++) free(names[i]);
+  NameList_free(&countries);
+  free(clients);
+  free(threads);
+  return failed ? 1 : 0;
+}
@@ -3,20 +3,61 @@
 #include "raylib/src/rlgl.h"
 #include "geodata.h"
 #include "game.h"
+#include "geomath.h"
+#include "distworker.h"
+#include "globelod.h"
+#include "viewcull.h"
+#include "picking.h"
+#include "replay.h"
+#include "solver.h"
+#include "heatmap.h"
+#include "countrymap.h"
+#include "uitext.h"
+#include "memtrack.h"
+#include "scratch.h"
+#include <float.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <ctype.h>
 
 #ifdef PLATFORM_WEB
   #include <emscripten/emscripten.h>
   #include <emscripten/html5.h>
+  #include "datastream.h"
+#else
+  #include "hotreload.h"
+  #include "renderbench.h"
 #endif
 
 #define SCREEN_WIDTH 1920
 #define SCREEN_HEIGHT 1080
 #define GLOBE_RADIUS 1.5f
 #define COUNTRY_SCALE_FACTOR 1.0f  // No scaling - render at exact geographic size
+#define HOVER_OUTLINE_LIFT 0.013f  // Hover outline height above the globe
+#define CLICK_SLOP 4.0f  // Max mouse travel (px) for a press to count as a click
+#define GUESS_FILL_ALPHA 200        // Guessed country fill strength (borders are opaque)
+#define HINT_BUILD_BUDGET 0.004     // Seconds per frame spent filling the hint table
+#define HINT_JOBS_IN_FLIGHT 2       // Hint pairs out with the distance workers at once
+#define HINT_FIELD_DEGREES 1.0f     // Field cell size for border hints without workers
+#define IDLE_FRAME_TIME (1.0 / 60.0)  // Input polling interval while nothing is drawn
+#define IDLE_REDRAW_TIME 1.0        // Repaint at least this often, even when idle
+#define HEAT_MAP_DEGREES 1.0f       // Heat map cell size (about 79 km of error)
+#define HEAT_MAP_LIFT 0.0005f       // Heat map height above the globe, under the hover outline
+#define FRAME_SCRATCH_BYTES (64 * 1024)  // Per-frame arena; grows if a frame needs more
+#define ALLOC_CHECK_WARMUP 120      // Drawn frames before --alloc-check starts counting
+#define BENCH_FRAMES 300            // Timed frames per --bench scenario (one camera path)
+#define BENCH_WARMUP 30             // Untimed frames at the start of the path
+#define BENCH_SEED 1                // Mystery country for every --bench round
+
+// Per-frame render counters shown in the stats overlay (F3)
+typedef struct {
+  int countriesShaded;  // Guessed countries colored in the country map palette
+  int paletteUploads;   // Palette texture updates this frame (0 or 1)
+  int ringsDrawn;       // Outline rings submitted (fallback and hover outlines)
+  int ringsCulled;      // Rings skipped as behind the horizon or off screen
+} RenderStats;
 
 // Ray-sphere intersection for arcball rotation
 // Returns true if ray intersects sphere, and sets hitPoint to intersection point
@@ -52,7 +93,7 @@ bool raySphereIntersect(Vector3 rayOrigin, Vector3 rayDir, float sphereRadius, V
 }
 
 // Convert lat/lon to 3D point on sphere
-// Must match par_shapes coordinate system used by GenMeshSphere
+// Must match par_shapes coordinate system (also used by the globe patches in globelod.c)
 Vector3 latLonToSphere(float lat, float lon, float radius) {
   // Convert lat/lon to UV parameters (same as par_shapes)
   float u = (90.0f - lat) / 180.0f;      // Latitude → UV [0,1]
@@ -63,13 +104,25 @@ Vector3 latLonToSphere(float lat, float lon, float radius) {
   float theta = v * 2.0f * PI;           // Azimuthal angle [0, 2π]
 
   // Generate 3D coordinates (same formula as par_shapes)
+  // Trig runs at the render precision tier (polynomial by default)
+  Precision tier = getRenderPrecision();
+  float sinPhi = tierSin(phi, tier);
   return (Vector3){
-    radius * cosf(theta) * sinf(phi),    // X
-    radius * sinf(theta) * sinf(phi),    // Y
-    radius * cosf(phi)                    // Z
+    radius * tierCos(theta, tier) * sinPhi,  // X
+    radius * tierSin(theta, tier) * sinPhi,  // Y
+    radius * tierCos(phi, tier)              // Z
   };
 }
 
+// Convert a point on the sphere back to lat/lon (inverse of latLonToSphere)
+GeoPoint sphereToLatLon(Vector3 p) {
+  float r = Vector3Length(p);
+  float phi = acosf(Clamp(p.z / r, -1.0f, 1.0f));  // Polar angle [0, π]
+  float theta = atan2f(p.y, p.x);                  // Azimuthal angle [-π, π]
+  if (theta < 0.0f) theta += 2.0f * PI;
+  return (GeoPoint){90.0f - phi * 180.0f / PI, theta * 180.0f / PI - 180.0f};
+}
+
 // Convert lat/lon to 3D point on sphere with scaling around centroid
 Vector3 latLonToSphereScaled(float lat, float lon, GeoPoint centroid,
                               float radius, float scaleFactor) {
@@ -87,266 +140,54 @@ Vector3 latLonToSphereScaled(float lat, float lon, GeoPoint centroid,
   return Vector3Add(centroid3D, offset);
 }
 
-// Ear clipping triangulation helpers
-// Check if three consecutive vertices form a convex angle (left turn in 2D)
-bool isConvexVertex(GeoPoint *prev, GeoPoint *curr, GeoPoint *next) {
-  // Use cross product to determine if we have a left turn (convex)
-  // Cross product: (curr - prev) × (next - curr)
-  float dx1 = curr->lon - prev->lon;
-  float dy1 = curr->lat - prev->lat;
-  float dx2 = next->lon - curr->lon;
-  float dy2 = next->lat - curr->lat;
-
-  float cross = dx1 * dy2 - dy1 * dx2;
-  return cross > 0; // Positive cross product means counter-clockwise (convex)
-}
-
-// Check if point P is inside triangle ABC using barycentric coordinates
-bool pointInTriangle(GeoPoint *p, GeoPoint *a, GeoPoint *b, GeoPoint *c) {
-  // Compute barycentric coordinates
-  float denominator = ((b->lat - c->lat) * (a->lon - c->lon) +
-                       (c->lon - b->lon) * (a->lat - c->lat));
-
-  if (fabsf(denominator) < 0.0000001f) {
-    return false; // Degenerate triangle
-  }
-
-  float u = ((b->lat - c->lat) * (p->lon - c->lon) +
-             (c->lon - b->lon) * (p->lat - c->lat)) / denominator;
-  float v = ((c->lat - a->lat) * (p->lon - c->lon) +
-             (a->lon - c->lon) * (p->lat - c->lat)) / denominator;
-  float w = 1.0f - u - v;
-
-  // Point is inside if all barycentric coordinates are non-negative
-  return (u >= 0) && (v >= 0) && (w >= 0);
-}
-
-// Check if a vertex forms a valid "ear" that can be clipped
-bool isEar(GeoPoint *points, int count, int prev, int curr, int next,
-           bool *active) {
-  GeoPoint *p1 = &points[prev];
-  GeoPoint *p2 = &points[curr];
-  GeoPoint *p3 = &points[next];
-
-  // Must be a convex vertex
-  if (!isConvexVertex(p1, p2, p3)) {
-    return false;
-  }
-
-  // Check that no other vertices are inside this triangle
-  for (int i = 0; i < count; i++) {
-    if (!active[i] || i == prev || i == curr || i == next) {
-      continue;
-    }
-
-    if (pointInTriangle(&points[i], p1, p2, p3)) {
-      return false;
-    }
-  }
-
-  return true;
-}
-
-// Ear clipping triangulation
-// Returns triangle indices (3 per triangle)
-typedef struct {
-  int *indices;
-  int count; // Number of indices (triangles * 3)
-} TriangleList;
-
-TriangleList earClipTriangulate(GeoPoint *points, int count) {
-  TriangleList result = {NULL, 0};
-
-  if (count < 3) {
-    return result;
-  }
-
-  // Allocate max possible triangles (n-2 triangles, 3 indices each)
-  result.indices = (int *)malloc((count - 2) * 3 * sizeof(int));
-  if (!result.indices) {
-    return result;
-  }
-
-  // Track which vertices are still active (not yet clipped)
-  bool *active = (bool *)malloc(count * sizeof(bool));
-  if (!active) {
-    free(result.indices);
-    result.indices = NULL;
-    return result;
-  }
-
-  for (int i = 0; i < count; i++) {
-    active[i] = true;
-  }
-
-  int remainingVertices = count;
-  int current = 0;
-  int iterations = 0;
-  const int maxIterations = count * count; // Prevent infinite loops
-
-  while (remainingVertices > 3 && iterations < maxIterations) {
-    iterations++;
-
-    // Find next active vertex
-    while (!active[current]) {
-      current = (current + 1) % count;
-    }
-
-    // Find previous and next active vertices
-    int prev = current;
-    do {
-      prev = (prev - 1 + count) % count;
-    } while (!active[prev]);
-
-    int next = current;
-    do {
-      next = (next + 1) % count;
-    } while (!active[next]);
-
-    // Check if current vertex is an ear
-    if (isEar(points, count, prev, current, next, active)) {
-      // Add triangle
-      result.indices[result.count++] = prev;
-      result.indices[result.count++] = current;
-      result.indices[result.count++] = next;
-
-      // Remove current vertex
-      active[current] = false;
-      remainingVertices--;
-
-      // Move to next vertex
-      current = next;
-    } else {
-      // Try next vertex
-      current = next;
-    }
-  }
-
-  // Add final triangle from remaining 3 vertices
-  if (remainingVertices == 3) {
-    int remaining[3];
-    int idx = 0;
-    for (int i = 0; i < count && idx < 3; i++) {
-      if (active[i]) {
-        remaining[idx++] = i;
-      }
-    }
-
-    if (idx == 3) {
-      result.indices[result.count++] = remaining[0];
-      result.indices[result.count++] = remaining[1];
-      result.indices[result.count++] = remaining[2];
-    }
-  }
-
-  free(active);
-  return result;
-}
-
-// Draw a country's polygon on the sphere (filled with triangles using ear clipping)
-void drawCountryPolygonFilled(Polygon *poly, GeoPoint countryCenter,
-                               float radius, float scaleFactor, Color color) {
-  if (!poly || poly->points->size < 3) {
-    return;
-  }
-
-  // Convert vec of GeoPoints to array for ear clipping
-  int pointCount = (int)poly->points->size;
-  GeoPoint *points = (GeoPoint *)poly->points->p;
-
-  // Triangulate the polygon
-  TriangleList triangles = earClipTriangulate(points, pointCount);
-
-  if (triangles.indices == NULL || triangles.count == 0) {
-    return;
-  }
-
-  // Render triangles using immediate mode
-  rlBegin(RL_TRIANGLES);
-  rlColor4ub(color.r, color.g, color.b, color.a);
-
-  for (int i = 0; i < triangles.count; i += 3) {
-    int idx0 = triangles.indices[i];
-    int idx1 = triangles.indices[i + 1];
-    int idx2 = triangles.indices[i + 2];
-
-    GeoPoint *p0 = &points[idx0];
-    GeoPoint *p1 = &points[idx1];
-    GeoPoint *p2 = &points[idx2];
-
-    Vector3 v0 = latLonToSphereScaled(p0->lat, p0->lon, countryCenter,
-                                      radius, scaleFactor);
-    Vector3 v1 = latLonToSphereScaled(p1->lat, p1->lon, countryCenter,
-                                      radius, scaleFactor);
-    Vector3 v2 = latLonToSphereScaled(p2->lat, p2->lon, countryCenter,
-                                      radius, scaleFactor);
-
-    rlVertex3f(v0.x, v0.y, v0.z);
-    rlVertex3f(v1.x, v1.y, v1.z);
-    rlVertex3f(v2.x, v2.y, v2.z);
-  }
-
-  rlEnd();
-
-  // Clean up
-  free(triangles.indices);
-}
-
 // Draw a country's polygon on the sphere (outline only)
 void drawCountryPolygonOutline(Polygon *poly, GeoPoint countryCenter,
                                 float radius, float scaleFactor, Color color) {
-  if (!poly || poly->points->size < 2) {
+  uint64_t count = poly ? polygonPointCount(poly) : 0;
+  if (count < 2) {
     return;
   }
 
   // Draw lines connecting the points with scaled coordinates
-  for (uint64_t i = 0; i < poly->points->size - 1; i++) {
-    GeoPoint *p1 = (GeoPoint *)poly->points->p + i;
-    GeoPoint *p2 = (GeoPoint *)poly->points->p + i + 1;
-
-    Vector3 v1 =
-        latLonToSphereScaled(p1->lat, p1->lon, countryCenter, radius, scaleFactor);
+  // Each vertex is decoded and projected once, then reused as the next start
+  GeoPoint first = polygonPoint(poly, 0);
+  Vector3 vFirst =
+      latLonToSphereScaled(first.lat, first.lon, countryCenter, radius, scaleFactor);
+  Vector3 v1 = vFirst;
+  for (uint64_t i = 1; i < count; i++) {
+    GeoPoint p2 = polygonPoint(poly, i);
     Vector3 v2 =
-        latLonToSphereScaled(p2->lat, p2->lon, countryCenter, radius, scaleFactor);
+        latLonToSphereScaled(p2.lat, p2.lon, countryCenter, radius, scaleFactor);
 
     DrawLine3D(v1, v2, color);
+    v1 = v2;
   }
 
   // Close the polygon
-  GeoPoint *first = (GeoPoint *)poly->points->p;
-  GeoPoint *last = (GeoPoint *)poly->points->p + (poly->points->size - 1);
-  Vector3 vFirst =
-      latLonToSphereScaled(first->lat, first->lon, countryCenter, radius, scaleFactor);
-  Vector3 vLast =
-      latLonToSphereScaled(last->lat, last->lon, countryCenter, radius, scaleFactor);
-  DrawLine3D(vLast, vFirst, color);
+  DrawLine3D(v1, vFirst, color);
 }
 
 
-// Draw a country with all its polygons (filled)
-void drawCountryFilled(CountryData *country, float radius, float scaleFactor,
-                       Color color) {
-  if (!country || !country->polygons) {
-    return;
-  }
-
-  for (uint64_t i = 0; i < country->polygons->size; i++) {
-    Polygon **polyPtr = (Polygon **)country->polygons->p + i;
-    Polygon *poly = *polyPtr;
-    drawCountryPolygonFilled(poly, country->centroid, radius, scaleFactor, color);
-  }
-}
-
 // Draw a country with all its polygons (outline only)
+// Rings whose bounding cap is behind the horizon or outside the frustum are
+// skipped instead of being depth-rejected segment by segment
 void drawCountryOutline(CountryData *country, float radius, float scaleFactor,
-                        Color color) {
-  if (!country || !country->polygons) {
+                        Color color, const ViewCull *cull, RenderStats *stats) {
+  if (!country) {
     return;
   }
 
-  for (uint64_t i = 0; i < country->polygons->size; i++) {
-    Polygon **polyPtr = (Polygon **)country->polygons->p + i;
-    Polygon *poly = *polyPtr;
+  Polygon **polys = countryPolygons(country);
+  for (uint32_t i = 0; i < countryRingCount(country); i++) {
+    Polygon *poly = polys[i];
+
+    // COUNTRY_SCALE_FACTOR is 1, so the geographic cap is the drawn cap
+    Vector3 capDir = latLonToSphere(poly->capCenter.lat, poly->capCenter.lon, 1.0f);
+    if (isCapCulled(cull, capDir, poly->capRadius, radius)) {
+      stats->ringsCulled++;
+      continue;
+    }
+    stats->ringsDrawn++;
     drawCountryPolygonOutline(poly, country->centroid, radius, scaleFactor, color);
   }
 }
@@ -365,8 +206,9 @@ int compareSearchMatches(const void *a, const void *b) {
 }
 
 // Filter countries by search text with smart ranking
+// The candidate list lives on the frame's scratch arena
 int filterCountries(CountryDatabase *db, const char *searchText,
-                    CountryData **results, int maxResults) {
+                    CountryData **results, int maxResults, ScratchArena *scratch) {
   int searchLen = strlen(searchText);
 
   if (searchLen == 0) {
@@ -375,16 +217,20 @@ int filterCountries(CountryDatabase *db, const char *searchText,
 
   // Convert search text to lowercase
   char lowerSearch[100];
-  for (int i = 0; i < searchLen && i < 99; i++) {
+  if (searchLen > 99) searchLen = 99;
+  for (int i = 0; i < searchLen; i++) {
     lowerSearch[i] = tolower(searchText[i]);
   }
   lowerSearch[searchLen] = '\0';
 
   // Collect all matches with scores
-  SearchMatch matches[500];  // Max matches to consider
+  SearchMatch *matches = scratchAlloc(scratch, (db->count ? db->count : 1) * sizeof(SearchMatch));
   int matchCount = 0;
+  if (!matches) {
+    return 0;
+  }
 
-  for (uint64_t i = 0; i < db->count && matchCount < 500; i++) {
+  for (uint64_t i = 0; i < db->count; i++) {
     char lowerName[200];
     int nameLen = strlen(db->countries[i].englishName);
     for (int j = 0; j < nameLen && j < 199; j++) {
@@ -435,508 +281,1321 @@ int filterCountries(CountryDatabase *db, const char *searchText,
   return resultCount;
 }
 
-int main(void) {
-  // Initialize window
-  InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Globle Game - Guess the Country!");
-  SetTargetFPS(60);
+// A hint table pair being computed on the distance workers
+typedef struct {
+  uint32_t jobId;
+  uint32_t a, b;
+  bool stale;  // The table was reset while the job was out; drop the result
+} HintJob;
+
+// Everything the frame loop needs to carry from one frame to the next.
+// Kept in one struct so the loop body can be driven either natively or by the
+// browser's requestAnimationFrame via emscripten_set_main_loop_arg.
+typedef struct {
+  CountryDatabase *db;
+  GameState game;
+
+  // 3D camera
+  Camera3D camera;
+  float cameraDistance;  // Zoom distance
+
+  // Globe
+  Texture2D earthTex;
+  GlobeLod globe;         // Adaptive level-of-detail globe mesh
+  Matrix globeTransform;  // Current globe orientation
+
+  // Arcball rotation state
+  bool isDragging;
+  Vector3 dragStartDir;       // u0: initial contact direction from sphere center
+  Matrix dragStartTransform;  // R0: globe orientation when drag started
+  Vector2 pressPos;           // Where the left button went down (click detection)
+
+  // Picking
+  PickIndex *pick;              // Built once all geometry is loaded
+  CountryData *hoveredCountry;  // Country under the cursor this frame
 
-  // Load a better quality font from the default font but at higher resolution
-  // This creates a smoother font texture
-  Font customFont = LoadFontEx("", 72, 0, 250);
-  if (customFont.texture.id == 0) {
-    // Fallback: Generate font from default with anti-aliasing
-    customFont = GetFontDefault();
+  // Search results
+  CountryData *searchResults[20];
+  int searchResultCount;
+  int selectedSearchResult;
+
+  // Mode selection state
+  bool modeSelectionActive;
+  int selectedMode;
+
+  // Hints (F1)
+  DistanceTable hintTable;  // Pairwise distances for the mode being played
+  HintJob hintJobs[HINT_JOBS_IN_FLIGHT];  // Border pairs out with the distance workers
+  int hintJobCount;
+  TableFields hintFields;   // Border distances when there are no workers
+  bool showHint;
+  bool hintValid;           // hint matches hintGuesses/hintResolved
+  SolverHint hint;
+  int hintGuesses;          // Guess count the cached hint was computed for
+  int hintResolved;         // ... and how many of those had distances
+
+  // Heat map (F2)
+  bool showHeatMap;
+  HeatMap heat;
+
+  // Guessed countries are colored through the country map's palette
+  CountryMap countryMap;
+  const CountryData *paletteMystery;  // Round, resolved guesses and closest
+  int paletteResolved;                // guess the palette was last built for
+  int paletteClosest;
+
+  // Idle frame skipping: frames are only drawn when something changed
+  bool dirty;           // Set by anything that changes what is on screen
+  double lastDrawTime;  // inputTime() of the last drawn frame
+  int shownSeconds;     // Timer value on screen
+  int hintPercent;      // Hint table progress on screen
+  Vector2 lastMouse;
+
+  // Labels and search buffers for the current frame; reset after EndDrawing
+  ScratchArena scratch;
+
+  // Instrumentation
+  bool showStats;     // F3 toggles the stats overlay
+  RenderStats stats;  // Counters for the current frame
+  bool replayDone;    // The replayed recording has run out of frames
+  bool allocCheck;    // --alloc-check: steady frames must not allocate
+  int framesDrawn;
+
+#ifdef PLATFORM_WEB
+  DatasetStream stream;  // Dataset and texture download progress
+  uint32_t shownChunks;  // Geometry chunks counted on the mode menu
+#else
+  bool watching;       // --watch: reload edited rows of the CSV
+  DatasetWatch watch;
+#endif
+} AppState;
+
+// A guess's color, brighter for the closest guess while the round is on
+static Color guessColor(const GameState *game, int i) {
+  Color color = game->guesses[i].color;
+  if (i == game->closestGuessIndex && !game->won) {
+    color.r = (color.r + 255) / 2;
+    color.g = (color.g + 255) / 2;
+    color.b = (color.b + 255) / 2;
   }
-  GenTextureMipmaps(&customFont.texture);
-  SetTextureFilter(customFont.texture, TEXTURE_FILTER_BILINEAR);
+  return color;
+}
 
-  // Load country database
-  printf("Loading country database...\n");
-  CountryDatabase *db = loadCountryDatabase("./coordinates/ccc.csv");
-  if (!db) {
-    printf("Failed to load country database!\n");
-    CloseWindow();
-    return 1;
+// Rasterize the loaded countries into the globe's id map (needs geometry)
+static void rebuildCountryMap(AppState *state) {
+  unloadCountryMap(&state->countryMap);
+  if (!loadCountryMap(&state->countryMap, state->db)) {
+    printf("Warning: country map unavailable, outlining guesses instead\n");
   }
+  attachCountryMap(&state->countryMap, &state->globe);
+  state->paletteResolved = -1;  // Recolor on the next frame
+  state->dirty = true;
+}
 
-  // Initialize game
-  GameState game;
-  initGame(&game, db);
-  // Mystery country will be selected after mode selection
+// Recolor the palette when a guess resolves, the closest guess changes or a
+// round starts; otherwise guessed countries cost nothing per frame
+static void updateCountryPalette(AppState *state) {
+  const GameState *game = &state->game;
+  bool playing = !state->modeSelectionActive && game->mysteryCountry != NULL;
+  int resolved = 0;
+  for (int i = 0; playing && i < game->guessCount; i++) {
+    if (!game->guesses[i].pending) resolved++;
+  }
+  int closest = game->won ? -1 : game->closestGuessIndex;
+  state->stats.countriesShaded = resolved;
+  if (game->mysteryCountry == state->paletteMystery && resolved == state->paletteResolved &&
+      closest == state->paletteClosest) {
+    return;
+  }
+  state->paletteMystery = game->mysteryCountry;
+  state->paletteResolved = resolved;
+  state->paletteClosest = closest;
+
+  clearCountryColors(&state->countryMap);
+  for (int i = 0; playing && i < game->guessCount; i++) {
+    if (game->guesses[i].pending) {
+      continue;  // Shaded once its distance is known
+    }
+    Color color = guessColor(game, i);
+    color.a = GUESS_FILL_ALPHA;
+    setCountryColor(&state->countryMap, (uint32_t)(game->guesses[i].country - state->db->countries),
+                    color);
+  }
+  uploadCountryColors(&state->countryMap);
+  state->stats.paletteUploads++;
+  state->dirty = true;
+}
 
-  // Setup 3D camera
-  Camera3D camera = {0};
-  float cameraDistance = 5.0f;  // Initial zoom distance
-  camera.position = (Vector3){-cameraDistance, 0.0f, 0.0f};
-  camera.target = (Vector3){0.0f, 0.0f, 0.0f};
-  camera.up = (Vector3){0.0f, 1.0f, 0.0f};
-  camera.fovy = 45.0f;
-  camera.projection = CAMERA_PERSPECTIVE;
+#ifdef PLATFORM_WEB
+// Pick up whatever the dataset stream has delivered since the last frame
+static void pollDatasetStream(AppState *state) {
+  if (!state->db && state->stream.db) {
+    state->db = state->stream.db;
+    initGame(&state->game, state->db);
+    state->dirty = true;
+  }
+  if (!state->pick && isDatasetGeometryComplete(&state->stream)) {
+    state->pick = buildPickIndex(state->db);
+    rebuildCountryMap(state);
+  }
+  if (state->stream.chunksLoaded != state->shownChunks) {
+    state->shownChunks = state->stream.chunksLoaded;
+    state->dirty = true;  // Loading progress is shown on the mode menu
+  }
 
-  // Load earth texture
-  // earth2.jpg is 4096x8192 (1:2 portrait ratio)
-  // This matches par_shapes UV mapping which swaps U/V from standard equirectangular
-  Image img = LoadImage("earth2.jpg");
-  Texture2D earthTex = LoadTextureFromImage(img);
-  UnloadImage(img);
+  int size = 0;
+  unsigned char *data = takeStreamedTexture(&state->stream, &size);
+  if (data) {
+    Image img = LoadImageFromMemory(".jpg", data, size);
+    free(data);
+    if (img.data) {
+      UnloadTexture(state->earthTex);
+      state->earthTex = LoadTextureFromImage(img);
+      setGlobeLodTexture(&state->globe, state->earthTex);
+      UnloadImage(img);
+      state->dirty = true;
+    }
+  }
+}
+#endif
+
+#ifndef PLATFORM_WEB
+// Build what needs every country's rings once the background decode is done
+static void pollGeometryPrefetch(AppState *state) {
+  if (state->pick || isGeometryPrefetchRunning()) {
+    return;
+  }
+  printGeometryQuantization(state->db);
+  state->pick = buildPickIndex(state->db);
+  rebuildCountryMap(state);
+}
 
-  // Create globe model
-  Mesh sphere = GenMeshSphere(GLOBE_RADIUS, 128, 128);
-  Model globe = LoadModelFromMesh(sphere);
-  globe.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = earthTex;
+// Swap in an edited dataset between rounds; a round in progress keeps the
+// snapshot it started with. Jobs still out with the distance workers may
+// point at countries the swap frees, so it also waits for those.
+static void updateDatasetWatch(AppState *state) {
+  if (!state->watching || !pollDatasetWatch(&state->watch, GetTime())) {
+    return;
+  }
+  if (!state->modeSelectionActive || countOutstandingDistanceJobs() > 0) {
+    return;
+  }
 
-  // Globe rotation - store the complete transformation matrix
-  Matrix M0 = MatrixRotateX(DEG2RAD * 270.0f);
-  Matrix globeTransform = M0;  // Current globe orientation
+  // Distances between unchanged countries carry over to the new snapshot
+  CountryDatabase *db = state->watch.pending;
+  if (state->hintTable.km) {
+    uint64_t kept = remapDistanceTable(&state->hintTable, db, state->watch.pendingSource);
+    printf("Hint distances: %llu of %llu pairs kept\n", (unsigned long long)kept,
+           (unsigned long long)state->hintTable.pairCount);
+  }
+  clearTableFields(&state->hintFields);  // Border cells are per country index
+  state->db = applyDatasetSnapshot(&state->watch);
+  initGame(&state->game, state->db);
+  clearHeatMap(&state->heat);  // Keyed by country, which may have moved
+  freePickIndex(state->pick);
+  state->pick = buildPickIndex(state->db);
+  rebuildCountryMap(state);
+  state->hoveredCountry = NULL;
+  state->searchResultCount = 0;
+  state->hintValid = false;
+  state->dirty = true;
+  printf("Dataset reloaded: %llu countries\n", (unsigned long long)state->db->count);
+}
+#endif
 
-  // Arcball rotation state
-  bool isDragging = false;
-  Vector3 dragStartDir = {0};   // u0: initial contact direction from sphere center
-  Matrix dragStartTransform = MatrixIdentity();  // R0: globe orientation when drag started
+// Whether a distance mode can be played with the data loaded so far
+// Border mode needs every country's geometry, which streams in last on the web
+static bool isModeReady(AppState *state, DistanceMode mode) {
+  if (!state->db) {
+    return false;
+  }
+#ifdef PLATFORM_WEB
+  if (mode == DISTANCE_MODE_BORDER_TO_BORDER) {
+    return isDatasetGeometryComplete(&state->stream);
+  }
+#endif
+  return true;
+}
 
-  // Search results
-  CountryData *searchResults[20];
-  int searchResultCount = 0;
-  int selectedSearchResult = 0;
+// Guess a country, evaluating border distance on a worker when one is running
+static void submitGuess(AppState *state, CountryData *country) {
+  GameState *game = &state->game;
+  if (game->currentDistanceMode == DISTANCE_MODE_BORDER_TO_BORDER &&
+      distanceWorkersRunning() && !game->won && game->mysteryCountry &&
+      country != game->mysteryCountry && !hasGuessed(game, country)) {
+    uint32_t jobId = submitBorderDistanceJob(country, game->mysteryCountry);
+    makePendingGuess(game, country, jobId);
+  } else {
+    makeGuess(game, country);
+  }
+  state->dirty = true;
 
+  // If game was won, stop the clock (score follows once no guess is pending)
+  if (game->won && game->elapsedTime == 0.0) {
+    game->elapsedTime = inputTime() - game->startTime;
+    if (!hasPendingGuesses(game)) {
+      game->finalScore = calculateScore(game);
+    }
+  }
+}
 
-  // Mode selection state
-  bool modeSelectionActive = true;
-  int selectedMode = 1; // Default to Border-to-Border (index 1)
+// Country under the mouse cursor, or NULL over open water or off the globe
+static CountryData *countryUnderCursor(AppState *state) {
+  if (!state->pick) {
+    return NULL;
+  }
+  Ray mouseRay = GetScreenToWorldRay(inputMousePosition(), state->camera);
+  Vector3 hitPoint;
+  if (!raySphereIntersect(mouseRay.position, mouseRay.direction, GLOBE_RADIUS, &hitPoint)) {
+    return NULL;
+  }
+  Vector3 local = Vector3Transform(hitPoint, MatrixInvert(state->globeTransform));
+  GeoPoint p = sphereToLatLon(local);
+  return pickCountryAt(state->pick, p.lat, p.lon);
+}
 
-  // Main game loop
-  while (!WindowShouldClose()) {
-    // Mouse wheel zoom (works with trackpad pinch on macOS)
-    float wheelMove = GetMouseWheelMove();
-    if (wheelMove != 0) {
-      cameraDistance -= wheelMove * 0.2f;  // Zoom in/out
-      // Clamp camera distance (min 2.0, max 10.0)
-      if (cameraDistance < 2.0f) cameraDistance = 2.0f;
-      if (cameraDistance > 10.0f) cameraDistance = 10.0f;
-    }
-
-    // Arcball rotation system
-    // On mouse press: cast ray, find sphere intersection, store initial state
-    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-      Vector2 mousePos = GetMousePosition();
-      Ray mouseRay = GetScreenToWorldRay(mousePos, camera);
-
-      Vector3 hitPoint;
-      if (raySphereIntersect(mouseRay.position, mouseRay.direction, GLOBE_RADIUS, &hitPoint)) {
-        isDragging = true;
-        dragStartDir = Vector3Normalize(hitPoint);  // u0: direction in world space
-        dragStartTransform = globeTransform;         // R0: save current orientation
+// File a finished hint pair in the table; false if the job was a guess
+static bool resolveHintJob(AppState *state, const DistanceResult *result) {
+  for (int i = 0; i < state->hintJobCount; i++) {
+    HintJob *job = &state->hintJobs[i];
+    if (job->jobId == result->jobId) {
+      if (!job->stale) {
+        completeTablePair(&state->hintTable, job->a, job->b, result->distance);
       }
+      *job = state->hintJobs[--state->hintJobCount];
+      return true;
     }
+  }
+  return false;
+}
 
-    // On mouse drag: compute rotation from u0 to u1
-    if (isDragging && IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
-      Vector2 mousePos = GetMousePosition();
-      Ray mouseRay = GetScreenToWorldRay(mousePos, camera);
-
-      Vector3 hitPoint;
-      if (raySphereIntersect(mouseRay.position, mouseRay.direction, GLOBE_RADIUS, &hitPoint)) {
-        Vector3 currentDir = Vector3Normalize(hitPoint);  // u1: current direction
+// Post distances finished on workers back into the game
+static void pollDistanceResults(AppState *state) {
+  DistanceResult results[16];
+  int count;
+  while ((count = collectDistanceResults(results, 16)) > 0) {
+    for (int i = 0; i < count; i++) {
+      if (!resolveHintJob(state, &results[i])) {
+        resolvePendingGuess(&state->game, results[i].jobId, results[i].distance);
+      }
+    }
+    state->dirty = true;
+  }
 
-        // Compute rotation from dragStartDir (u0) to currentDir (u1)
-        float dot = Vector3DotProduct(dragStartDir, currentDir);
-        // Clamp dot product to avoid NaN from acos
-        if (dot > 1.0f) dot = 1.0f;
-        if (dot < -1.0f) dot = -1.0f;
+  // Score once every guess has its distance
+  if (state->game.won && state->game.finalScore == 0 &&
+      !hasPendingGuesses(&state->game)) {
+    state->game.finalScore = calculateScore(&state->game);
+    state->dirty = true;
+  }
+}
 
-        float angle = acosf(dot);
+// Keep the hint table on the mode being played, filling it once the hint has
+// been asked for. Centroid pairs are cheap enough to fill a slice per frame.
+// Border pairs go to the distance workers a few at a time, so a guess never
+// queues behind more than HINT_JOBS_IN_FLIGHT of them; without workers (the
+// single-threaded web build) they come from distance fields, one row per frame.
+static void updateHintTable(AppState *state) {
+  if (!state->showHint || state->modeSelectionActive || !state->game.mysteryCountry) {
+    return;
+  }
+  DistanceTable *table = &state->hintTable;
+  if (!table->km || table->mode != state->game.currentDistanceMode) {
+    if (table->km) {
+      freeDistanceTable(table);
+    }
+    for (int i = 0; i < state->hintJobCount; i++) {
+      state->hintJobs[i].stale = true;
+    }
+    clearTableFields(&state->hintFields);
+    initDistanceTable(table, state->db, state->game.currentDistanceMode);
+    state->hintValid = false;
+  }
+  if (table->ready) {
+    return;
+  }
 
-        if (angle > 0.0001f) {
-          // Rotation axis: cross(u0, u1) gives axis perpendicular to both
-          // This rotates FROM u0 TO u1
-          Vector3 axis = Vector3CrossProduct(dragStartDir, currentDir);
-          float axisLen = Vector3Length(axis);
+  if (table->mode == DISTANCE_MODE_CENTROID) {
+    advanceDistanceTable(table, HINT_BUILD_BUDGET);
+  } else if (distanceWorkersRunning()) {
+    uint32_t a, b;
+    while (state->hintJobCount < HINT_JOBS_IN_FLIGHT && nextTablePair(table, &a, &b)) {
+      uint32_t jobId = submitBorderDistanceJob(&state->db->countries[a],
+                                               &state->db->countries[b]);
+      state->hintJobs[state->hintJobCount++] = (HintJob){jobId, a, b, false};
+    }
+  } else {
+    advanceDistanceTableFields(table, &state->hintFields, HINT_BUILD_BUDGET);
+  }
+}
 
-          if (axisLen > 0.0001f) {
-            axis = Vector3Scale(axis, 1.0f / axisLen);  // Normalize
+// Hot cells as translucent quads just above the globe: red where every guess
+// fits, fading to clear yellow at HEAT_RANGE_KM
+static void drawHeatMap(AppState *state) {
+  const HeatMap *heat = &state->heat;
+  const HeatCell *cells = HeatCellArray_data(&heat->cells);
+  float half = heat->grid.cellDegrees * 0.5f;
+  float radius = GLOBE_RADIUS + HEAT_MAP_LIFT;
 
-            // Build rotation matrix Q that rotates u0 toward u1
-            Matrix Q = MatrixRotate(axis, angle);
+  rlDisableBackfaceCulling();
+  rlBegin(RL_TRIANGLES);
+  for (uint32_t i = 0; i < heat->cells.size; i++) {
+    GeoPoint c = fieldCellCenter(&heat->grid, cells[i].cell);
+    float t = cells[i].misfit / HEAT_RANGE_KM;
+    rlColor4ub(255, (unsigned char)(40 + 200 * t), 0, (unsigned char)(170 * (1.0f - t)));
+    Vector3 nw = latLonToSphere(c.lat + half, c.lon - half, radius);
+    Vector3 ne = latLonToSphere(c.lat + half, c.lon + half, radius);
+    Vector3 sw = latLonToSphere(c.lat - half, c.lon - half, radius);
+    Vector3 se = latLonToSphere(c.lat - half, c.lon + half, radius);
+    rlVertex3f(nw.x, nw.y, nw.z);
+    rlVertex3f(sw.x, sw.y, sw.z);
+    rlVertex3f(se.x, se.y, se.z);
+    rlVertex3f(nw.x, nw.y, nw.z);
+    rlVertex3f(se.x, se.y, se.z);
+    rlVertex3f(ne.x, ne.y, ne.z);
+  }
+  rlEnd();
+  rlEnableBackfaceCulling();
+}
 
-            // New orientation: R = R0 * Q
-            // Post-multiply: apply Q in the rotated frame of R0
-            globeTransform = MatrixMultiply(dragStartTransform, Q);
-          }
-        }
-      }
-      // If mouse moves off sphere, keep the last valid transform (don't update)
+// Hint line, bottom center; recomputed only when a guess comes in or resolves
+static void drawHint(AppState *state) {
+  const DistanceTable *table = &state->hintTable;
+  ScratchArena *scratch = &state->scratch;
+  const char *text;
+  if (!table->ready) {
+    text = scratchFormat(scratch, "Hint: preparing distances... %d%%",
+                         (int)(getDistanceTableProgress(table) * 100.0f));
+  } else {
+    int resolved = 0;
+    for (int i = 0; i < state->game.guessCount; i++) {
+      resolved += !state->game.guesses[i].pending;
+    }
+    if (!state->hintValid || state->hintGuesses != state->game.guessCount ||
+        state->hintResolved != resolved) {
+      state->hint = getGameHint(table, &state->game);
+      state->hintGuesses = state->game.guessCount;
+      state->hintResolved = resolved;
+      state->hintValid = true;
+    }
+    if (state->hint.country < 0) {
+      text = "Hint: no country fits every distance";
+    } else {
+      text = scratchFormat(scratch, "Hint: try %s (%u possible, ~%.1f left after)",
+                           state->db->countries[state->hint.country].englishName,
+                           state->hint.candidates, state->hint.expectedRemaining);
     }
+  }
 
-    // On mouse release: end dragging
-    if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
-      isDragging = false;
+  Vector2 size = measureUiText(text, 26);
+  float x = (SCREEN_WIDTH - size.x) / 2.0f;
+  float y = SCREEN_HEIGHT - 60;
+  DrawRectangle(x - 10, y - 6, size.x + 20, size.y + 12, Fade(BLACK, 0.6f));
+  drawUiText(text, (Vector2){x, y}, 26, WHITE);
+}
+
+// Frame timing and render counters, bottom-left corner
+static void drawStatsOverlay(AppState *state) {
+  const GlobeLodStats *lod = &state->globe.stats;
+  const double mb = 1024.0 * 1024.0;
+  ScratchArena *scratch = &state->scratch;
+
+  const int memTagsSize = 256;
+  char *memTags = scratchAlloc(scratch, memTagsSize);
+  int len = snprintf(memTags, memTagsSize, " ");
+  for (int i = 0; i < MEM_TAG_COUNT && len < memTagsSize; i++) {
+    MemTagStats s = getMemTagStats((MemTag)i);
+    if (s.bytes > 0) {
+      len += snprintf(memTags + len, memTagsSize - len, " %s %.1f",
+                      getMemTagName((MemTag)i), s.bytes / mb);
     }
+  }
 
+  UiTextStats text = getUiTextStats();
+  const char *lines[] = {
+    scratchFormat(scratch, "FPS: %d (%.2f ms)", GetFPS(), GetFrameTime() * 1000.0f),
+    scratchFormat(scratch, "Globe: %d patches, %d tris (%d culled, %d cached)",
+                  lod->patchesDrawn, lod->triangles, lod->patchesCulled, lod->patchesCached),
+    scratchFormat(scratch, "Countries: %d shaded, %d palette uploads (%s)",
+                  state->stats.countriesShaded, state->stats.paletteUploads,
+                  state->countryMap.loaded ? "country map" : "outline fallback"),
+    scratchFormat(scratch, "Outlines: %d rings drawn, %d culled", state->stats.ringsDrawn,
+                  state->stats.ringsCulled),
+    scratchFormat(scratch, "Text: %d labels cached, %d reused, %d laid out", text.labelsCached,
+                  text.hits, text.layouts),
+    scratchFormat(scratch, "Memory: %.1f MB tracked (peak %.1f), peak RSS %.1f MB",
+                  getMemTotalBytes() / mb, getMemPeakBytes() / mb, getPeakRss() / mb),
+    memTags,
+  };
+  const int lineCount = sizeof(lines) / sizeof(lines[0]);
 
-    // Mode selection input
-    if (modeSelectionActive) {
-      if (IsKeyPressed(KEY_UP) || IsKeyPressed(KEY_DOWN)) {
-        selectedMode = (selectedMode + 1) % DISTANCE_MODE_COUNT;
-      }
-      if (IsKeyPressed(KEY_ENTER)) {
-        game.currentDistanceMode = (DistanceMode)selectedMode;
-        modeSelectionActive = false;
-        selectRandomMysteryCountry(&game);  // Select mystery country after mode choice
-        game.startTime = GetTime();  // Start the timer
-        const char *modeNames[] = {"Centroid", "Border-to-Border"};
-        printf("Distance mode selected: %s\n", modeNames[game.currentDistanceMode]);
+  int y = SCREEN_HEIGHT - 10 - lineCount * 24;
+  DrawRectangle(5, y - 5, 640, lineCount * 24 + 10, Fade(BLACK, 0.6f));
+  for (int i = 0; i < lineCount; i++) {
+    drawUiText(lines[i], (Vector2){10, y + i * 24}, 20, WHITE);
+  }
+}
+
+// --alloc-check: once warmed up, a frame with no input, no new distances
+// and nothing left loading or refining must be drawn from memory set up
+// earlier. Only this thread's allocations count; workers allocate freely.
+static void checkFrameAllocations(AppState *state, uint64_t allocs) {
+  bool steady = inputIdle() && state->stats.paletteUploads == 0 &&
+                !state->globe.stats.refining && state->pick != NULL &&
+                (!state->hintTable.km || state->hintTable.ready);
+  state->framesDrawn++;
+  if (steady && state->framesDrawn > ALLOC_CHECK_WARMUP && allocs > 0) {
+    fprintf(stderr, "Alloc check: frame %d made %llu heap allocations in a steady state\n",
+            state->framesDrawn, (unsigned long long)allocs);
+    abort();
+  }
+}
+
+// The globe, guessed countries and UI for the current state; the caller
+// owns the target (the window, or the benchmark's render texture)
+static void drawFrame(AppState *state) {
+  ScratchArena *scratch = &state->scratch;
+  ClearBackground(RAYWHITE);
+
+  // Update camera position based on zoom
+  state->camera.position = (Vector3){-state->cameraDistance, 0.0f, 0.0f};
+
+  // Draw 3D globe
+  BeginMode3D(state->camera);
+
+  // Draw globe with the current globe transform
+  drawGlobeLod(&state->globe, state->camera, state->globeTransform);
+
+  // Apply the same rotation transform for country rendering
+  rlPushMatrix();
+  rlMultMatrixf(MatrixToFloat(state->globeTransform));
+
+  // Guessed countries are shaded by the globe shader; without it, outline them
+  state->stats.ringsDrawn = 0;
+  state->stats.ringsCulled = 0;
+  if (!state->modeSelectionActive && state->game.mysteryCountry != NULL) {
+    ViewCull cull;
+    setupViewCull(&cull, state->camera, state->globeTransform, GLOBE_RADIUS);
+
+    for (int i = 0; !state->countryMap.loaded && i < state->game.guessCount; i++) {
+      if (!state->game.guesses[i].pending) {
+        drawCountryOutline(state->game.guesses[i].country, GLOBE_RADIUS + HOVER_OUTLINE_LIFT,
+                           COUNTRY_SCALE_FACTOR, guessColor(&state->game, i), &cull,
+                           &state->stats);
       }
     }
 
-    // Auto-activate search when typing (only when not in mode selection)
-    if (!modeSelectionActive && !game.searchActive) {
-      int key = GetCharPressed();
-      if (key >= 32 && key <= 125) {
-        game.searchActive = true;
-        game.searchTextLength = 0;
-        game.searchText[0] = '\0';
-        searchResultCount = 0;
-        selectedSearchResult = 0;
-
-        // Add the first character
-        game.searchText[game.searchTextLength++] = (char)key;
-        game.searchText[game.searchTextLength] = '\0';
-        searchResultCount = filterCountries(db, game.searchText,
-                                           searchResults, 20);
-      }
+    if (state->showHeatMap) {
+      drawHeatMap(state);
     }
 
-    // Handle search input (only when game is started, not in mode selection)
-    if (game.searchActive && !modeSelectionActive) {
-      // Get character input
-      int key = GetCharPressed();
-      while (key > 0) {
-        if (key >= 32 && key <= 125 && game.searchTextLength < 99) {
-          game.searchText[game.searchTextLength++] = (char)key;
-          game.searchText[game.searchTextLength] = '\0';
+    // Outline the country under the cursor just above the heat map
+    if (state->hoveredCountry) {
+      drawCountryOutline(state->hoveredCountry, GLOBE_RADIUS + HOVER_OUTLINE_LIFT,
+                         COUNTRY_SCALE_FACTOR, WHITE, &cull, &state->stats);
+    }
+  }
 
-          // Update search results
-          searchResultCount = filterCountries(db, game.searchText,
-                                             searchResults, 20);
-          selectedSearchResult = 0;
-        }
-        key = GetCharPressed();
-      }
+  rlPopMatrix();  // Restore previous transform
 
-      // Backspace
-      if (IsKeyPressed(KEY_BACKSPACE) && game.searchTextLength > 0) {
-        game.searchTextLength--;
-        game.searchText[game.searchTextLength] = '\0';
-        searchResultCount = filterCountries(db, game.searchText,
-                                           searchResults, 20);
-        selectedSearchResult = 0;
-      }
+  EndMode3D();
 
-      // ESC to clear search text
-      if (IsKeyPressed(KEY_ESCAPE)) {
-        game.searchTextLength = 0;
-        game.searchText[0] = '\0';
-        searchResultCount = 0;
-        selectedSearchResult = 0;
-      }
+  // Draw UI (text and shapes share the SDF shader and atlas from here on)
+  beginUiText();
+  const int uiMargin = 10;
+  const int uiWidth = 300;
 
-      // Navigate search results
-      if (IsKeyPressed(KEY_DOWN) && searchResultCount > 0) {
-        selectedSearchResult = (selectedSearchResult + 1) % searchResultCount;
-      }
-      if (IsKeyPressed(KEY_UP) && searchResultCount > 0) {
-        selectedSearchResult = (selectedSearchResult - 1 + searchResultCount) %
-                               searchResultCount;
-      }
+  // Title
+  drawUiText("GLOBLE GAME", (Vector2){uiMargin, uiMargin}, 48, DARKBLUE);
+  drawUiText("Guess the mystery country!", (Vector2){uiMargin, uiMargin + 55}, 28, GRAY);
 
-      // Select country
-      if (IsKeyPressed(KEY_ENTER) && searchResultCount > 0) {
-        makeGuess(&game, searchResults[selectedSearchResult]);
+  // Distance mode and timer display (only show if not in mode selection)
+  if (!state->modeSelectionActive && state->game.mysteryCountry != NULL) {
+    const char *modeNames[] = {"Centroid", "Border-to-Border"};
+    drawUiText(scratchFormat(scratch, "Mode: %s", modeNames[state->game.currentDistanceMode]),
+             (Vector2){uiMargin, uiMargin + 90}, 24, DARKGRAY);
 
-        // If game was won, calculate score
-        if (game.won && game.finalScore == 0) {
-          game.elapsedTime = GetTime() - game.startTime;
-          game.finalScore = calculateScore(&game);
-        }
+    // Show timer (only when game is active)
+    if (!state->game.won) {
+      double currentTime = inputTime() - state->game.startTime;
+      int minutes = (int)(currentTime / 60.0);
+      int seconds = (int)currentTime % 60;
+      drawUiText(scratchFormat(scratch, "Time: %d:%02d", minutes, seconds),
+               (Vector2){uiMargin, uiMargin + 120}, 24, DARKGRAY);
+    } else {
+      // Show final time when won
+      int minutes = (int)(state->game.elapsedTime / 60.0);
+      int seconds = (int)state->game.elapsedTime % 60;
+      drawUiText(scratchFormat(scratch, "Time: %d:%02d", minutes, seconds),
+               (Vector2){uiMargin, uiMargin + 120}, 24, DARKGREEN);
+    }
+  }
 
-        game.searchActive = false;
-        game.searchTextLength = 0;
-        game.searchText[0] = '\0';
-        searchResultCount = 0;
+  // Mode selection screen
+  if (state->modeSelectionActive) {
+    int boxWidth = 500;
+    int boxHeight = 300;
+    int boxX = (SCREEN_WIDTH - boxWidth) / 2;
+    int boxY = (SCREEN_HEIGHT - boxHeight) / 2;
+
+    // Semi-transparent background overlay
+    DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, (Color){0, 0, 0, 150});
+
+    // Mode selection box
+    DrawRectangle(boxX, boxY, boxWidth, boxHeight, WHITE);
+    DrawRectangleLines(boxX, boxY, boxWidth, boxHeight, DARKBLUE);
+
+    // Title
+    drawUiText("SELECT DISTANCE MODE", (Vector2){boxX + 80, boxY + 20}, 34, DARKBLUE);
+
+    // Mode options
+    const char *modeNames[] = {"Centroid", "Border-to-Border"};
+    const char *modeDescriptions[] = {
+      "Distance from country center to center",
+      "Distance from closest borders"
+    };
+
+    for (int i = 0; i < DISTANCE_MODE_COUNT; i++) {
+      int optionY = boxY + 80 + i * 80;
+      Color bgColor = (i == state->selectedMode) ? SKYBLUE : LIGHTGRAY;
+      Color textColor = (i == state->selectedMode) ? WHITE : BLACK;
+
+      // Option box
+      DrawRectangle(boxX + 30, optionY, boxWidth - 60, 60, bgColor);
+      DrawRectangleLines(boxX + 30, optionY, boxWidth - 60, 60, DARKGRAY);
+
+      // Mode name
+      drawUiText(modeNames[i], (Vector2){boxX + 40, optionY + 10}, 28, textColor);
+      // Mode description
+      const char *description = modeDescriptions[i];
+#ifdef PLATFORM_WEB
+      if (!state->db) {
+        description = state->stream.failed ? "Failed to load countries" : "Loading countries...";
+      } else if (!isModeReady(state, (DistanceMode)i)) {
+        description = scratchFormat(scratch, "Loading borders... (%u/%u)",
+                                    state->stream.chunksLoaded, state->stream.chunkCount);
       }
+#endif
+      drawUiText(description, (Vector2){boxX + 40, optionY + 35}, 20, textColor);
     }
 
-    // Restart game when ENTER is pressed on win screen
-    if (game.won && IsKeyPressed(KEY_ENTER)) {
-      // Reset game state and return to mode selection
-      initGame(&game, db);
-      modeSelectionActive = true;
-      selectedMode = 1; // Reset to default Border-to-Border
+    // Instructions
+    drawUiText("Use UP/DOWN to select, ENTER to confirm", (Vector2){boxX + 70, boxY + 260}, 22, DARKGRAY);
+  }
+
+  // Instructions
+  if (!state->game.searchActive && state->game.guessCount == 0 && !state->modeSelectionActive) {
+    drawUiText("Start typing to guess", (Vector2){uiMargin, uiMargin + 160}, 24, DARKGRAY);
+    drawUiText("Drag mouse to rotate globe", (Vector2){uiMargin, uiMargin + 190}, 24, DARKGRAY);
+    drawUiText("Press F1 for a hint, F2 for a heat map", (Vector2){uiMargin, uiMargin + 220}, 24,
+               DARKGRAY);
+  }
+
+  // Search box
+  if (state->game.searchActive) {
+    DrawRectangle(uiMargin, 160, uiWidth, 55, WHITE);
+    DrawRectangleLines(uiMargin, 160, uiWidth, 55, BLUE);
+    drawUiText(state->game.searchText, (Vector2){uiMargin + 10, 170}, 28, BLACK);
+    drawUiText("Type country name (ESC to clear)", (Vector2){uiMargin, 220}, 20, GRAY);
+
+    // Search results dropdown
+    if (state->searchResultCount > 0) {
+      int dropdownHeight = state->searchResultCount * 40 + 10;
+      DrawRectangle(uiMargin, 250, uiWidth, dropdownHeight, WHITE);
+      DrawRectangleLines(uiMargin, 250, uiWidth, dropdownHeight, DARKGRAY);
+
+      for (int i = 0; i < state->searchResultCount; i++) {
+        Color bgColor = (i == state->selectedSearchResult) ? LIGHTGRAY : WHITE;
+        DrawRectangle(uiMargin + 5, 255 + i * 40, uiWidth - 10, 38, bgColor);
+        drawUiText(state->searchResults[i]->englishName, (Vector2){uiMargin + 10, 260 + i * 40},
+                 24, BLACK);
+      }
     }
+  }
 
-    // Render
-    BeginDrawing();
-    ClearBackground(RAYWHITE);
+  // Guess history (right side) - sorted by distance (only show if game started)
+  if (!state->modeSelectionActive && state->game.mysteryCountry != NULL) {
+    int historyX = SCREEN_WIDTH - uiWidth - uiMargin;
+    int historyY = uiMargin;
 
-    // Update camera position based on zoom
-    camera.position = (Vector3){-cameraDistance, 0.0f, 0.0f};
+    drawUiText("GUESSES", (Vector2){historyX, historyY}, 32, DARKBLUE);
+    drawUiText(scratchFormat(scratch, "Total: %d", state->game.guessCount),
+               (Vector2){historyX, historyY + 40}, 24, GRAY);
 
-    // Draw 3D globe
-    BeginMode3D(camera);
+  // Create sorted index array (sort by distance, ascending)
+  int sortedIndices[MAX_GUESSES];
+  for (int i = 0; i < state->game.guessCount; i++) {
+    sortedIndices[i] = i;
+  }
 
-    // Apply the current globe transform
-    globe.transform = globeTransform;
+  // Simple selection sort by distance (pending guesses last)
+  float sortKeys[MAX_GUESSES];
+  for (int i = 0; i < state->game.guessCount; i++) {
+    sortKeys[i] = state->game.guesses[i].pending ? FLT_MAX : state->game.guesses[i].distance;
+  }
+  for (int i = 0; i < state->game.guessCount - 1; i++) {
+    for (int j = i + 1; j < state->game.guessCount; j++) {
+      if (sortKeys[sortedIndices[j]] < sortKeys[sortedIndices[i]]) {
+        int temp = sortedIndices[i];
+        sortedIndices[i] = sortedIndices[j];
+        sortedIndices[j] = temp;
+      }
+    }
+  }
 
-    // Draw globe
-    DrawModel(globe, (Vector3){0, 0, 0}, 1.0f, WHITE);
+  int displayCount = state->game.guessCount > 12 ? 12 : state->game.guessCount;
+  for (int i = 0; i < displayCount; i++) {
+    int idx = sortedIndices[i]; // Show sorted by distance (closest first)
+    int yPos = historyY + 75 + i * 48;
 
-    // Apply the same rotation transform for country rendering
-    rlPushMatrix();
-    rlMultMatrixf(MatrixToFloat(globeTransform));
+    // Background
+    DrawRectangle(historyX, yPos, uiWidth, 45, state->game.guesses[idx].color);
 
-    // Draw guessed countries (only if game is started)
-    if (!modeSelectionActive && game.mysteryCountry != NULL) {
-      // Keep depth test enabled so countries on back side are hidden
-      // rlDisableDepthTest();
+    // Country name
+    const char *name = state->game.guesses[idx].country->englishName;
+    drawUiText(name, (Vector2){historyX + 5, yPos + 3}, 20, BLACK);
 
-      for (int i = 0; i < game.guessCount; i++) {
-      Color drawColor = game.guesses[i].color;
+    // Distance
+    if (state->game.guesses[idx].pending) {
+      drawUiText("Calculating...", (Vector2){historyX + 5, yPos + 26}, 18, DARKGRAY);
+    } else if (state->game.guesses[idx].distance < 1.0f) {
+      drawUiText("CORRECT!", (Vector2){historyX + 5, yPos + 26}, 18, DARKGREEN);
+    } else {
+      drawUiText(scratchFormat(scratch, "%.0f km", state->game.guesses[idx].distance),
+               (Vector2){historyX + 5, yPos + 26}, 18, BLACK);
+    }
 
-      // Make closest guess brighter
-      if (i == game.closestGuessIndex && !game.won) {
-        drawColor.r = (drawColor.r + 255) / 2;
-        drawColor.g = (drawColor.g + 255) / 2;
-        drawColor.b = (drawColor.b + 255) / 2;
-      }
+    // Closest marker
+    if (idx == state->game.closestGuessIndex && !state->game.won) {
+      drawUiText("CLOSEST", (Vector2){historyX + uiWidth - 85, yPos + 13}, 18, DARKBLUE);
+    }
+    }
+  }
 
-      CountryData *country = game.guesses[i].country;
+  // Win message
+  if (state->game.won && state->game.mysteryCountry != NULL) {
+    int msgWidth = 450;
+    int msgHeight = 260;
+    int msgX = (SCREEN_WIDTH - msgWidth) / 2;
+    int msgY = (SCREEN_HEIGHT - msgHeight) / 2;
+
+    DrawRectangle(msgX, msgY, msgWidth, msgHeight, Fade(WHITE, 0.95f));
+    DrawRectangleLines(msgX, msgY, msgWidth, msgHeight, GREEN);
+
+    drawUiText("CONGRATULATIONS!", (Vector2){msgX + 65, msgY + 25}, 42, GREEN);
+    drawUiText(scratchFormat(scratch, "You found %s!", state->game.mysteryCountry->englishName),
+               (Vector2){msgX + 45, msgY + 80}, 26, DARKGREEN);
+    drawUiText(scratchFormat(scratch, "Guesses: %d", state->game.guessCount),
+               (Vector2){msgX + 155, msgY + 115}, 26, DARKGREEN);
+
+    // Display time
+    int minutes = (int)(state->game.elapsedTime / 60.0);
+    int seconds = (int)state->game.elapsedTime % 60;
+    drawUiText(scratchFormat(scratch, "Time: %d:%02d", minutes, seconds),
+               (Vector2){msgX + 155, msgY + 145}, 26, DARKGREEN);
+
+    // Display score
+    drawUiText(scratchFormat(scratch, "SCORE: %d / 10000", state->game.finalScore),
+               (Vector2){msgX + 100, msgY + 180}, 30, DARKBLUE);
+
+    drawUiText("Press ENTER for next round", (Vector2){msgX + 85, msgY + 220}, 24, DARKGRAY);
+  }
 
-      // TODO: Re-enable filled rendering with optimized triangulation
-      // For now, using only outlines for performance
-      // Color fillColor = drawColor;
-      // fillColor.a = 160;
-      // drawCountryFilled(country, GLOBE_RADIUS, COUNTRY_SCALE_FACTOR, fillColor);
+  // Name of the country under the cursor
+  if (state->hoveredCountry && !state->isDragging) {
+    Vector2 mousePos = inputMousePosition();
+    const char *name = state->hoveredCountry->englishName;
+    Vector2 size = measureUiText(name, 22);
+    DrawRectangle(mousePos.x + 14, mousePos.y + 14, size.x + 12, size.y + 6, Fade(BLACK, 0.6f));
+    drawUiText(name, (Vector2){mousePos.x + 20, mousePos.y + 17}, 22, WHITE);
+  }
 
-      // Draw multiple outline layers with gradient effect
-      // Using more layers to create a "filled" effect (THICC mode)
-      for (int j = 0; j < 40; j++) {
-        float radiusOffset = 0.001f + j * 0.0003f;
+  if (state->showHint && !state->modeSelectionActive && !state->game.won &&
+      state->game.mysteryCountry != NULL) {
+    drawHint(state);
+  }
 
-        // Create gradient: darker at base, brighter at top
-        float t = (float)j / 40.0f;
-        Color layerColor = drawColor;
+  if (state->showStats) {
+    drawStatsOverlay(state);
+  }
 
-        // Darken the inner layers for depth effect
-        float brightness = 0.6f + 0.4f * t;  // Range from 60% to 100%
-        layerColor.r = (uint8_t)(drawColor.r * brightness);
-        layerColor.g = (uint8_t)(drawColor.g * brightness);
-        layerColor.b = (uint8_t)(drawColor.b * brightness);
+  endUiText();
+}
 
-        drawCountryOutline(country, GLOBE_RADIUS + radiusOffset,
-                           COUNTRY_SCALE_FACTOR, layerColor);
-      }
-      }
+// Process input and render a single frame
+// Must return to the caller every frame (no blocking loops) so the browser
+// can drive it without ASYNCIFY
+void UpdateDrawFrame(void *arg) {
+  AppState *state = (AppState *)arg;
+  ScratchArena *scratch = &state->scratch;
+  double frameStart = GetTime();
+  uint64_t allocsAtStart = getThreadAllocCount();
+
+  if (!beginInputFrame()) {
+    state->replayDone = true;
+    return;
+  }
+
+#ifdef PLATFORM_WEB
+  pollDatasetStream(state);
+#else
+  updateDatasetWatch(state);
+  pollGeometryPrefetch(state);
+#endif
+  pollDistanceResults(state);
+
+  state->stats = (RenderStats){0};
+  if (inputKeyPressed(KEY_F3)) {
+    state->showStats = !state->showStats;
+    state->dirty = true;
+  }
+  if (inputKeyPressed(KEY_F1)) {
+    state->showHint = !state->showHint;
+    state->dirty = true;
+  }
+  if (inputKeyPressed(KEY_F2)) {
+    state->showHeatMap = !state->showHeatMap;
+    state->dirty = true;
+  }
+  updateHintTable(state);
+  if (state->showHeatMap && !state->modeSelectionActive &&
+      updateHeatMap(&state->heat, &state->game)) {
+    state->dirty = true;
+  }
+
+  // Mouse wheel zoom (works with trackpad pinch on macOS)
+  float wheelMove = inputMouseWheel();
+  if (wheelMove != 0) {
+    state->cameraDistance -= wheelMove * 0.2f;  // Zoom in/out
+    // Clamp camera distance (min 2.0, max 10.0)
+    if (state->cameraDistance < 2.0f) state->cameraDistance = 2.0f;
+    if (state->cameraDistance > 10.0f) state->cameraDistance = 10.0f;
+    state->dirty = true;
+  }
 
-      // Depth test stays enabled throughout
-      // rlEnableDepthTest();
+  // Arcball rotation system
+  // On mouse press: cast ray, find sphere intersection, store initial state
+  if (inputMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+    Vector2 mousePos = inputMousePosition();
+    Ray mouseRay = GetScreenToWorldRay(mousePos, state->camera);
+    state->pressPos = mousePos;
+
+    Vector3 hitPoint;
+    if (raySphereIntersect(mouseRay.position, mouseRay.direction, GLOBE_RADIUS, &hitPoint)) {
+      state->isDragging = true;
+      state->dragStartDir = Vector3Normalize(hitPoint);  // u0: direction in world space
+      state->dragStartTransform = state->globeTransform;         // R0: save current orientation
     }
+  }
 
-    rlPopMatrix();  // Restore previous transform
+  // On mouse drag: compute rotation from u0 to u1
+  if (state->isDragging && inputMouseButtonDown(MOUSE_BUTTON_LEFT)) {
+    Vector2 mousePos = inputMousePosition();
+    Ray mouseRay = GetScreenToWorldRay(mousePos, state->camera);
 
-    EndMode3D();
+    Vector3 hitPoint;
+    if (raySphereIntersect(mouseRay.position, mouseRay.direction, GLOBE_RADIUS, &hitPoint)) {
+      Vector3 currentDir = Vector3Normalize(hitPoint);  // u1: current direction
 
-    // Draw UI
-    const int uiMargin = 10;
-    const int uiWidth = 300;
+      // Compute rotation from dragStartDir (u0) to currentDir (u1)
+      float dot = Vector3DotProduct(state->dragStartDir, currentDir);
+      // Clamp dot product to avoid NaN from acos
+      if (dot > 1.0f) dot = 1.0f;
+      if (dot < -1.0f) dot = -1.0f;
 
-    // Title
-    DrawTextEx(customFont, "GLOBLE GAME", (Vector2){uiMargin, uiMargin}, 48, 1.0f, DARKBLUE);
-    DrawTextEx(customFont, "Guess the mystery country!", (Vector2){uiMargin, uiMargin + 55}, 28, 1.0f, GRAY);
+      float angle = acosf(dot);
 
-    // Distance mode and timer display (only show if not in mode selection)
-    if (!modeSelectionActive && game.mysteryCountry != NULL) {
-      const char *modeNames[] = {"Centroid", "Border-to-Border"};
-      DrawTextEx(customFont, TextFormat("Mode: %s", modeNames[game.currentDistanceMode]),
-               (Vector2){uiMargin, uiMargin + 90}, 24, 1.0f, DARKGRAY);
-
-      // Show timer (only when game is active)
-      if (!game.won) {
-        double currentTime = GetTime() - game.startTime;
-        int minutes = (int)(currentTime / 60.0);
-        int seconds = (int)currentTime % 60;
-        DrawTextEx(customFont, TextFormat("Time: %d:%02d", minutes, seconds),
-                 (Vector2){uiMargin, uiMargin + 120}, 24, 1.0f, DARKGRAY);
-      } else {
-        // Show final time when won
-        int minutes = (int)(game.elapsedTime / 60.0);
-        int seconds = (int)game.elapsedTime % 60;
-        DrawTextEx(customFont, TextFormat("Time: %d:%02d", minutes, seconds),
-                 (Vector2){uiMargin, uiMargin + 120}, 24, 1.0f, DARKGREEN);
+      if (angle > 0.0001f) {
+        // Rotation axis: cross(u0, u1) gives axis perpendicular to both
+        // This rotates FROM u0 TO u1
+        Vector3 axis = Vector3CrossProduct(state->dragStartDir, currentDir);
+        float axisLen = Vector3Length(axis);
+
+        if (axisLen > 0.0001f) {
+          axis = Vector3Scale(axis, 1.0f / axisLen);  // Normalize
+
+          // Build rotation matrix Q that rotates u0 toward u1
+          Matrix Q = MatrixRotate(axis, angle);
+
+          // New orientation: R = R0 * Q
+          // Post-multiply: apply Q in the rotated frame of R0
+          state->globeTransform = MatrixMultiply(state->dragStartTransform, Q);
+          state->dirty = true;
+        }
       }
     }
+    // If mouse moves off sphere, keep the last valid transform (don't update)
+  }
 
-    // Mode selection screen
-    if (modeSelectionActive) {
-      int boxWidth = 500;
-      int boxHeight = 300;
-      int boxX = (SCREEN_WIDTH - boxWidth) / 2;
-      int boxY = (SCREEN_HEIGHT - boxHeight) / 2;
+  // Hover highlight and click-to-guess (only while a round is in progress)
+  bool canPick = !state->modeSelectionActive && state->game.mysteryCountry != NULL &&
+                 !state->game.won;
+  CountryData *hovered = canPick ? countryUnderCursor(state) : NULL;
+  Vector2 mouse = inputMousePosition();
+  bool mouseMoved = mouse.x != state->lastMouse.x || mouse.y != state->lastMouse.y;
+  if (hovered != state->hoveredCountry || (hovered && mouseMoved)) {
+    state->dirty = true;  // Outline changed or the name label follows the cursor
+  }
+  state->hoveredCountry = hovered;
+  state->lastMouse = mouse;
+
+  // On mouse release: end dragging; a press that barely moved is a click
+  if (inputMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
+    state->isDragging = false;
+    if (state->hoveredCountry &&
+        Vector2Distance(state->pressPos, inputMousePosition()) < CLICK_SLOP) {
+      submitGuess(state, state->hoveredCountry);
+    }
+  }
 
-      // Semi-transparent background overlay
-      DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, (Color){0, 0, 0, 150});
 
-      // Mode selection box
-      DrawRectangle(boxX, boxY, boxWidth, boxHeight, WHITE);
-      DrawRectangleLines(boxX, boxY, boxWidth, boxHeight, DARKBLUE);
+  // Mode selection input
+  if (state->modeSelectionActive) {
+    if (inputKeyPressed(KEY_UP) || inputKeyPressed(KEY_DOWN)) {
+      state->selectedMode = (state->selectedMode + 1) % DISTANCE_MODE_COUNT;
+      state->dirty = true;
+    }
+    if (inputKeyPressed(KEY_ENTER) && isModeReady(state, (DistanceMode)state->selectedMode)) {
+      state->game.currentDistanceMode = (DistanceMode)state->selectedMode;
+      state->modeSelectionActive = false;
+      selectRandomMysteryCountry(&state->game);  // Select mystery country after mode choice
+      state->game.startTime = inputTime();  // Start the timer
+      state->dirty = true;
+      const char *modeNames[] = {"Centroid", "Border-to-Border"};
+      printf("Distance mode selected: %s\n", modeNames[state->game.currentDistanceMode]);
+    }
+  }
 
-      // Title
-      DrawTextEx(customFont, "SELECT DISTANCE MODE", (Vector2){boxX + 80, boxY + 20}, 34, 1.0f, DARKBLUE);
+  // Auto-activate search when typing (only when not in mode selection)
+  if (!state->modeSelectionActive && !state->game.searchActive) {
+    int key = inputCharPressed();
+    if (key >= 32 && key <= 125) {
+      state->game.searchActive = true;
+      state->game.searchTextLength = 0;
+      state->game.searchText[0] = '\0';
+      state->searchResultCount = 0;
+      state->selectedSearchResult = 0;
+
+      // Add the first character
+      state->game.searchText[state->game.searchTextLength++] = (char)key;
+      state->game.searchText[state->game.searchTextLength] = '\0';
+      state->searchResultCount = filterCountries(state->db, state->game.searchText,
+                                                 state->searchResults, 20, &state->scratch);
+      state->dirty = true;
+    }
+  }
 
-      // Mode options
-      const char *modeNames[] = {"Centroid", "Border-to-Border"};
-      const char *modeDescriptions[] = {
-        "Distance from country center to center",
-        "Distance from closest borders"
-      };
-
-      for (int i = 0; i < DISTANCE_MODE_COUNT; i++) {
-        int optionY = boxY + 80 + i * 80;
-        Color bgColor = (i == selectedMode) ? SKYBLUE : LIGHTGRAY;
-        Color textColor = (i == selectedMode) ? WHITE : BLACK;
-
-        // Option box
-        DrawRectangle(boxX + 30, optionY, boxWidth - 60, 60, bgColor);
-        DrawRectangleLines(boxX + 30, optionY, boxWidth - 60, 60, DARKGRAY);
-
-        // Mode name
-        DrawTextEx(customFont, modeNames[i], (Vector2){boxX + 40, optionY + 10}, 28, 1.0f, textColor);
-        // Mode description
-        DrawTextEx(customFont, modeDescriptions[i], (Vector2){boxX + 40, optionY + 35}, 20, 1.0f, textColor);
+  // Handle search input (only when game is started, not in mode selection)
+  if (state->game.searchActive && !state->modeSelectionActive) {
+    // Get character input
+    int key = inputCharPressed();
+    while (key > 0) {
+      if (key >= 32 && key <= 125 && state->game.searchTextLength < 99) {
+        state->game.searchText[state->game.searchTextLength++] = (char)key;
+        state->game.searchText[state->game.searchTextLength] = '\0';
+
+        // Update search results
+        state->searchResultCount = filterCountries(state->db, state->game.searchText,
+                                                   state->searchResults, 20, &state->scratch);
+        state->selectedSearchResult = 0;
+        state->dirty = true;
       }
+      key = inputCharPressed();
+    }
 
-      // Instructions
-      DrawTextEx(customFont, "Use UP/DOWN to select, ENTER to confirm", (Vector2){boxX + 70, boxY + 260}, 22, 1.0f, DARKGRAY);
+    // Backspace
+    if (inputKeyPressed(KEY_BACKSPACE) && state->game.searchTextLength > 0) {
+      state->game.searchTextLength--;
+      state->game.searchText[state->game.searchTextLength] = '\0';
+      state->searchResultCount = filterCountries(state->db, state->game.searchText,
+                                                 state->searchResults, 20, &state->scratch);
+      state->selectedSearchResult = 0;
+      state->dirty = true;
     }
 
-    // Instructions
-    if (!game.searchActive && game.guessCount == 0 && !modeSelectionActive) {
-      DrawTextEx(customFont, "Start typing to guess", (Vector2){uiMargin, uiMargin + 160}, 24, 1.0f, DARKGRAY);
-      DrawTextEx(customFont, "Drag mouse to rotate globe", (Vector2){uiMargin, uiMargin + 190}, 24, 1.0f, DARKGRAY);
-    }
-
-    // Search box
-    if (game.searchActive) {
-      DrawRectangle(uiMargin, 160, uiWidth, 55, WHITE);
-      DrawRectangleLines(uiMargin, 160, uiWidth, 55, BLUE);
-      DrawTextEx(customFont, game.searchText, (Vector2){uiMargin + 10, 170}, 28, 1.0f, BLACK);
-      DrawTextEx(customFont, "Type country name (ESC to clear)", (Vector2){uiMargin, 220}, 20, 1.0f, GRAY);
-
-      // Search results dropdown
-      if (searchResultCount > 0) {
-        int dropdownHeight = searchResultCount * 40 + 10;
-        DrawRectangle(uiMargin, 250, uiWidth, dropdownHeight, WHITE);
-        DrawRectangleLines(uiMargin, 250, uiWidth, dropdownHeight, DARKGRAY);
-
-        for (int i = 0; i < searchResultCount; i++) {
-          Color bgColor = (i == selectedSearchResult) ? LIGHTGRAY : WHITE;
-          DrawRectangle(uiMargin + 5, 255 + i * 40, uiWidth - 10, 38, bgColor);
-          DrawTextEx(customFont, searchResults[i]->englishName, (Vector2){uiMargin + 10, 260 + i * 40},
-                   24, 1.0f, BLACK);
-        }
-      }
+    // ESC to clear search text
+    if (inputKeyPressed(KEY_ESCAPE)) {
+      state->game.searchTextLength = 0;
+      state->game.searchText[0] = '\0';
+      state->searchResultCount = 0;
+      state->selectedSearchResult = 0;
+      state->dirty = true;
     }
 
-    // Guess history (right side) - sorted by distance (only show if game started)
-    if (!modeSelectionActive && game.mysteryCountry != NULL) {
-      int historyX = SCREEN_WIDTH - uiWidth - uiMargin;
-      int historyY = uiMargin;
+    // Navigate search results
+    if (inputKeyPressed(KEY_DOWN) && state->searchResultCount > 0) {
+      state->selectedSearchResult = (state->selectedSearchResult + 1) % state->searchResultCount;
+      state->dirty = true;
+    }
+    if (inputKeyPressed(KEY_UP) && state->searchResultCount > 0) {
+      state->selectedSearchResult = (state->selectedSearchResult - 1 + state->searchResultCount) %
+                             state->searchResultCount;
+      state->dirty = true;
+    }
 
-      DrawTextEx(customFont, "GUESSES", (Vector2){historyX, historyY}, 32, 1.0f, DARKBLUE);
-      DrawTextEx(customFont, TextFormat("Total: %d", game.guessCount), (Vector2){historyX, historyY + 40},
-               24, 1.0f, GRAY);
+    // Select country
+    if (inputKeyPressed(KEY_ENTER) && state->searchResultCount > 0) {
+      submitGuess(state, state->searchResults[state->selectedSearchResult]);
 
-    // Create sorted index array (sort by distance, ascending)
-    int sortedIndices[MAX_GUESSES];
-    for (int i = 0; i < game.guessCount; i++) {
-      sortedIndices[i] = i;
+      state->game.searchActive = false;
+      state->game.searchTextLength = 0;
+      state->game.searchText[0] = '\0';
+      state->searchResultCount = 0;
     }
+  }
 
-    // Simple selection sort by distance
-    for (int i = 0; i < game.guessCount - 1; i++) {
-      for (int j = i + 1; j < game.guessCount; j++) {
-        if (game.guesses[sortedIndices[j]].distance <
-            game.guesses[sortedIndices[i]].distance) {
-          int temp = sortedIndices[i];
-          sortedIndices[i] = sortedIndices[j];
-          sortedIndices[j] = temp;
-        }
-      }
+  // Restart game when ENTER is pressed on win screen
+  if (state->game.won && inputKeyPressed(KEY_ENTER)) {
+    // Reset game state and return to mode selection
+    initGame(&state->game, state->db);
+    state->modeSelectionActive = true;
+    state->selectedMode = 1; // Reset to default Border-to-Border
+    state->dirty = true;
+  }
+
+  // Clock-driven changes: the timer ticks once a second, the hint table
+  // fills in the background, and the LOD globe refines over several frames
+  if (!state->modeSelectionActive && state->game.mysteryCountry && !state->game.won) {
+    int seconds = (int)(inputTime() - state->game.startTime);
+    if (seconds != state->shownSeconds) {
+      state->shownSeconds = seconds;
+      state->dirty = true;
+    }
+  }
+  if (state->showHint) {
+    int percent = (int)(getDistanceTableProgress(&state->hintTable) * 100.0f);
+    if (percent != state->hintPercent) {
+      state->hintPercent = percent;
+      state->dirty = true;
     }
+  }
+  updateCountryPalette(state);
+  if (state->globe.stats.refining || state->showStats ||
+      inputTime() - state->lastDrawTime >= IDLE_REDRAW_TIME) {
+    state->dirty = true;  // The stats overlay shows live FPS
+  }
+
+  // Nothing changed: leave the last frame up and just pick up new input.
+  // Replays always draw so their frame timings stay comparable.
+  if (!state->dirty && getInputMode() != INPUT_REPLAY) {
+    PollInputEvents();
+#ifndef PLATFORM_WEB
+    WaitTime(IDLE_FRAME_TIME);  // The browser paces frames itself
+#endif
+    return;
+  }
+  state->dirty = false;
+  state->lastDrawTime = inputTime();
 
-    int displayCount = game.guessCount > 12 ? 12 : game.guessCount;
-    for (int i = 0; i < displayCount; i++) {
-      int idx = sortedIndices[i]; // Show sorted by distance (closest first)
-      int yPos = historyY + 75 + i * 48;
+  // Render
+  BeginDrawing();
+  drawFrame(state);
 
-      // Background
-      DrawRectangle(historyX, yPos, uiWidth, 45, game.guesses[idx].color);
+  if (state->allocCheck) {
+    checkFrameAllocations(state, getThreadAllocCount() - allocsAtStart);
+  }
 
-      // Country name
-      const char *name = game.guesses[idx].country->englishName;
-      DrawTextEx(customFont, name, (Vector2){historyX + 5, yPos + 3}, 20, 1.0f, BLACK);
+  // Work done this frame, before the buffer swap and any frame-rate wait
+  recordFrameTiming((GetTime() - frameStart) * 1000.0);
+  EndDrawing();
+  resetScratchArena(scratch);
+}
 
-      // Distance
-      if (game.guesses[idx].distance < 1.0f) {
-        DrawTextEx(customFont, "CORRECT!", (Vector2){historyX + 5, yPos + 26}, 18, 1.0f, DARKGREEN);
-      } else {
-        DrawTextEx(customFont, TextFormat("%.0f km", game.guesses[idx].distance),
-                 (Vector2){historyX + 5, yPos + 26}, 18, 1.0f, BLACK);
+#ifndef PLATFORM_WEB
+// --bench rendering paths: guesses shaded through the country map, the
+// outline fallback (DrawLine3D per border segment), and the shaded globe
+// under the heat map's immediate-mode quads
+typedef enum {
+  BENCH_PATH_SHADED,
+  BENCH_PATH_OUTLINE,
+  BENCH_PATH_HEAT,
+  BENCH_PATH_COUNT
+} BenchPath;
+
+// A round in progress with the first guesses countries (in database order,
+// mystery skipped) guessed; a negative count guesses every other country.
+// Centroid distances keep the setup quick and only decide the colors.
+static void setupBenchRound(AppState *state, int guesses) {
+  setGameLogging(false);
+  initGame(&state->game, state->db);
+  state->game.currentDistanceMode = DISTANCE_MODE_CENTROID;
+  selectSeededMysteryCountry(&state->game, BENCH_SEED);
+  state->game.startTime = inputTime();
+  for (uint64_t i = 0; i < state->db->count; i++) {
+    if (guesses >= 0 && state->game.guessCount >= guesses) break;
+    if (&state->db->countries[i] != state->game.mysteryCountry) {
+      makeGuess(&state->game, &state->db->countries[i]);
+    }
+  }
+  setGameLogging(true);
+  state->modeSelectionActive = false;
+  state->hoveredCountry = NULL;
+  state->showHint = false;
+  state->showStats = false;
+}
+
+// Render every guess count on every path along the same camera orbit and
+// zoom sweep, offscreen at 1920x1080, and print one row per scenario
+static void runRenderBenchmark(AppState *state, int frames) {
+  while (isGeometryPrefetchRunning()) {
+    WaitTime(0.01);
+  }
+  pollGeometryPrefetch(state);  // Pick index and country map
+
+  RenderBench bench;
+  if (!initRenderBench(&bench)) {
+    fprintf(stderr, "Render benchmark: could not create a %dx%d render texture\n",
+            BENCH_WIDTH, BENCH_HEIGHT);
+    return;
+  }
+  printBenchHeader(&bench, frames);
+
+  const int guessCounts[] = {0, 10, 50, -1};
+  const char *pathNames[] = {"shaded", "outline", "heat"};
+  Matrix base = state->globeTransform;
+  CountryMap shading = state->countryMap;
+  for (size_t g = 0; g < sizeof(guessCounts) / sizeof(guessCounts[0]); g++) {
+    int guesses = guessCounts[g];
+    if (guesses >= (int)state->db->count) continue;  // Same as "all" here
+    for (int path = 0; path < BENCH_PATH_COUNT && !WindowShouldClose(); path++) {
+      setupBenchRound(state, guesses);
+
+      // The outline path is what runs when the country map couldn't load
+      state->countryMap = path == BENCH_PATH_OUTLINE ? (CountryMap){0} : shading;
+      attachCountryMap(&state->countryMap, &state->globe);
+      state->paletteResolved = -1;
+      updateCountryPalette(state);
+      state->showHeatMap = path == BENCH_PATH_HEAT;
+      for (uint64_t i = 0; state->showHeatMap && i <= state->db->count; i++) {
+        updateHeatMap(&state->heat, &state->game);  // One field per call
       }
 
-      // Closest marker
-      if (idx == game.closestGuessIndex && !game.won) {
-        DrawTextEx(customFont, "CLOSEST", (Vector2){historyX + uiWidth - 85, yPos + 13}, 18, 1.0f, DARKBLUE);
+      beginBenchScenario(&bench);
+      for (int f = 0; f < BENCH_WARMUP + frames; f++) {
+        bool record = f >= BENCH_WARMUP;
+        BenchView view = benchViewAt(record ? (float)(f - BENCH_WARMUP) / frames : 0.0f, base);
+        state->globeTransform = view.globeTransform;
+        state->cameraDistance = view.cameraDistance;
+        beginBenchFrame(&bench, record);
+        drawFrame(state);
+        endBenchFrame(&bench);
+        resetScratchArena(&state->scratch);
+        PollInputEvents();  // Keeps the window responsive; nothing reaches the screen
       }
+      char name[64];
+      if (guesses < 0) {
+        snprintf(name, sizeof(name), "all (%d) %s", state->game.guessCount, pathNames[path]);
+      } else {
+        snprintf(name, sizeof(name), "%d guessed %s", guesses, pathNames[path]);
       }
+      endBenchScenario(&bench, name);
     }
+  }
 
-    // Win message
-    if (game.won && game.mysteryCountry != NULL) {
-      int msgWidth = 450;
-      int msgHeight = 260;
-      int msgX = (SCREEN_WIDTH - msgWidth) / 2;
-      int msgY = (SCREEN_HEIGHT - msgHeight) / 2;
+  state->countryMap = shading;
+  attachCountryMap(&state->countryMap, &state->globe);
+  state->globeTransform = base;
+  unloadRenderBench(&bench);
+}
+#endif
 
-      DrawRectangle(msgX, msgY, msgWidth, msgHeight, Fade(WHITE, 0.95f));
-      DrawRectangleLines(msgX, msgY, msgWidth, msgHeight, GREEN);
+int main(int argc, char **argv) {
+  // Static so it outlives main() when emscripten unwinds the stack
+  static AppState state = {0};
+
+  // Input source: live by default, or --record <file> / --replay <file>
+  // (--fast replays without the 60 fps cap); --quantize stores borders as
+  // 16-bit fixed point; --memreport prints memory use at startup and exit;
+  // --precision exact|float|fast sets the render trig tier,
+  // --precision-report prints each tier's error over the dataset and exits,
+  // --watch reloads edited rows of the CSV between rounds, --alloc-check
+  // aborts if a steady frame allocates (see checkFrameAllocations), and
+  // --bench renders scripted scenarios offscreen, prints their timings and
+  // exits (--bench-frames sets the frames per scenario; see renderbench.h)
+  uint32_t seed = (uint32_t)time(NULL);
+  bool fast = false;
+  bool watch = false;
+  bool memReport = false;
+  bool precisionReport = false;
+  bool bench = false;
+  int benchFrames = BENCH_FRAMES;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      if (!startInputRecording(argv[++i], seed)) return 1;
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      if (!startInputReplay(argv[++i], &seed)) return 1;
+    } else if (strcmp(argv[i], "--fast") == 0) {
+      fast = true;
+    } else if (strcmp(argv[i], "--quantize") == 0) {
+      setGeometryQuantization(true);
+    } else if (strcmp(argv[i], "--memreport") == 0) {
+      memReport = true;
+    } else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc) {
+      Precision tier;
+      if (!parsePrecision(argv[++i], &tier)) {
+        fprintf(stderr, "Unknown precision tier: %s\n", argv[i]);
+        return 1;
+      }
+      setRenderPrecision(tier);
+    } else if (strcmp(argv[i], "--precision-report") == 0) {
+      precisionReport = true;
+    } else if (strcmp(argv[i], "--watch") == 0) {
+      watch = true;
+    } else if (strcmp(argv[i], "--alloc-check") == 0) {
+      state.allocCheck = true;
+    } else if (strcmp(argv[i], "--bench") == 0) {
+      bench = true;
+    } else if (strcmp(argv[i], "--bench-frames") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+      benchFrames = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "Usage: %s [--record file | --replay file [--fast]] [--quantize] "
+              "[--memreport] [--precision exact|float|fast] [--precision-report] "
+              "[--watch] [--alloc-check] [--bench] [--bench-frames n]\n", argv[0]);
+      return 1;
+    }
+  }
+  seedGameRandom(seed);
+
+#ifndef PLATFORM_WEB
+  if (precisionReport) {
+    CountryDatabase *db = loadCountryDatabase("./coordinates/ccc.csv");
+    if (!db) return 1;
+    printPrecisionReport(db);
+    freeCountryDatabase(db);
+    return 0;
+  }
+#else
+  (void)precisionReport;  // Needs the CSV, which only ships with desktop builds
+  (void)watch;
+  (void)bench;  // Desktop GL only
+  (void)benchFrames;
+#endif
 
-      DrawTextEx(customFont, "CONGRATULATIONS!", (Vector2){msgX + 65, msgY + 25}, 42, 1.0f, GREEN);
-      DrawTextEx(customFont, TextFormat("You found %s!", game.mysteryCountry->englishName),
-               (Vector2){msgX + 45, msgY + 80}, 26, 1.0f, DARKGREEN);
-      DrawTextEx(customFont, TextFormat("Guesses: %d", game.guessCount), (Vector2){msgX + 155, msgY + 115},
-               26, 1.0f, DARKGREEN);
+  // Initialize window
+  InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Globle Game - Guess the Country!");
+#ifndef PLATFORM_WEB
+  if (!(fast && getInputMode() == INPUT_REPLAY)) {
+    SetTargetFPS(60);
+  }
+#else
+  (void)fast;  // The browser paces frames itself
+#endif
 
-      // Display time
-      int minutes = (int)(game.elapsedTime / 60.0);
-      int seconds = (int)game.elapsedTime % 60;
-      DrawTextEx(customFont, TextFormat("Time: %d:%02d", minutes, seconds), (Vector2){msgX + 155, msgY + 145},
-               26, 1.0f, DARKGREEN);
+  initHeatMap(&state.heat, HEAT_MAP_DEGREES);
+  initTableFields(&state.hintFields, HINT_FIELD_DEGREES);
+  initScratchArena(&state.scratch, FRAME_SCRATCH_BYTES, MEM_TAG_RENDER);
 
-      // Display score
-      DrawTextEx(customFont, TextFormat("SCORE: %d / 10000", game.finalScore), (Vector2){msgX + 100, msgY + 180},
-               30, 1.0f, DARKBLUE);
+  // Distance-field font: crisp at every UI size (falls back to plain text)
+  if (!loadUiText()) {
+    printf("Warning: SDF text unavailable, using the default font\n");
+  }
 
-      DrawTextEx(customFont, "Press ENTER for next round", (Vector2){msgX + 85, msgY + 220}, 24, 1.0f, DARKGRAY);
-    }
+  // Load country database
+#ifdef PLATFORM_WEB
+  // Streamed in the background; the game is initialized once metadata arrives
+  // Quantized to keep sub-national datasets within the wasm heap
+  printf("Streaming country database...\n");
+  setGeometryQuantization(true);
+  startDatasetStream(&state.stream, "data");
+#else
+  printf("Loading country database...\n");
+  state.watching = watch;
+  state.db = watch ? startDatasetWatch(&state.watch, "./coordinates/ccc.csv")
+                   : loadCountryDatabase("./coordinates/ccc.csv");
+  if (!state.db) {
+    printf("Failed to load country database!\n");
+    CloseWindow();
+    return 1;
+  }
+
+  // Initialize game
+  initGame(&state.game, state.db);
+  // Mystery country will be selected after mode selection
+
+  // Rings decode in the background; picking and shading wait for them
+  startGeometryPrefetch(state.db);
+#endif
 
-    EndDrawing();
+  // Setup 3D camera
+  state.cameraDistance = 5.0f;  // Initial zoom distance
+  state.camera.position = (Vector3){-state.cameraDistance, 0.0f, 0.0f};
+  state.camera.target = (Vector3){0.0f, 0.0f, 0.0f};
+  state.camera.up = (Vector3){0.0f, 1.0f, 0.0f};
+  state.camera.fovy = 45.0f;
+  state.camera.projection = CAMERA_PERSPECTIVE;
+
+  // Load earth texture
+  // earth2.jpg is 4096x8192 (1:2 portrait ratio)
+  // This matches par_shapes UV mapping which swaps U/V from standard equirectangular
+#ifdef PLATFORM_WEB
+  // Plain ocean until the streamed texture arrives
+  Image img = GenImageColor(1, 1, (Color){40, 80, 140, 255});
+#else
+  Image img = LoadImage("earth2.jpg");
+#endif
+  state.earthTex = LoadTextureFromImage(img);
+  UnloadImage(img);
+
+  // Create globe (patches are generated on demand as the camera moves)
+  initGlobeLod(&state.globe, GLOBE_RADIUS, state.earthTex);
+
+  // Globe rotation - store the complete transformation matrix
+  Matrix M0 = MatrixRotateX(DEG2RAD * 270.0f);
+  state.globeTransform = M0;
+  state.isDragging = false;
+  state.dragStartTransform = MatrixIdentity();
+
+  // Mode selection state
+  state.modeSelectionActive = true;
+  state.selectedMode = 1; // Default to Border-to-Border (index 1)
+  state.dirty = true;
+
+  // Border distances run off the main thread where threads are available
+  startDistanceWorkers(2);
+
+  if (memReport) {
+    printMemoryReport("startup");
+    printGeometryMemoryReport(state.db);
   }
 
+  // Main game loop
+#ifdef PLATFORM_WEB
+  // Hand the loop to the browser; never returns
+  emscripten_set_main_loop_arg(UpdateDrawFrame, &state, 0, 1);
+#else
+  if (bench) {
+    runRenderBenchmark(&state, benchFrames);
+  }
+  while (!bench && !WindowShouldClose() && !state.replayDone) {
+    UpdateDrawFrame(&state);
+  }
+  printReplayTimings();
+  stopInput();
+  if (memReport) {
+    printMemoryReport("exit");
+  }
+#endif
+
   // Cleanup
-  UnloadFont(customFont);
-  UnloadTexture(earthTex);
-  UnloadModel(globe);
-  freeCountryDatabase(db);
+  stopDistanceWorkers();
+  if (state.hintTable.km) {
+    freeDistanceTable(&state.hintTable);
+  }
+  freeTableFields(&state.hintFields);
+  freeHeatMap(&state.heat);
+  freeScratchArena(&state.scratch);
+  unloadUiText();
+  UnloadTexture(state.earthTex);
+  unloadGlobeLod(&state.globe);
+  unloadCountryMap(&state.countryMap);
+  freePickIndex(state.pick);
+#ifndef PLATFORM_WEB
+  if (state.watching) {
+    stopDatasetWatch(&state.watch);  // Owns the database
+    state.db = NULL;
+  }
+#endif
+  freeCountryDatabase(state.db);
   CloseWindow();
 
   return 0;
@@ -0,0 +1,155 @@
+#include "memtrack.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef PLATFORM_WEB
+  #include <emscripten/heap.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+// Prepended to every allocation; the union keeps the payload max-aligned
+typedef union {
+  struct {
+    uint64_t size;
+    uint32_t tag;
+  } info;
+  max_align_t align;
+} MemHeader;
+
+typedef struct {
+  _Atomic int64_t bytes;
+  _Atomic int64_t peakBytes;
+  _Atomic int64_t liveCount;
+  _Atomic int64_t totalCount;
+} MemCounters;
+
+static MemCounters counters[MEM_TAG_COUNT];
+static _Atomic int64_t totalBytes;
+static _Atomic int64_t totalPeak;
+static _Thread_local uint64_t threadAllocs;
+
+static const char *tagNames[MEM_TAG_COUNT] = {
+  "strings", "geometry", "database", "parse", "game", "render", "gpu", "picking",
+  "fields",
+};
+
+static void raisePeak(_Atomic int64_t *peak, int64_t value) {
+  int64_t seen = atomic_load(peak);
+  while (value > seen && !atomic_compare_exchange_weak(peak, &seen, value)) {
+  }
+}
+
+static void account(MemTag tag, int64_t bytes, int64_t count) {
+  MemCounters *c = &counters[tag];
+  int64_t now = atomic_fetch_add(&c->bytes, bytes) + bytes;
+  raisePeak(&c->peakBytes, now);
+  int64_t total = atomic_fetch_add(&totalBytes, bytes) + bytes;
+  raisePeak(&totalPeak, total);
+
+  atomic_fetch_add(&c->liveCount, count);
+  if (count > 0) {
+    atomic_fetch_add(&c->totalCount, count);
+  }
+}
+
+void *memAlloc(MemTag tag, size_t size) {
+  threadAllocs++;
+  MemHeader *h = malloc(sizeof(MemHeader) + size);
+  if (!h) return NULL;
+  h->info.size = size;
+  h->info.tag = tag;
+  account(tag, (int64_t)size, 1);
+  return h + 1;
+}
+
+void *memCalloc(MemTag tag, size_t count, size_t size) {
+  threadAllocs++;
+  MemHeader *h = calloc(1, sizeof(MemHeader) + count * size);
+  if (!h) return NULL;
+  h->info.size = count * size;
+  h->info.tag = tag;
+  account(tag, (int64_t)(count * size), 1);
+  return h + 1;
+}
+
+void *memRealloc(MemTag tag, void *p, size_t size) {
+  if (!p) {
+    return memAlloc(tag, size);
+  }
+  threadAllocs++;
+  MemHeader *h = (MemHeader *)p - 1;
+  uint64_t oldSize = h->info.size;
+  tag = (MemTag)h->info.tag;
+
+  MemHeader *moved = realloc(h, sizeof(MemHeader) + size);
+  if (!moved) return NULL;
+  moved->info.size = size;
+  account(tag, (int64_t)size - (int64_t)oldSize, 0);
+  return moved + 1;
+}
+
+void memFree(void *p) {
+  if (!p) return;
+  MemHeader *h = (MemHeader *)p - 1;
+  account((MemTag)h->info.tag, -(int64_t)h->info.size, -1);
+  free(h);
+}
+
+void memTrackExternal(MemTag tag, int64_t bytes) {
+  account(tag, bytes, bytes > 0 ? 1 : -1);
+}
+
+uint64_t getThreadAllocCount(void) {
+  return threadAllocs;
+}
+
+MemTagStats getMemTagStats(MemTag tag) {
+  MemCounters *c = &counters[tag];
+  return (MemTagStats){atomic_load(&c->bytes), atomic_load(&c->peakBytes),
+                       atomic_load(&c->liveCount), atomic_load(&c->totalCount)};
+}
+
+const char *getMemTagName(MemTag tag) {
+  return tag < MEM_TAG_COUNT ? tagNames[tag] : "?";
+}
+
+int64_t getMemTotalBytes(void) {
+  return atomic_load(&totalBytes);
+}
+
+int64_t getMemPeakBytes(void) {
+  return atomic_load(&totalPeak);
+}
+
+uint64_t getPeakRss(void) {
+#ifdef PLATFORM_WEB
+  return (uint64_t)emscripten_get_heap_size();  // The wasm heap never shrinks
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return (uint64_t)usage.ru_maxrss;  // Already bytes on macOS
+#else
+  return (uint64_t)usage.ru_maxrss * 1024;  // Kilobytes on Linux
+#endif
+#endif
+}
+
+void printMemoryReport(const char *when) {
+  const double mb = 1024.0 * 1024.0;
+  printf("Memory report (%s)\n", when);
+  printf("  %-10s %12s %12s %10s %10s\n", "tag", "live MB", "peak MB", "live", "allocs");
+  for (int i = 0; i < MEM_TAG_COUNT; i++) {
+    MemTagStats s = getMemTagStats((MemTag)i);
+    printf("  %-10s %12.2f %12.2f %10lld %10lld\n", tagNames[i], s.bytes / mb,
+           s.peakBytes / mb, (long long)s.liveCount, (long long)s.totalCount);
+  }
+  printf("  %-10s %12.2f %12.2f\n", "total", getMemTotalBytes() / mb,
+         getMemPeakBytes() / mb);
+  printf("  peak RSS: %.2f MB\n", getPeakRss() / mb);
+}
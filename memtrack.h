@@ -0,0 +1,54 @@
+#ifndef MEMTRACK_H
+#define MEMTRACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Tagged heap accounting. Allocations made through memAlloc and friends
+// carry a small header recording their size and tag, so live bytes, peak
+// bytes and allocation counts can be reported per subsystem. Memory owned
+// elsewhere (GPU buffers) is reported with memTrackExternal.
+// Pointers from these functions must be released with memFree, never free.
+
+typedef enum {
+  MEM_TAG_STRINGS = 0,  // Country metadata text, including the raw shape column
+  MEM_TAG_GEOMETRY,     // Rings and polygon lists
+  MEM_TAG_DATABASE,     // Country table
+  MEM_TAG_PARSE,        // Load-time scratch buffers
+  MEM_TAG_GAME,         // Distance jobs
+  MEM_TAG_RENDER,       // Frame scratch, globe patch nodes, text layouts
+  MEM_TAG_GPU,          // Mesh data uploaded to the GPU (external)
+  MEM_TAG_PICKING,      // Point-in-country and border cell indexes
+  MEM_TAG_FIELDS,       // Raster distance fields
+  MEM_TAG_COUNT
+} MemTag;
+
+typedef struct {
+  int64_t bytes;       // Currently live
+  int64_t peakBytes;
+  int64_t liveCount;   // Live allocations
+  int64_t totalCount;  // Allocations ever made
+} MemTagStats;
+
+void *memAlloc(MemTag tag, size_t size);
+void *memCalloc(MemTag tag, size_t count, size_t size);
+void *memRealloc(MemTag tag, void *p, size_t size);  // tag applies if p is NULL
+void memFree(void *p);
+
+// Account memory this process owns but did not allocate here (+/- bytes)
+void memTrackExternal(MemTag tag, int64_t bytes);
+
+// Calls to memAlloc, memCalloc and memRealloc made by the calling thread;
+// per thread, so the frame loop can be checked while workers allocate
+uint64_t getThreadAllocCount(void);
+
+MemTagStats getMemTagStats(MemTag tag);
+const char *getMemTagName(MemTag tag);
+int64_t getMemTotalBytes(void);
+int64_t getMemPeakBytes(void);
+uint64_t getPeakRss(void);  // Bytes; heap size on the web
+
+// Per-tag table plus totals and peak RSS on stdout
+void printMemoryReport(const char *when);
+
+#endif // MEMTRACK_H
@@ -0,0 +1,44 @@
+// Convert the CSV dataset into the streamable binary pack used by the web
+// build, or (--embed) into a C source file compiled into the game
+// Usage: ./packdata [--quantize] [csv_path] [output_dir]
+//        ./packdata [--quantize] --embed output.c [csv_path]
+#include "geodata.h"
+#include "geoembed.h"
+#include "geopack.h"
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+  const char *csvPath = "./coordinates/ccc.csv";
+  const char *outDir = "./web_build/data";
+  const char *embedPath = NULL;
+  int positional = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--quantize") == 0) {
+      setGeometryQuantization(true);
+    } else if (strcmp(argv[i], "--embed") == 0 && i + 1 < argc) {
+      embedPath = argv[++i];
+    } else if (argv[i][0] != '-' && positional < 2) {
+      if (positional++ == 0) {
+        csvPath = argv[i];
+      } else {
+        outDir = argv[i];
+      }
+    } else {
+      fprintf(stderr, "Usage: %s [--quantize] [--embed output.c] [csv_path] [output_dir]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  CountryDatabase *db = loadCountryDatabase(csvPath);
+  if (!db) {
+    printf("Failed to load country database!\n");
+    return 1;
+  }
+
+  bool ok = embedPath ? writeCountryDatabaseSource(db, embedPath)
+                      : writeCountryDatabasePack(db, outDir);
+  freeCountryDatabase(db);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#include "picking.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+static int cellRow(const PickIndex *index, float lat) {
+  int row = (int)((lat + 90.0f) / PICK_CELL_DEG);
+  if (row < 0) return 0;
+  if (row >= index->rows) return index->rows - 1;
+  return row;
+}
+
+static int cellCol(const PickIndex *index, float lon) {
+  int col = (int)((lon + 180.0f) / PICK_CELL_DEG);
+  if (col < 0) return 0;
+  if (col >= index->cols) return index->cols - 1;
+  return col;
+}
+
+static Polygon *ringAt(const PickIndex *index, PickEntry e) {
+  return countryPolygons(&index->db->countries[e.country])[e.ring];
+}
+
+// Visit every cell a ring's bounding box overlaps
+// fill == NULL counts entries per cell, otherwise writes them at cursor
+static void registerRing(PickIndex *index, Polygon *poly, PickEntry e,
+                         uint32_t *cursor, PickEntry *fill) {
+  int row0 = cellRow(index, poly->boxMin.lat);
+  int row1 = cellRow(index, poly->boxMax.lat);
+  int col0 = cellCol(index, poly->boxMin.lon);
+  int col1 = cellCol(index, poly->boxMax.lon);
+  for (int row = row0; row <= row1; row++) {
+    for (int col = col0; col <= col1; col++) {
+      int cell = row * index->cols + col;
+      if (fill) {
+        fill[cursor[cell]++] = e;
+      } else {
+        cursor[cell]++;
+      }
+    }
+  }
+}
+
+PickIndex *buildPickIndex(CountryDatabase *db) {
+  if (!db) return NULL;
+
+  PickIndex *index = memAlloc(MEM_TAG_PICKING, sizeof(PickIndex));
+  index->db = db;
+  index->rows = (int)(180.0f / PICK_CELL_DEG);
+  index->cols = (int)(360.0f / PICK_CELL_DEG);
+  int cellCount = index->rows * index->cols;
+
+  // First pass counts entries per cell, second pass fills them in (CSR layout)
+  uint32_t *counts = memCalloc(MEM_TAG_PICKING, cellCount, sizeof(uint32_t));
+  for (uint32_t i = 0; i < db->count; i++) {
+    Polygon **polys = countryPolygons(&db->countries[i]);
+    for (uint32_t j = 0; j < countryRingCount(&db->countries[i]); j++) {
+      Polygon *poly = polys[j];
+      if (polygonPointCount(poly) < 3) continue;
+      registerRing(index, poly, (PickEntry){i, j}, counts, NULL);
+    }
+  }
+
+  index->cellStart = memAlloc(MEM_TAG_PICKING, (cellCount + 1) * sizeof(uint32_t));
+  index->cellStart[0] = 0;
+  for (int c = 0; c < cellCount; c++) {
+    index->cellStart[c + 1] = index->cellStart[c] + counts[c];
+    counts[c] = index->cellStart[c];  // Reuse as the fill cursor
+  }
+  index->entryCount = index->cellStart[cellCount];
+  index->entries = memAlloc(MEM_TAG_PICKING,
+                            (index->entryCount ? index->entryCount : 1) * sizeof(PickEntry));
+
+  for (uint32_t i = 0; i < db->count; i++) {
+    Polygon **polys = countryPolygons(&db->countries[i]);
+    for (uint32_t j = 0; j < countryRingCount(&db->countries[i]); j++) {
+      Polygon *poly = polys[j];
+      if (polygonPointCount(poly) < 3) continue;
+      registerRing(index, poly, (PickEntry){i, j}, counts, index->entries);
+    }
+  }
+
+  memFree(counts);
+  return index;
+}
+
+void freePickIndex(PickIndex *index) {
+  if (!index) return;
+  memFree(index->cellStart);
+  memFree(index->entries);
+  memFree(index);
+}
+
+// Even-odd ray casting in the lat/lon plane
+static bool ringContains(const Polygon *poly, float lat, float lon) {
+  uint64_t n = polygonPointCount(poly);
+  bool inside = false;
+  GeoPoint pj = polygonPoint(poly, n - 1);
+  for (uint64_t i = 0; i < n; i++) {
+    GeoPoint pi = polygonPoint(poly, i);
+    if ((pi.lat > lat) != (pj.lat > lat)) {
+      double t = ((double)lat - pi.lat) / ((double)pj.lat - pi.lat);
+      double crossLon = pi.lon + t * ((double)pj.lon - pi.lon);
+      if (lon < crossLon) {
+        inside = !inside;
+      }
+    }
+    pj = pi;
+  }
+  return inside;
+}
+
+CountryData *pickCountryAt(const PickIndex *index, float lat, float lon) {
+  if (!index) return NULL;
+
+  int cell = cellRow(index, lat) * index->cols + cellCol(index, lon);
+  CountryData *best = NULL;
+  float bestArea = 0.0f;
+
+  for (uint32_t k = index->cellStart[cell]; k < index->cellStart[cell + 1]; k++) {
+    PickEntry e = index->entries[k];
+    Polygon *poly = ringAt(index, e);
+    if (lat < poly->boxMin.lat || lat > poly->boxMax.lat ||
+        lon < poly->boxMin.lon || lon > poly->boxMax.lon) {
+      continue;
+    }
+
+    float area = (poly->boxMax.lat - poly->boxMin.lat) *
+                 (poly->boxMax.lon - poly->boxMin.lon);
+    if (best && area >= bestArea) {
+      continue;  // Can't beat a smaller ring that already matched
+    }
+    if (ringContains(poly, lat, lon)) {
+      best = &index->db->countries[e.country];
+      bestArea = area;
+    }
+  }
+  return best;
+}
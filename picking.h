@@ -0,0 +1,36 @@
+#ifndef PICKING_H
+#define PICKING_H
+
+#include "geodata.h"
+#include <stdint.h>
+
+// Answers "which country is at this lat/lon". Every ring is registered in
+// the cells of a regular lat/lon grid that its bounding box overlaps; a query
+// only runs the exact point-in-polygon test on the rings listed in its cell.
+
+#define PICK_CELL_DEG 1.0f  // Grid resolution in degrees
+
+// A ring registered in a cell
+typedef struct {
+  uint32_t country;  // Index into db->countries
+  uint32_t ring;     // Index into that country's polygons
+} PickEntry;
+
+typedef struct {
+  CountryDatabase *db;
+  int rows;             // Latitude bands
+  int cols;             // Longitude bands
+  uint32_t *cellStart;  // rows * cols + 1 offsets into entries
+  PickEntry *entries;
+  uint64_t entryCount;
+} PickIndex;
+
+// Build the index over every ring in db (geometry must be loaded)
+PickIndex *buildPickIndex(CountryDatabase *db);
+void freePickIndex(PickIndex *index);
+
+// Country containing the point, or NULL over open water
+// Where rings overlap (enclaves), the ring with the smaller bounding box wins
+CountryData *pickCountryAt(const PickIndex *index, float lat, float lon);
+
+#endif // PICKING_H
@@ -0,0 +1,253 @@
+#include "renderbench.h"
+#include "raylib/src/raymath.h"
+#include "raylib/src/rlgl.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_GL_TIME_ELAPSED 0x88BF
+#define BENCH_GL_QUERY_RESULT 0x8866
+#define BENCH_TILT_DEGREES 30.0f  // How far the path leans toward each pole
+
+// glad's function pointers inside raylib; weak, so they read as missing
+// (address NULL) when raylib doesn't export them
+typedef void (*GlDrawArrays)(unsigned int mode, int first, int count);
+typedef void (*GlDrawElements)(unsigned int mode, int count, unsigned int type,
+                               const void *indices);
+typedef void (*GlDrawArraysInstanced)(unsigned int mode, int first, int count, int instances);
+typedef void (*GlDrawElementsInstanced)(unsigned int mode, int count, unsigned int type,
+                                        const void *indices, int instances);
+typedef void (*GlGenQueries)(int n, unsigned int *ids);
+typedef void (*GlDeleteQueries)(int n, const unsigned int *ids);
+typedef void (*GlBeginQuery)(unsigned int target, unsigned int id);
+typedef void (*GlEndQuery)(unsigned int target);
+typedef void (*GlGetQueryObjectui64v)(unsigned int id, unsigned int pname, uint64_t *params);
+
+extern GlDrawArrays glad_glDrawArrays __attribute__((weak));
+extern GlDrawElements glad_glDrawElements __attribute__((weak));
+extern GlDrawArraysInstanced glad_glDrawArraysInstanced __attribute__((weak));
+extern GlDrawElementsInstanced glad_glDrawElementsInstanced __attribute__((weak));
+extern GlGenQueries glad_glGenQueries __attribute__((weak));
+extern GlDeleteQueries glad_glDeleteQueries __attribute__((weak));
+extern GlBeginQuery glad_glBeginQuery __attribute__((weak));
+extern GlEndQuery glad_glEndQuery __attribute__((weak));
+extern GlGetQueryObjectui64v glad_glGetQueryObjectui64v __attribute__((weak));
+
+// Draw counting (main thread only, like all GL calls)
+static GlDrawArrays realDrawArrays;
+static GlDrawElements realDrawElements;
+static GlDrawArraysInstanced realDrawArraysInstanced;
+static GlDrawElementsInstanced realDrawElementsInstanced;
+static uint32_t drawCalls;
+static uint64_t vertices;
+
+static void countDrawArrays(unsigned int mode, int first, int count) {
+  drawCalls++;
+  vertices += (uint64_t)count;
+  realDrawArrays(mode, first, count);
+}
+
+static void countDrawElements(unsigned int mode, int count, unsigned int type,
+                              const void *indices) {
+  drawCalls++;
+  vertices += (uint64_t)count;
+  realDrawElements(mode, count, type, indices);
+}
+
+static void countDrawArraysInstanced(unsigned int mode, int first, int count, int instances) {
+  drawCalls++;
+  vertices += (uint64_t)count * (uint64_t)instances;
+  realDrawArraysInstanced(mode, first, count, instances);
+}
+
+static void countDrawElementsInstanced(unsigned int mode, int count, unsigned int type,
+                                       const void *indices, int instances) {
+  drawCalls++;
+  vertices += (uint64_t)count * (uint64_t)instances;
+  realDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+static bool hookDrawCalls(void) {
+  if (!&glad_glDrawArrays || !&glad_glDrawElements || !glad_glDrawArrays ||
+      !glad_glDrawElements) {
+    return false;
+  }
+  realDrawArrays = glad_glDrawArrays;
+  glad_glDrawArrays = countDrawArrays;
+  realDrawElements = glad_glDrawElements;
+  glad_glDrawElements = countDrawElements;
+  if (&glad_glDrawArraysInstanced && glad_glDrawArraysInstanced) {
+    realDrawArraysInstanced = glad_glDrawArraysInstanced;
+    glad_glDrawArraysInstanced = countDrawArraysInstanced;
+  }
+  if (&glad_glDrawElementsInstanced && glad_glDrawElementsInstanced) {
+    realDrawElementsInstanced = glad_glDrawElementsInstanced;
+    glad_glDrawElementsInstanced = countDrawElementsInstanced;
+  }
+  return true;
+}
+
+static void unhookDrawCalls(void) {
+  if (realDrawArrays) glad_glDrawArrays = realDrawArrays;
+  if (realDrawElements) glad_glDrawElements = realDrawElements;
+  if (realDrawArraysInstanced) glad_glDrawArraysInstanced = realDrawArraysInstanced;
+  if (realDrawElementsInstanced) glad_glDrawElementsInstanced = realDrawElementsInstanced;
+  realDrawArrays = NULL;
+  realDrawElements = NULL;
+  realDrawArraysInstanced = NULL;
+  realDrawElementsInstanced = NULL;
+}
+
+static bool timerQueriesAvailable(void) {
+  int version = rlGetVersion();
+  if (version != RL_OPENGL_33 && version != RL_OPENGL_43) return false;  // Not in GLES 3
+  return &glad_glGenQueries && &glad_glDeleteQueries && &glad_glBeginQuery &&
+         &glad_glEndQuery && &glad_glGetQueryObjectui64v && glad_glGenQueries &&
+         glad_glDeleteQueries && glad_glBeginQuery && glad_glEndQuery &&
+         glad_glGetQueryObjectui64v;
+}
+
+bool initRenderBench(RenderBench *bench) {
+  memset(bench, 0, sizeof(*bench));
+  bench->target = LoadRenderTexture(BENCH_WIDTH, BENCH_HEIGHT);
+  if (!bench->target.id) return false;
+  BenchFrameArray_init(&bench->frames);
+  for (int i = 0; i < BENCH_QUERY_LAG; i++) bench->queryFrame[i] = -1;
+  bench->gpuTimers = timerQueriesAvailable();
+  if (bench->gpuTimers) glad_glGenQueries(BENCH_QUERY_LAG, bench->queries);
+  bench->drawCounters = hookDrawCalls();
+  return true;
+}
+
+void unloadRenderBench(RenderBench *bench) {
+  unhookDrawCalls();
+  if (bench->gpuTimers) glad_glDeleteQueries(BENCH_QUERY_LAG, bench->queries);
+  UnloadRenderTexture(bench->target);
+  BenchFrameArray_free(&bench->frames);
+  memset(bench, 0, sizeof(*bench));
+}
+
+BenchView benchViewAt(float t, Matrix base) {
+  float turn = 2.0f * PI * t;
+  Matrix orbit = MatrixRotateY(turn);
+  Matrix tilt = MatrixRotateZ(DEG2RAD * BENCH_TILT_DEGREES * sinf(2.0f * turn));
+  BenchView view;
+  view.globeTransform = MatrixMultiply(MatrixMultiply(base, orbit), tilt);
+  view.cameraDistance = BENCH_MIN_DISTANCE + (BENCH_MAX_DISTANCE - BENCH_MIN_DISTANCE) *
+                                                 (0.5f + 0.5f * cosf(turn));
+  return view;
+}
+
+// Wait for the query in a slot and file its time with the frame it timed
+static void collectQuery(RenderBench *bench, int slot) {
+  int32_t frame = bench->queryFrame[slot];
+  if (frame < 0) return;
+  uint64_t ns = 0;
+  glad_glGetQueryObjectui64v(bench->queries[slot], BENCH_GL_QUERY_RESULT, &ns);
+  BenchFrameArray_data(&bench->frames)[frame].gpuMs = ns / 1e6;
+  bench->queryFrame[slot] = -1;
+}
+
+void printBenchHeader(const RenderBench *bench, int frames) {
+  printf("Render benchmark: %dx%d offscreen, %d frames per scenario, GPU timers %s, "
+         "draw counters %s\n", BENCH_WIDTH, BENCH_HEIGHT, frames,
+         bench->gpuTimers ? "on" : "n/a", bench->drawCounters ? "on" : "n/a");
+  printf("%-26s %9s %9s %9s %9s %8s %11s\n", "scenario", "cpu ms", "cpu p95", "gpu ms",
+         "gpu p95", "draws", "vertices");
+}
+
+void beginBenchScenario(RenderBench *bench) {
+  bench->frames.size = 0;
+}
+
+void beginBenchFrame(RenderBench *bench, bool record) {
+  bench->recording = record;
+  int slot = (int)(bench->frames.size % BENCH_QUERY_LAG);
+  if (bench->gpuTimers) collectQuery(bench, slot);
+  drawCalls = 0;
+  vertices = 0;
+  bench->frameStart = GetTime();
+  BeginTextureMode(bench->target);
+  if (bench->gpuTimers && record) {
+    glad_glBeginQuery(BENCH_GL_TIME_ELAPSED, bench->queries[slot]);
+  }
+}
+
+void endBenchFrame(RenderBench *bench) {
+  EndTextureMode();  // Flushes rlgl's batch
+  double cpuMs = (GetTime() - bench->frameStart) * 1000.0;
+  if (!bench->recording) return;
+
+  int slot = (int)(bench->frames.size % BENCH_QUERY_LAG);
+  if (bench->gpuTimers) {
+    glad_glEndQuery(BENCH_GL_TIME_ELAPSED);
+    bench->queryFrame[slot] = (int32_t)bench->frames.size;
+  }
+  BenchFrameArray_push(&bench->frames, (BenchFrame){cpuMs, -1.0, drawCalls, vertices});
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+// Mean and 95th percentile of the known (non-negative) values
+static void summarize(double *values, uint32_t count, double *mean, double *p95) {
+  uint32_t known = 0;
+  double sum = 0.0;
+  for (uint32_t i = 0; i < count; i++) {
+    if (values[i] < 0.0) continue;
+    values[known++] = values[i];
+    sum += values[i];
+  }
+  if (known == 0) {
+    *mean = *p95 = -1.0;
+    return;
+  }
+  qsort(values, known, sizeof(double), compareDoubles);
+  *mean = sum / known;
+  *p95 = values[(uint32_t)ceil(0.95 * known) - 1];
+}
+
+static void printMs(double ms) {
+  if (ms < 0.0) {
+    printf(" %9s", "n/a");
+  } else {
+    printf(" %9.2f", ms);
+  }
+}
+
+void endBenchScenario(RenderBench *bench, const char *name) {
+  for (int slot = 0; bench->gpuTimers && slot < BENCH_QUERY_LAG; slot++) {
+    collectQuery(bench, slot);
+  }
+
+  uint32_t count = bench->frames.size;
+  const BenchFrame *frames = BenchFrameArray_data(&bench->frames);
+  double *values = memAlloc(MEM_TAG_RENDER, (count ? count : 1) * sizeof(double));
+  double cpuMean, cpuP95, gpuMean, gpuP95;
+  for (uint32_t i = 0; i < count; i++) values[i] = frames[i].cpuMs;
+  summarize(values, count, &cpuMean, &cpuP95);
+  for (uint32_t i = 0; i < count; i++) values[i] = frames[i].gpuMs;
+  summarize(values, count, &gpuMean, &gpuP95);
+  memFree(values);
+
+  double draws = 0.0, verts = 0.0;
+  for (uint32_t i = 0; i < count; i++) {
+    draws += frames[i].drawCalls;
+    verts += (double)frames[i].vertices;
+  }
+  printf("%-26s", name);
+  printMs(cpuMean);
+  printMs(cpuP95);
+  printMs(gpuMean);
+  printMs(gpuP95);
+  if (bench->drawCounters && count) {
+    printf(" %8.0f %11.0f\n", draws / count, verts / count);
+  } else {
+    printf(" %8s %11s\n", "n/a", "n/a");
+  }
+  fflush(stdout);
+}
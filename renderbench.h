@@ -0,0 +1,74 @@
+#ifndef RENDERBENCH_H
+#define RENDERBENCH_H
+
+#include "raylib/src/raylib.h"
+#include "array.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Offscreen render benchmark (main --bench). Frames are drawn into a
+// 1920x1080 render texture along a scripted camera path, so no window size
+// or compositor gets in the way; under Xvfb with Mesa's llvmpipe it runs on
+// machines without a GPU:
+//
+//   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run -s "-screen 0 1920x1080x24" ./main --bench
+//
+// CPU time covers building and submitting a frame, up to rlgl flushing its
+// batch. GPU time comes from GL_TIME_ELAPSED queries where the context has
+// them (desktop GL 3.3 and up), read back BENCH_QUERY_LAG frames later so
+// the CPU never waits on the GPU. Draw calls and vertices are counted by
+// wrapping the GL draw entry points raylib's loader (glad) resolved. Both
+// reach into raylib's copy of glad through weak references, so a raylib
+// that keeps those symbols private still links and reports "n/a".
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_QUERY_LAG 4           // Frames in flight before a GPU time is read
+#define BENCH_MIN_DISTANCE 2.0f     // Zoom range the mouse wheel allows
+#define BENCH_MAX_DISTANCE 10.0f
+
+// Globe orientation and zoom at one point of the path
+typedef struct {
+  Matrix globeTransform;
+  float cameraDistance;
+} BenchView;
+
+// One frame's measurements; negative GPU time while unknown or unavailable
+typedef struct {
+  double cpuMs;
+  double gpuMs;
+  uint32_t drawCalls;
+  uint64_t vertices;
+} BenchFrame;
+
+DEFINE_ARRAY(BenchFrameArray, BenchFrame, 1, MEM_TAG_RENDER)
+
+typedef struct {
+  RenderTexture2D target;
+  bool gpuTimers;      // GL_TIME_ELAPSED queries available
+  bool drawCounters;   // Draw entry points wrapped
+  unsigned int queries[BENCH_QUERY_LAG];
+  int32_t queryFrame[BENCH_QUERY_LAG];  // Frame each query timed, -1 when idle
+  BenchFrameArray frames;               // Recorded frames of the current scenario
+  double frameStart;
+  bool recording;                       // The frame in progress is kept
+} RenderBench;
+
+// Call after InitWindow; false if the render texture can't be created
+bool initRenderBench(RenderBench *bench);
+void unloadRenderBench(RenderBench *bench);
+
+// Path position t in [0, 1): one full orbit with two tilts toward the
+// poles, zooming from the far limit to the near one and back. base is the
+// globe's resting orientation.
+BenchView benchViewAt(float t, Matrix base);
+
+void printBenchHeader(const RenderBench *bench, int frames);
+void beginBenchScenario(RenderBench *bench);
+// Draw between these; warm-up frames pass record = false
+void beginBenchFrame(RenderBench *bench, bool record);
+void endBenchFrame(RenderBench *bench);
+// Collect outstanding GPU times and print the scenario's row
+void endBenchScenario(RenderBench *bench, const char *name);
+
+#endif // RENDERBENCH_H
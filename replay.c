@@ -0,0 +1,229 @@
+#include "replay.h"
+#include "geodata.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Keys the game reacts to; bit i of InputFrame.keys is trackedKeys[i]
+static const int trackedKeys[] = {
+  KEY_ENTER, KEY_ESCAPE, KEY_BACKSPACE, KEY_UP, KEY_DOWN, KEY_F3, KEY_F1, KEY_F2,
+};
+#define TRACKED_KEY_COUNT (int)(sizeof(trackedKeys) / sizeof(trackedKeys[0]))
+
+#define BUTTON_PRESSED 0x1
+#define BUTTON_DOWN 0x2
+#define BUTTON_RELEASED 0x4
+
+static InputMode mode = INPUT_LIVE;
+static FILE *file = NULL;
+static InputFrame frame;
+static Vector2 previousMouse;  // Last frame's mouse position, for inputIdle
+static int charCursor = 0;  // Next character handed out by inputCharPressed
+DEFINE_ARRAY(TimingArray, double, 1, MEM_TAG_GAME)
+
+static bool timing = false;    // Collecting frame times (replay only)
+static TimingArray timings;    // Milliseconds per frame
+
+static void writeU32(FILE *f, uint32_t v) { fwrite(&v, sizeof(v), 1, f); }
+
+static uint32_t readU32(FILE *f) {
+  uint32_t v = 0;
+  if (fread(&v, sizeof(v), 1, f) != 1) return 0;
+  return v;
+}
+
+bool startInputRecording(const char *path, uint32_t seed) {
+  stopInput();
+  file = fopen(path, "wb");
+  if (!file) {
+    fprintf(stderr, "Error: Could not write %s\n", path);
+    return false;
+  }
+  writeU32(file, REPLAY_MAGIC);
+  writeU32(file, REPLAY_VERSION);
+  writeU32(file, seed);
+  mode = INPUT_RECORD;
+  return true;
+}
+
+bool startInputReplay(const char *path, uint32_t *seed) {
+  stopInput();
+  file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "Error: Could not open %s\n", path);
+    return false;
+  }
+  uint32_t magic = readU32(file);
+  uint32_t version = readU32(file);
+  if (magic != REPLAY_MAGIC || version != REPLAY_VERSION) {
+    fprintf(stderr, "Error: %s is not a version %d recording\n", path, REPLAY_VERSION);
+    fclose(file);
+    file = NULL;
+    return false;
+  }
+  *seed = readU32(file);
+  TimingArray_reserve(&timings, 4096);
+  timing = true;
+  mode = INPUT_REPLAY;
+  return true;
+}
+
+void stopInput(void) {
+  if (file) {
+    fclose(file);
+    file = NULL;
+  }
+  TimingArray_free(&timings);
+  timing = false;
+  mode = INPUT_LIVE;
+}
+
+InputMode getInputMode(void) {
+  return mode;
+}
+
+static void sampleLiveFrame(InputFrame *f) {
+  memset(f, 0, sizeof(*f));
+  f->time = GetTime();
+  for (int i = 0; i < TRACKED_KEY_COUNT; i++) {
+    if (IsKeyPressed(trackedKeys[i])) f->keys |= (uint16_t)(1u << i);
+  }
+  if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) f->buttons |= BUTTON_PRESSED;
+  if (IsMouseButtonDown(MOUSE_BUTTON_LEFT)) f->buttons |= BUTTON_DOWN;
+  if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) f->buttons |= BUTTON_RELEASED;
+  f->mouse = GetMousePosition();
+  f->wheel = GetMouseWheelMove();
+
+  int c;
+  while ((c = GetCharPressed()) > 0) {
+    if (f->charCount < INPUT_MAX_CHARS) f->chars[f->charCount++] = c;
+  }
+}
+
+static void writeFrame(FILE *out, const InputFrame *f) {
+  fwrite(&f->time, sizeof(f->time), 1, out);
+  fwrite(&f->keys, sizeof(f->keys), 1, out);
+  fwrite(&f->buttons, sizeof(f->buttons), 1, out);
+  fwrite(&f->charCount, sizeof(f->charCount), 1, out);
+  fwrite(&f->mouse.x, sizeof(float), 1, out);
+  fwrite(&f->mouse.y, sizeof(float), 1, out);
+  fwrite(&f->wheel, sizeof(f->wheel), 1, out);
+  for (int i = 0; i < f->charCount; i++) {
+    writeU32(out, (uint32_t)f->chars[i]);
+  }
+}
+
+static bool readFrame(FILE *in, InputFrame *f) {
+  memset(f, 0, sizeof(*f));
+  bool ok = fread(&f->time, sizeof(f->time), 1, in) == 1 &&
+            fread(&f->keys, sizeof(f->keys), 1, in) == 1 &&
+            fread(&f->buttons, sizeof(f->buttons), 1, in) == 1 &&
+            fread(&f->charCount, sizeof(f->charCount), 1, in) == 1 &&
+            fread(&f->mouse.x, sizeof(float), 1, in) == 1 &&
+            fread(&f->mouse.y, sizeof(float), 1, in) == 1 &&
+            fread(&f->wheel, sizeof(f->wheel), 1, in) == 1;
+  if (!ok || f->charCount > INPUT_MAX_CHARS) {
+    return false;
+  }
+  for (int i = 0; i < f->charCount; i++) {
+    uint32_t c;
+    if (fread(&c, sizeof(c), 1, in) != 1) return false;
+    f->chars[i] = (int)c;
+  }
+  return true;
+}
+
+bool beginInputFrame(void) {
+  charCursor = 0;
+  previousMouse = frame.mouse;
+  if (mode == INPUT_REPLAY) {
+    return readFrame(file, &frame);
+  }
+
+  sampleLiveFrame(&frame);
+  if (mode == INPUT_RECORD) {
+    writeFrame(file, &frame);
+  }
+  return true;
+}
+
+bool inputKeyPressed(int key) {
+  for (int i = 0; i < TRACKED_KEY_COUNT; i++) {
+    if (trackedKeys[i] == key) return (frame.keys >> i) & 1;
+  }
+  return false;
+}
+
+int inputCharPressed(void) {
+  if (charCursor < frame.charCount) {
+    return frame.chars[charCursor++];
+  }
+  return 0;
+}
+
+Vector2 inputMousePosition(void) {
+  return frame.mouse;
+}
+
+bool inputMouseButtonPressed(int button) {
+  return button == MOUSE_BUTTON_LEFT && (frame.buttons & BUTTON_PRESSED);
+}
+
+bool inputMouseButtonDown(int button) {
+  return button == MOUSE_BUTTON_LEFT && (frame.buttons & BUTTON_DOWN);
+}
+
+bool inputMouseButtonReleased(int button) {
+  return button == MOUSE_BUTTON_LEFT && (frame.buttons & BUTTON_RELEASED);
+}
+
+float inputMouseWheel(void) {
+  return frame.wheel;
+}
+
+double inputTime(void) {
+  return mode == INPUT_REPLAY ? frame.time : GetTime();
+}
+
+bool inputIdle(void) {
+  return frame.keys == 0 && frame.buttons == 0 && frame.charCount == 0 &&
+         frame.wheel == 0.0f && frame.mouse.x == previousMouse.x &&
+         frame.mouse.y == previousMouse.y;
+}
+
+void recordFrameTiming(double ms) {
+  if (timing) {
+    TimingArray_push(&timings, ms);
+  }
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+void printReplayTimings(void) {
+  if (timings.size == 0) {
+    return;
+  }
+
+  const double *ms = TimingArray_data(&timings);
+  uint32_t n = timings.size;
+  double total = 0.0;
+  for (uint32_t i = 0; i < n; i++) {
+    printf("frame %u: %.3f ms\n", i, ms[i]);
+    total += ms[i];
+  }
+
+  TimingArray sorted;
+  TimingArray_init(&sorted);
+  TimingArray_append(&sorted, ms, n);
+  double *s = TimingArray_data(&sorted);
+  qsort(s, n, sizeof(double), compareDoubles);
+  printf("Replay: %llu frames, %.1f ms total, avg %.3f ms, p50 %.3f, p95 %.3f, "
+         "p99 %.3f, max %.3f\n",
+         (unsigned long long)n, total, total / n, s[n / 2],
+         s[(n * 95) / 100], s[(n * 99) / 100], s[n - 1]);
+  TimingArray_free(&sorted);
+}
@@ -0,0 +1,62 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "raylib/src/raylib.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Input source for the frame loop. Live input comes straight from raylib;
+// a recording logs every frame's input and the game's RNG seed to a file,
+// and a replay feeds that file back so the session runs identically.
+// The frame loop only reads input through the input* functions below.
+//
+// File layout (little-endian): "GLRR" magic, version, seed, then one record
+// per frame: time f64, key mask u16, button mask u8, char count u8,
+// mouse x/y f32, wheel f32, chars u32 × count.
+
+#define REPLAY_MAGIC 0x52524c47u  // "GLRR"
+#define REPLAY_VERSION 1
+#define INPUT_MAX_CHARS 16  // Characters kept per frame
+
+typedef enum {
+  INPUT_LIVE = 0,
+  INPUT_RECORD,
+  INPUT_REPLAY
+} InputMode;
+
+// Input captured for one frame
+typedef struct {
+  double time;         // Seconds since the window opened
+  uint16_t keys;       // Tracked keys pressed this frame (see replay.c)
+  uint8_t buttons;     // Left mouse button pressed / down / released
+  uint8_t charCount;
+  Vector2 mouse;
+  float wheel;
+  int chars[INPUT_MAX_CHARS];
+} InputFrame;
+
+// Switch to recording or replaying; both return false if the file can't be
+// opened (or isn't a recording). Replay hands back the recorded seed.
+bool startInputRecording(const char *path, uint32_t seed);
+bool startInputReplay(const char *path, uint32_t *seed);
+void stopInput(void);
+InputMode getInputMode(void);
+
+// Sample (or read back) this frame's input; false once a replay runs out
+bool beginInputFrame(void);
+
+bool inputKeyPressed(int key);
+int inputCharPressed(void);  // Same queue semantics as GetCharPressed
+Vector2 inputMousePosition(void);
+bool inputMouseButtonPressed(int button);
+bool inputMouseButtonDown(int button);
+bool inputMouseButtonReleased(int button);
+float inputMouseWheel(void);
+double inputTime(void);  // Recorded clock during replay, GetTime otherwise
+bool inputIdle(void);    // No keys, clicks, characters, wheel or mouse motion
+
+// Per-frame work timings collected during a replay
+void recordFrameTiming(double ms);
+void printReplayTimings(void);
+
+#endif // REPLAY_H
@@ -1,2 +1,2 @@
 #!/bin/bash
-eval cc -std=c11 main.c geodata.c game.c $(pkg-config --libs --cflags raylib) -lm -o main && ./main
+eval cc -std=c11 main.c geodata.c game.c geomath.c distworker.c solver.c uitext.c globelod.c viewcull.c picking.c replay.c hotreload.c distfield.c heatmap.c countrymap.c scratch.c renderbench.c memtrack.c $(pkg-config --libs --cflags raylib) -lm -lpthread -o main && ./main
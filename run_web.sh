@@ -36,5 +36,18 @@ elif command -v xdg-open &> /dev/null; then
 fi
 
 # Start Python HTTP server
+# COOP/COEP headers make the page cross-origin isolated so SharedArrayBuffer
+# (needed by the ./build_web.sh --threads flavor) is available
 cd "$OUTPUT_DIR"
-python3 -m http.server $PORT
+python3 - "$PORT" <<'EOF'
+import sys
+from http.server import SimpleHTTPRequestHandler, ThreadingHTTPServer
+
+class IsolatedHandler(SimpleHTTPRequestHandler):
+    def end_headers(self):
+        self.send_header("Cross-Origin-Opener-Policy", "same-origin")
+        self.send_header("Cross-Origin-Embedder-Policy", "require-corp")
+        super().end_headers()
+
+ThreadingHTTPServer(("", int(sys.argv[1])), IsolatedHandler).serve_forever()
+EOF
@@ -0,0 +1,93 @@
+#include "scratch.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SCRATCH_ALIGN sizeof(max_align_t)
+
+struct ScratchOverflow {
+  ScratchOverflow *next;
+  max_align_t payload[];  // Keeps the block max-aligned
+};
+
+static size_t alignUp(size_t size) {
+  return (size + SCRATCH_ALIGN - 1) & ~(SCRATCH_ALIGN - 1);
+}
+
+void initScratchArena(ScratchArena *arena, size_t capacity, MemTag tag) {
+  memset(arena, 0, sizeof(*arena));
+  arena->tag = tag;
+  arena->capacity = alignUp(capacity);
+  arena->base = arena->capacity ? memAlloc(tag, arena->capacity) : NULL;
+  if (!arena->base) arena->capacity = 0;
+}
+
+static void freeOverflow(ScratchArena *arena) {
+  while (arena->overflow) {
+    ScratchOverflow *next = arena->overflow->next;
+    memFree(arena->overflow);
+    arena->overflow = next;
+  }
+}
+
+void freeScratchArena(ScratchArena *arena) {
+  freeOverflow(arena);
+  memFree(arena->base);
+  memset(arena, 0, sizeof(*arena));
+}
+
+void resetScratchArena(ScratchArena *arena) {
+  if (arena->overflow) {
+    // Grow once with some headroom instead of overflowing again next frame
+    freeOverflow(arena);
+    size_t capacity = alignUp(arena->demand + arena->demand / 2);
+    unsigned char *base = memAlloc(arena->tag, capacity);
+    if (base) {
+      memFree(arena->base);
+      arena->base = base;
+      arena->capacity = capacity;
+    }
+  }
+  arena->used = 0;
+  arena->demand = 0;
+}
+
+void *scratchAlloc(ScratchArena *arena, size_t size) {
+  size = alignUp(size ? size : 1);
+  arena->demand += size;
+  if (arena->capacity - arena->used >= size) {
+    void *p = arena->base + arena->used;
+    arena->used += size;
+    return p;
+  }
+  ScratchOverflow *block = memAlloc(arena->tag, sizeof(ScratchOverflow) + size);
+  if (!block) return NULL;
+  block->next = arena->overflow;
+  arena->overflow = block;
+  return block->payload;
+}
+
+char *scratchFormat(ScratchArena *arena, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  va_list copy;
+  va_copy(copy, args);
+
+  // Format straight into the free space; only measure first if it won't fit
+  char *out = (char *)arena->base + arena->used;
+  size_t room = arena->capacity - arena->used;
+  int len = vsnprintf(room ? out : NULL, room, format, args);
+  va_end(args);
+  if (len < 0) {
+    va_end(copy);
+    return "";
+  }
+  if ((size_t)len < room) {
+    scratchAlloc(arena, (size_t)len + 1);  // Claims exactly the bytes written
+  } else {
+    out = scratchAlloc(arena, (size_t)len + 1);
+    if (out) vsnprintf(out, (size_t)len + 1, format, copy);
+  }
+  va_end(copy);
+  return out ? out : "";
+}
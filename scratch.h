@@ -0,0 +1,35 @@
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include "memtrack.h"
+#include <stddef.h>
+
+// Bump allocator for memory that only lives until the next reset, such as a
+// frame's formatted labels and search buffers. Allocating bumps a pointer
+// and a reset releases everything at once. A frame that asks for more than
+// the block holds gets the excess from the heap for that frame only, and the
+// block grows to the frame's total at the next reset, so after the first
+// busy frames nothing reaches the heap.
+
+typedef struct ScratchOverflow ScratchOverflow;
+
+typedef struct {
+  unsigned char *base;
+  size_t capacity;
+  size_t used;
+  size_t demand;              // Bytes asked for since the reset, overflow included
+  ScratchOverflow *overflow;  // Heap blocks taken past capacity this frame
+  MemTag tag;
+} ScratchArena;
+
+void initScratchArena(ScratchArena *arena, size_t capacity, MemTag tag);
+void freeScratchArena(ScratchArena *arena);
+void resetScratchArena(ScratchArena *arena);
+
+// Max-aligned; valid until the next reset
+void *scratchAlloc(ScratchArena *arena, size_t size);
+
+// printf into the arena (TextFormat without its handful of rotating buffers)
+char *scratchFormat(ScratchArena *arena, const char *format, ...);
+
+#endif // SCRATCH_H
@@ -0,0 +1,627 @@
+// Headless Globle server for a daily-puzzle service. Loads the country
+// database once and shares it read-only between every session; guesses are
+// evaluated on a worker pool. See server.h for the protocol.
+// Usage: ./server [--csv path] [--socket path] [--threads n] [--max-sessions n]
+#include "server.h"
+#include "game.h"
+#include "memtrack.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_SERVER_WORKERS 64
+#define SESSION_IDLE_SECONDS 3600.0  // Abandoned sessions are reclaimed after this
+#define CONNECTION_BUFFER (SERVER_MAX_LINE * 4)
+
+DEFINE_ARRAY(ReplyText, char, SERVER_MAX_LINE, MEM_TAG_GAME)
+
+typedef struct {
+  pthread_mutex_t lock;
+  uint32_t generation;  // Bumped on reuse so stale session ids are rejected
+  bool active;
+  double lastActive;
+  GameState *game;      // Kept across reuse of the slot
+} Session;
+
+typedef struct {
+  int fd;
+  char in[CONNECTION_BUFFER];
+  size_t inLen;
+  _Atomic bool busy;  // A worker owns this connection's current request
+  bool closed;        // Peer hung up; freed once no request is in flight
+} Connection;
+
+// Queued request (singly linked FIFO, as in distworker.c)
+typedef struct Request {
+  Connection *conn;
+  char line[SERVER_MAX_LINE];
+  struct Request *next;
+} Request;
+
+typedef struct {
+  Request *head;
+  Request *tail;
+} RequestQueue;
+
+DEFINE_ARRAY(ConnectionList, Connection *, 16, MEM_TAG_GAME)
+DEFINE_ARRAY(PollList, struct pollfd, 16, MEM_TAG_GAME)
+
+static CountryDatabase *db;
+static Session *sessions;
+static uint32_t sessionCapacity;
+static uint32_t *freeSlots;  // Stack of unused session slots
+static uint32_t freeCount;
+static pthread_mutex_t tableLock = PTHREAD_MUTEX_INITIALIZER;
+
+static RequestQueue queue;
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueReady = PTHREAD_COND_INITIALIZER;
+static pthread_t workers[MAX_SERVER_WORKERS];
+static int workerCount = 0;
+static bool workersStopping = false;
+
+static int wakePipe[2] = {-1, -1};  // Workers and signals wake the I/O loop
+static volatile sig_atomic_t stopping = 0;
+
+static _Atomic uint64_t requestCount;
+static _Atomic uint64_t guessCount;
+static _Atomic uint32_t activeSessions;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void wakeLoop(void) {
+  char c = 0;
+  if (write(wakePipe[1], &c, 1) < 0) {
+    // Pipe full: the loop is already due to wake up
+  }
+}
+
+static void onSignal(int sig) {
+  (void)sig;
+  stopping = 1;
+  wakeLoop();
+}
+
+static void replyf(ReplyText *out, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(NULL, 0, fmt, args);
+  va_end(args);
+  if (n <= 0) return;
+
+  ReplyText_reserve(out, out->size + (uint32_t)n + 1);
+  va_start(args, fmt);
+  vsnprintf(ReplyText_data(out) + out->size, (size_t)n + 1, fmt, args);
+  va_end(args);
+  out->size += (uint32_t)n;
+}
+
+// Sessions
+
+static void initSessions(uint32_t capacity) {
+  sessionCapacity = capacity;
+  sessions = memCalloc(MEM_TAG_GAME, capacity, sizeof(Session));
+  freeSlots = memAlloc(MEM_TAG_GAME, capacity * sizeof(uint32_t));
+  for (uint32_t i = 0; i < capacity; i++) {
+    pthread_mutex_init(&sessions[i].lock, NULL);
+    freeSlots[i] = capacity - 1 - i;  // Hand out low slots first
+  }
+  freeCount = capacity;
+}
+
+static void freeSessions(void) {
+  for (uint32_t i = 0; i < sessionCapacity; i++) {
+    pthread_mutex_destroy(&sessions[i].lock);
+    memFree(sessions[i].game);
+  }
+  memFree(sessions);
+  memFree(freeSlots);
+}
+
+static void releaseSlot(uint32_t slot) {
+  pthread_mutex_lock(&tableLock);
+  freeSlots[freeCount++] = slot;
+  pthread_mutex_unlock(&tableLock);
+  atomic_fetch_sub(&activeSessions, 1);
+}
+
+// Called with the session locked
+static void endSession(Session *s) {
+  s->active = false;
+  s->generation++;
+}
+
+// Free sessions nobody has touched for SESSION_IDLE_SECONDS
+static void reclaimIdleSessions(void) {
+  double cutoff = now() - SESSION_IDLE_SECONDS;
+  for (uint32_t i = 0; i < sessionCapacity; i++) {
+    Session *s = &sessions[i];
+    if (pthread_mutex_trylock(&s->lock) != 0) continue;  // In use, so not idle
+    bool idle = s->active && s->lastActive < cutoff;
+    if (idle) endSession(s);
+    pthread_mutex_unlock(&s->lock);
+    if (idle) releaseSlot(i);
+  }
+}
+
+static bool takeSlot(uint32_t *slot) {
+  for (int attempt = 0; attempt < 2; attempt++) {
+    pthread_mutex_lock(&tableLock);
+    bool ok = freeCount > 0;
+    if (ok) *slot = freeSlots[--freeCount];
+    pthread_mutex_unlock(&tableLock);
+    if (ok) return true;
+    if (attempt == 0) reclaimIdleSessions();
+  }
+  return false;
+}
+
+// Returns the session locked, or NULL if the id is unknown or has ended
+static Session *lockSession(const char *idText) {
+  char *end;
+  unsigned long long id = strtoull(idText, &end, 10);
+  if (end == idText) return NULL;
+  uint32_t slot = (uint32_t)id;
+  uint32_t generation = (uint32_t)(id >> 32);
+  if (slot >= sessionCapacity) return NULL;
+
+  Session *s = &sessions[slot];
+  pthread_mutex_lock(&s->lock);
+  if (!s->active || s->generation != generation) {
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+  }
+  s->lastActive = now();
+  return s;
+}
+
+static unsigned long long sessionId(uint32_t slot) {
+  return ((unsigned long long)sessions[slot].generation << 32) | slot;
+}
+
+// Requests
+
+// Split off the next space-separated word; returns NULL at end of line
+static char *nextWord(char **cursor) {
+  char *p = *cursor;
+  while (*p == ' ') p++;
+  if (!*p) return NULL;
+  char *word = p;
+  while (*p && *p != ' ') p++;
+  if (*p) *p++ = '\0';
+  *cursor = p;
+  return word;
+}
+
+static void handleNew(char *args, ReplyText *out) {
+  uint32_t seed = (uint32_t)(time(NULL) / 86400);  // Daily puzzle
+  DistanceMode mode = DISTANCE_MODE_BORDER_TO_BORDER;
+  char *word;
+  while ((word = nextWord(&args))) {
+    char *end;
+    unsigned long value = strtoul(word, &end, 10);
+    if (*end == '\0') {
+      seed = (uint32_t)value;
+    } else if (strcmp(word, "centroid") == 0) {
+      mode = DISTANCE_MODE_CENTROID;
+    } else if (strcmp(word, "border") != 0) {
+      replyf(out, "ERR unknown option %s\n", word);
+      return;
+    }
+  }
+
+  uint32_t slot;
+  if (!takeSlot(&slot)) {
+    replyf(out, "ERR session limit reached\n");
+    return;
+  }
+
+  Session *s = &sessions[slot];
+  pthread_mutex_lock(&s->lock);
+  if (!s->game) {
+    s->game = memAlloc(MEM_TAG_GAME, sizeof(GameState));
+  }
+  initGame(s->game, db);
+  s->game->currentDistanceMode = mode;
+  selectSeededMysteryCountry(s->game, seed);
+  s->lastActive = now();
+  s->game->startTime = s->lastActive;
+  s->active = true;
+  atomic_fetch_add(&activeSessions, 1);
+  unsigned long long id = sessionId(slot);
+  pthread_mutex_unlock(&s->lock);
+
+  replyf(out, "OK %llu\n", id);
+}
+
+static void handleGuess(char *args, ReplyText *out) {
+  char *idText = nextWord(&args);
+  while (*args == ' ') args++;
+  if (!idText || !*args) {
+    replyf(out, "ERR usage: GUESS <session> <country>\n");
+    return;
+  }
+
+  CountryData *country = getCountryByName(db, args);
+  if (!country) {
+    replyf(out, "ERR unknown country\n");
+    return;
+  }
+
+  Session *s = lockSession(idText);
+  if (!s) {
+    replyf(out, "ERR unknown session\n");
+    return;
+  }
+
+  GameState *game = s->game;
+  if (game->won) {
+    replyf(out, "ERR already won\n");
+  } else if (hasGuessed(game, country)) {
+    replyf(out, "ERR already guessed\n");
+  } else if (game->guessCount >= MAX_GUESSES) {
+    replyf(out, "ERR guess limit reached\n");
+  } else {
+    // The database is read-only, so only this session is locked while the
+    // border distance is computed
+    makeGuess(game, country);
+    atomic_fetch_add(&guessCount, 1);
+    if (game->won) {
+      game->elapsedTime = now() - game->startTime;
+      game->finalScore = calculateScore(game);
+    }
+    replyf(out, "OK %.1f %d %d %d\n", game->guesses[game->guessCount - 1].distance,
+           game->won, game->guessCount, game->finalScore);
+  }
+  pthread_mutex_unlock(&s->lock);
+}
+
+static void handleScore(char *args, ReplyText *out) {
+  char *idText = nextWord(&args);
+  Session *s = idText ? lockSession(idText) : NULL;
+  if (!s) {
+    replyf(out, "ERR unknown session\n");
+    return;
+  }
+  replyf(out, "OK %d %d %d\n", s->game->finalScore, s->game->guessCount, s->game->won);
+  pthread_mutex_unlock(&s->lock);
+}
+
+static void handleEnd(char *args, ReplyText *out) {
+  char *idText = nextWord(&args);
+  Session *s = idText ? lockSession(idText) : NULL;
+  if (!s) {
+    replyf(out, "ERR unknown session\n");
+    return;
+  }
+  uint32_t slot = (uint32_t)(s - sessions);
+  endSession(s);
+  pthread_mutex_unlock(&s->lock);
+  releaseSlot(slot);
+  replyf(out, "OK\n");
+}
+
+static void handleRequest(char *line, ReplyText *out) {
+  atomic_fetch_add(&requestCount, 1);
+  char *args = line;
+  char *command = nextWord(&args);
+  if (!command) {
+    replyf(out, "ERR empty request\n");
+  } else if (strcmp(command, "NEW") == 0) {
+    handleNew(args, out);
+  } else if (strcmp(command, "GUESS") == 0) {
+    handleGuess(args, out);
+  } else if (strcmp(command, "SCORE") == 0) {
+    handleScore(args, out);
+  } else if (strcmp(command, "END") == 0) {
+    handleEnd(args, out);
+  } else if (strcmp(command, "COUNTRIES") == 0) {
+    replyf(out, "OK %llu\n", (unsigned long long)db->count);
+    for (uint64_t i = 0; i < db->count; i++) {
+      replyf(out, "%s\n", db->countries[i].englishName);
+    }
+  } else if (strcmp(command, "STATS") == 0) {
+    replyf(out, "OK %u %llu %llu\n", atomic_load(&activeSessions),
+           (unsigned long long)atomic_load(&requestCount),
+           (unsigned long long)atomic_load(&guessCount));
+  } else {
+    replyf(out, "ERR unknown command %s\n", command);
+  }
+}
+
+// Workers
+
+static void queuePush(RequestQueue *q, Request *req) {
+  req->next = NULL;
+  if (q->tail) {
+    q->tail->next = req;
+  } else {
+    q->head = req;
+  }
+  q->tail = req;
+}
+
+static Request *queuePop(RequestQueue *q) {
+  Request *req = q->head;
+  if (req) {
+    q->head = req->next;
+    if (!q->head) q->tail = NULL;
+  }
+  return req;
+}
+
+static void sendAll(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return;  // Peer went away; the I/O loop notices on read
+    data += n;
+    size -= (size_t)n;
+  }
+}
+
+static void *workerMain(void *arg) {
+  (void)arg;
+  ReplyText reply;
+  ReplyText_init(&reply);
+  for (;;) {
+    pthread_mutex_lock(&queueLock);
+    while (!queue.head && !workersStopping) {
+      pthread_cond_wait(&queueReady, &queueLock);
+    }
+    Request *req = queuePop(&queue);
+    pthread_mutex_unlock(&queueLock);
+    if (!req) break;  // Stopping and drained
+
+    reply.size = 0;
+    handleRequest(req->line, &reply);
+    sendAll(req->conn->fd, ReplyText_data(&reply), reply.size);
+
+    // Last touch of the connection: the I/O loop may free it after this
+    atomic_store(&req->conn->busy, false);
+    memFree(req);
+    wakeLoop();
+  }
+  ReplyText_free(&reply);
+  return NULL;
+}
+
+// Finish queued requests, then join the pool
+static void stopWorkers(void) {
+  pthread_mutex_lock(&queueLock);
+  workersStopping = true;
+  pthread_cond_broadcast(&queueReady);
+  pthread_mutex_unlock(&queueLock);
+  for (int i = 0; i < workerCount; i++) {
+    pthread_join(workers[i], NULL);
+  }
+  workerCount = 0;
+}
+
+// I/O loop
+
+// Hand the connection's next complete line to the workers
+static void dispatchLine(Connection *conn) {
+  char *newline = memchr(conn->in, '\n', conn->inLen);
+  if (!newline) {
+    if (conn->inLen == sizeof(conn->in)) conn->closed = true;  // Line too long
+    return;
+  }
+
+  size_t len = (size_t)(newline - conn->in);
+  Request *req = memAlloc(MEM_TAG_GAME, sizeof(Request));
+  req->conn = conn;
+  if (len >= sizeof(req->line)) len = sizeof(req->line) - 1;
+  memcpy(req->line, conn->in, len);
+  req->line[len] = '\0';
+  if (len > 0 && req->line[len - 1] == '\r') req->line[len - 1] = '\0';
+
+  size_t consumed = (size_t)(newline - conn->in) + 1;
+  memmove(conn->in, conn->in + consumed, conn->inLen - consumed);
+  conn->inLen -= consumed;
+
+  atomic_store(&conn->busy, true);
+  pthread_mutex_lock(&queueLock);
+  queuePush(&queue, req);
+  pthread_cond_signal(&queueReady);
+  pthread_mutex_unlock(&queueLock);
+}
+
+static void acceptConnections(int listenFd, ConnectionList *conns) {
+  for (;;) {
+    int fd = accept(listenFd, NULL, NULL);
+    if (fd < 0) return;  // EAGAIN: no more pending
+    Connection *conn = memCalloc(MEM_TAG_GAME, 1, sizeof(Connection));
+    conn->fd = fd;
+    ConnectionList_push(conns, conn);
+  }
+}
+
+static void readConnection(Connection *conn) {
+  size_t room = sizeof(conn->in) - conn->inLen;
+  if (room == 0) return;
+  ssize_t n = read(conn->fd, conn->in + conn->inLen, room);
+  if (n > 0) {
+    conn->inLen += (size_t)n;
+  } else if (n == 0 || (errno != EINTR && errno != EAGAIN)) {
+    conn->closed = true;
+  }
+}
+
+static void runLoop(int listenFd) {
+  ConnectionList conns;
+  ConnectionList_init(&conns);
+  PollList fds;
+  PollList_init(&fds);
+
+  while (!stopping) {
+    Connection **list = ConnectionList_data(&conns);
+    PollList_reserve(&fds, conns.size + 2);
+    struct pollfd *pfd = PollList_data(&fds);
+    pfd[0] = (struct pollfd){listenFd, POLLIN, 0};
+    pfd[1] = (struct pollfd){wakePipe[0], POLLIN, 0};
+    for (uint32_t i = 0; i < conns.size; i++) {
+      // Stop reading once a full buffer is waiting on a busy request
+      bool full = list[i]->inLen == sizeof(list[i]->in);
+      pfd[i + 2] = (struct pollfd){list[i]->fd, full ? 0 : POLLIN, 0};
+    }
+    if (poll(pfd, conns.size + 2, 1000) < 0 && errno != EINTR) {
+      perror("poll");
+      break;
+    }
+
+    if (pfd[1].revents & POLLIN) {
+      char drain[64];
+      while (read(wakePipe[0], drain, sizeof(drain)) > 0) {
+      }
+    }
+    uint32_t polled = conns.size;
+    for (uint32_t i = 0; i < polled; i++) {
+      if (pfd[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) {
+        readConnection(list[i]);
+      }
+    }
+    if (pfd[0].revents & POLLIN) {
+      acceptConnections(listenFd, &conns);
+      list = ConnectionList_data(&conns);
+    }
+
+    // Dispatch idle connections' next lines and drop finished ones
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < conns.size; i++) {
+      Connection *conn = list[i];
+      bool busy = atomic_load(&conn->busy);
+      if (!busy && !conn->closed) {
+        dispatchLine(conn);
+        busy = atomic_load(&conn->busy);
+      }
+      if (conn->closed && !busy) {
+        close(conn->fd);
+        memFree(conn);
+        continue;
+      }
+      list[kept++] = conn;
+    }
+    conns.size = kept;
+  }
+
+  // Once the workers are gone nothing references the connections
+  stopWorkers();
+  Connection **list = ConnectionList_data(&conns);
+  for (uint32_t i = 0; i < conns.size; i++) {
+    close(list[i]->fd);
+    memFree(list[i]);
+  }
+  ConnectionList_free(&conns);
+  PollList_free(&fds);
+}
+
+static int openSocket(const char *path) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Error: Socket path too long: %s\n", path);
+    close(fd);
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+  unlink(path);  // Stale socket from an earlier run
+
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 512) < 0) {
+    perror(path);
+    close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+int main(int argc, char **argv) {
+  const char *csvPath = "./coordinates/ccc.csv";
+  const char *socketPath = SERVER_SOCKET_PATH;
+  long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t maxSessions = 65536;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+      csvPath = argv[++i];
+    } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+      socketPath = argv[++i];
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threadCount = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--max-sessions") == 0 && i + 1 < argc) {
+      maxSessions = (uint32_t)atol(argv[++i]);
+    } else {
+      fprintf(stderr, "Usage: %s [--csv path] [--socket path] [--threads n] "
+              "[--max-sessions n]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (threadCount < 1) threadCount = 1;
+  if (threadCount > MAX_SERVER_WORKERS) threadCount = MAX_SERVER_WORKERS;
+  if (maxSessions < 1) maxSessions = 1;
+
+  setGameLogging(false);
+  db = loadCountryDatabase(csvPath);
+  if (!db) {
+    printf("Failed to load country database!\n");
+    return 1;
+  }
+
+  int listenFd = openSocket(socketPath);
+  if (listenFd < 0 || pipe(wakePipe) < 0) {
+    freeCountryDatabase(db);
+    return 1;
+  }
+  fcntl(wakePipe[0], F_SETFL, fcntl(wakePipe[0], F_GETFL) | O_NONBLOCK);
+  fcntl(wakePipe[1], F_SETFL, fcntl(wakePipe[1], F_GETFL) | O_NONBLOCK);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  initSessions(maxSessions);
+  while (workerCount < threadCount &&
+         pthread_create(&workers[workerCount], NULL, workerMain, NULL) == 0) {
+    workerCount++;
+  }
+  printf("Serving %llu countries on %s with %d worker(s), up to %u sessions\n",
+         (unsigned long long)db->count, socketPath, workerCount, maxSessions);
+
+  if (workerCount > 0) {
+    runLoop(listenFd);
+  }
+  stopWorkers();
+
+  printf("Served %llu requests (%llu guesses)\n",
+         (unsigned long long)atomic_load(&requestCount),
+         (unsigned long long)atomic_load(&guessCount));
+  close(listenFd);
+  unlink(socketPath);
+  close(wakePipe[0]);
+  close(wakePipe[1]);
+  freeSessions();
+  freeCountryDatabase(db);
+  printMemoryReport("exit");
+  return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+// Line protocol spoken by the headless server (server.c) and the load
+// generator (loadgen.c) over a Unix stream socket. Requests and replies are
+// single lines ending in '\n'; replies start with "OK" or "ERR <message>".
+// A connection has at most one request in flight: the server reads the next
+// line only after replying to the previous one.
+//
+//   NEW [seed] [border|centroid]  -> OK <session>
+//       Starts a session. The seed picks the mystery country (default: days
+//       since the Unix epoch, so every session that day shares a puzzle).
+//   GUESS <session> <country>     -> OK <km> <won> <guesses> <score>
+//       Country names match case-insensitively; score is 0 until won.
+//   SCORE <session>               -> OK <score> <guesses> <won>
+//   END <session>                 -> OK
+//   COUNTRIES                     -> OK <n>, then n lines of names
+//   STATS                         -> OK <sessions> <requests> <guesses>
+
+#define SERVER_SOCKET_PATH "/tmp/globle.sock"
+#define SERVER_MAX_LINE 256
+
+#endif // SERVER_H
@@ -0,0 +1,378 @@
+#include "solver.h"
+#include "memtrack.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+  float km;
+  uint32_t country;
+} RangeEntry;
+
+static double now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Distance table
+
+void initDistanceTable(DistanceTable *t, CountryDatabase *db, DistanceMode mode) {
+  memset(t, 0, sizeof(*t));
+  t->db = db;
+  t->mode = mode;
+  t->toleranceKm = mode == DISTANCE_MODE_CENTROID ? SOLVER_TOLERANCE_CENTROID_KM
+                                                  : SOLVER_TOLERANCE_BORDER_KM;
+  t->count = (uint32_t)db->count;
+  size_t cells = (size_t)t->count * t->count;
+  t->km = memCalloc(MEM_TAG_GAME, cells ? cells : 1, sizeof(float));
+  t->byRange = memAlloc(MEM_TAG_GAME, (cells ? cells : 1) * sizeof(uint32_t));
+  t->pairCount = (uint64_t)t->count * (t->count ? t->count - 1 : 0) / 2;
+  t->nextCol = 1;
+}
+
+void freeDistanceTable(DistanceTable *t) {
+  memFree(t->km);
+  memFree(t->byRange);
+  memFree(t->known);
+  memset(t, 0, sizeof(*t));
+}
+
+void setTableDistance(DistanceTable *t, uint32_t a, uint32_t b, float km) {
+  t->km[(size_t)a * t->count + b] = km;
+  t->km[(size_t)b * t->count + a] = km;
+}
+
+static int compareRange(const void *a, const void *b) {
+  const RangeEntry *ra = a;
+  const RangeEntry *rb = b;
+  if (ra->km != rb->km) return ra->km < rb->km ? -1 : 1;
+  return (ra->country > rb->country) - (ra->country < rb->country);
+}
+
+void finishDistanceTable(DistanceTable *t) {
+  uint32_t n = t->count;
+  RangeEntry *row = memAlloc(MEM_TAG_GAME, (n ? n : 1) * sizeof(RangeEntry));
+  for (uint32_t i = 0; i < n; i++) {
+    const float *km = &t->km[(size_t)i * n];
+    for (uint32_t j = 0; j < n; j++) {
+      row[j] = (RangeEntry){km[j], j};
+    }
+    qsort(row, n, sizeof(RangeEntry), compareRange);
+    uint32_t *out = &t->byRange[(size_t)i * n];
+    for (uint32_t j = 0; j < n; j++) {
+      out[j] = row[j].country;
+    }
+  }
+  memFree(row);
+  memFree(t->known);
+  t->known = NULL;
+  t->pairsDone = t->pairCount;
+  t->ready = true;
+}
+
+// Incremental builds walk the pairs a < b row by row; the cursor is past
+// the last pair once nextCol reaches count
+
+static bool isKnownPair(const DistanceTable *t, uint32_t a, uint32_t b) {
+  return t->known && t->known[(size_t)a * t->count + b];
+}
+
+static void advanceCursor(DistanceTable *t) {
+  if (++t->nextCol == t->count) {
+    t->nextRow++;
+    t->nextCol = t->nextRow + 1;
+  }
+}
+
+static void finishIfComplete(DistanceTable *t) {
+  if (!t->ready && t->pairsDone == t->pairCount) {
+    finishDistanceTable(t);
+  }
+}
+
+bool advanceDistanceTable(DistanceTable *t, double budgetSeconds) {
+  if (t->ready) return true;
+  double deadline = now() + budgetSeconds;
+  CountryData *countries = t->db->countries;
+  while (t->nextCol < t->count) {
+    if (!isKnownPair(t, t->nextRow, t->nextCol)) {
+      CountryData *a = &countries[t->nextRow];
+      CountryData *b = &countries[t->nextCol];
+      float km = t->mode == DISTANCE_MODE_CENTROID
+                     ? calculateDistance(a->centroid, b->centroid)
+                     : calculateBorderToBorderDistance(a, b);
+      setTableDistance(t, t->nextRow, t->nextCol, km);
+    }
+    t->pairsDone++;
+    advanceCursor(t);
+    if (now() >= deadline) break;
+  }
+  finishIfComplete(t);
+  return t->ready;
+}
+
+bool nextTablePair(DistanceTable *t, uint32_t *a, uint32_t *b) {
+  // Pairs carried over by remapDistanceTable are in already
+  while (t->nextCol < t->count && isKnownPair(t, t->nextRow, t->nextCol)) {
+    t->pairsDone++;
+    advanceCursor(t);
+  }
+  finishIfComplete(t);
+  if (t->nextCol >= t->count) return false;
+  *a = t->nextRow;
+  *b = t->nextCol;
+  advanceCursor(t);
+  return true;
+}
+
+void completeTablePair(DistanceTable *t, uint32_t a, uint32_t b, float km) {
+  setTableDistance(t, a, b, km);
+  t->pairsDone++;
+  finishIfComplete(t);
+}
+
+// Field-based border fill
+
+void initTableFields(TableFields *f, float cellDegrees) {
+  memset(f, 0, sizeof(*f));
+  initFieldGrid(&f->grid, cellDegrees);
+}
+
+void clearTableFields(TableFields *f) {
+  for (uint32_t i = 0; i < f->bordersBuilt; i++) {
+    CellList_free(&f->border[i]);
+  }
+  memFree(f->border);
+  f->border = NULL;
+  f->count = 0;
+  f->bordersBuilt = 0;
+}
+
+void freeTableFields(TableFields *f) {
+  clearTableFields(f);
+  freeFieldGrid(&f->grid);
+}
+
+bool advanceDistanceTableFields(DistanceTable *t, TableFields *f, double budgetSeconds) {
+  if (t->ready) return true;
+  double deadline = now() + budgetSeconds;
+  CountryData *countries = t->db->countries;
+  if (!f->border) {
+    f->count = t->count;
+    f->border = memAlloc(MEM_TAG_FIELDS, (f->count ? f->count : 1) * sizeof(CellList));
+  }
+  // A field is read at cell centers, up to a cell error from the border
+  // sample, and its sweeps can miss the nearest sample by about as much again
+  t->toleranceKm = SOLVER_TOLERANCE_BORDER_KM + 2.0f * fieldCellErrorKm(&f->grid);
+
+  // Border cells are small and quick; every row needs the later countries'
+  while (f->bordersBuilt < f->count) {
+    buildBorderCells(&f->grid, &countries[f->bordersBuilt], &f->border[f->bordersBuilt]);
+    f->bordersBuilt++;
+    if (now() >= deadline) return false;
+  }
+
+  while (t->nextCol < t->count) {
+    uint32_t row = t->nextRow;
+    CountryField field = {0};
+    bool built = false;
+    do {
+      if (!isKnownPair(t, row, t->nextCol)) {
+        if (!built) {
+          buildCountryField(&f->grid, &countries[row], &field);
+          built = true;
+        }
+        setTableDistance(t, row, t->nextCol,
+                         fieldBorderDistance(&field, &f->border[t->nextCol]));
+      }
+      t->pairsDone++;
+      advanceCursor(t);
+    } while (t->nextRow == row && t->nextCol < t->count);
+    if (built) {
+      freeCountryField(&field);
+      if (now() >= deadline) break;
+    }
+  }
+  finishIfComplete(t);
+  return t->ready;
+}
+
+// Whether an incremental build has reached pair (a, b)
+static bool hasTablePair(const DistanceTable *t, uint32_t a, uint32_t b) {
+  uint32_t lo = a < b ? a : b;
+  uint32_t hi = a < b ? b : a;
+  if (t->ready || lo < t->nextRow) return true;
+  return lo == t->nextRow && hi < t->nextCol;
+}
+
+uint64_t remapDistanceTable(DistanceTable *t, CountryDatabase *db, const int32_t *source) {
+  DistanceTable old = *t;
+  initDistanceTable(t, db, old.mode);
+  t->toleranceKm = old.toleranceKm;
+  uint32_t n = t->count;
+  size_t cells = (size_t)n * n;
+  t->known = memCalloc(MEM_TAG_GAME, cells ? cells : 1, 1);
+
+  uint64_t kept = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    if (source[i] < 0) continue;
+    for (uint32_t j = i + 1; j < n; j++) {
+      if (source[j] < 0 || !hasTablePair(&old, source[i], source[j])) continue;
+      setTableDistance(t, i, j, tableDistance(&old, source[i], source[j]));
+      t->known[(size_t)i * n + j] = 1;
+      kept++;
+    }
+  }
+  freeDistanceTable(&old);
+  return kept;
+}
+
+float tableDistance(const DistanceTable *t, uint32_t a, uint32_t b) {
+  return t->km[(size_t)a * t->count + b];
+}
+
+float getDistanceTableProgress(const DistanceTable *t) {
+  if (t->ready || t->pairCount == 0) return 1.0f;
+  return (float)((double)t->pairsDone / (double)t->pairCount);
+}
+
+// Country sets
+
+void initCountrySet(CountrySet *set, uint32_t count, bool full) {
+  CountrySet_init(set);
+  uint32_t words = (count + 63) / 64;
+  CountrySet_reserve(set, words);
+  set->size = words;
+  uint64_t *w = CountrySet_data(set);
+  memset(w, full ? 0xFF : 0, words * sizeof(uint64_t));
+  if (full && count % 64) {
+    w[words - 1] = (UINT64_C(1) << (count % 64)) - 1;  // No bits past the end
+  }
+}
+
+void addToCountrySet(CountrySet *set, uint32_t country) {
+  CountrySet_data(set)[country / 64] |= UINT64_C(1) << (country % 64);
+}
+
+bool inCountrySet(const CountrySet *set, uint32_t country) {
+  return (CountrySet_data(set)[country / 64] >> (country % 64)) & 1;
+}
+
+uint32_t countCountrySet(const CountrySet *set) {
+  const uint64_t *w = CountrySet_data(set);
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < set->size; i++) {
+    total += (uint32_t)__builtin_popcountll(w[i]);
+  }
+  return total;
+}
+
+// Solver
+
+// First position in row whose distance is at least km
+static uint32_t lowerBound(const DistanceTable *t, uint32_t row, float km) {
+  const uint32_t *order = &t->byRange[(size_t)row * t->count];
+  const float *dist = &t->km[(size_t)row * t->count];
+  uint32_t lo = 0, hi = t->count;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (dist[order[mid]] < km) lo = mid + 1; else hi = mid;
+  }
+  return lo;
+}
+
+void applySolverGuess(const DistanceTable *t, CountrySet *candidates, uint32_t guess,
+                      float km) {
+  float tol = t->toleranceKm;
+  const uint32_t *order = &t->byRange[(size_t)guess * t->count];
+  const float *dist = &t->km[(size_t)guess * t->count];
+
+  // Countries in range form one run of the sorted row
+  CountrySet match;
+  initCountrySet(&match, t->count, false);
+  for (uint32_t i = lowerBound(t, guess, km - tol);
+       i < t->count && dist[order[i]] <= km + tol; i++) {
+    addToCountrySet(&match, order[i]);
+  }
+
+  // Whole-word AND; the loop vectorizes once sets outgrow a register
+  uint64_t *c = CountrySet_data(candidates);
+  const uint64_t *m = CountrySet_data(&match);
+  for (uint32_t w = 0; w < candidates->size; w++) {
+    c[w] &= m[w];
+  }
+  CountrySet_free(&match);
+}
+
+SolverHint suggestSolverGuess(const DistanceTable *t, const CountrySet *candidates,
+                              const CountrySet *guessed) {
+  SolverHint hint = {-1, countCountrySet(candidates), 0.0f};
+  if (hint.candidates == 0) return hint;
+
+  float tol = t->toleranceKm;
+  float *ranges = memAlloc(MEM_TAG_GAME, t->count * sizeof(float));
+  float best = INFINITY;
+  bool bestIsCandidate = false;
+
+  for (uint32_t g = 0; g < t->count; g++) {
+    if (inCountrySet(guessed, g)) continue;
+    bool isCandidate = inCountrySet(candidates, g);
+
+    // Candidates other than g, in order of their distance from g
+    const uint32_t *order = &t->byRange[(size_t)g * t->count];
+    const float *dist = &t->km[(size_t)g * t->count];
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < t->count; i++) {
+      uint32_t c = order[i];
+      if (c != g && inCountrySet(candidates, c)) ranges[n++] = dist[c];
+    }
+
+    // If the mystery is c, the candidates left are those g cannot tell
+    // apart from it; a sliding window counts them for every c at once
+    uint64_t total = 0;
+    uint32_t lo = 0, hi = 0;
+    for (uint32_t i = 0; i < n; i++) {
+      while (ranges[lo] < ranges[i] - tol) lo++;
+      while (hi < n && ranges[hi] <= ranges[i] + tol) hi++;
+      total += hi - lo;
+    }
+    float expected = (float)total / (float)hint.candidates;  // Guessing g itself leaves 0
+
+    if (expected < best || (expected == best && isCandidate && !bestIsCandidate)) {
+      best = expected;
+      bestIsCandidate = isCandidate;
+      hint.country = (int32_t)g;
+      hint.expectedRemaining = expected;
+    }
+  }
+  memFree(ranges);
+  return hint;
+}
+
+SolverHint getGameHint(const DistanceTable *t, const GameState *game) {
+  CountrySet candidates, guessed;
+  initCountrySet(&candidates, t->count, true);
+  initCountrySet(&guessed, t->count, false);
+  for (int i = 0; i < game->guessCount; i++) {
+    const Guess *guess = &game->guesses[i];
+    uint32_t country = (uint32_t)(guess->country - t->db->countries);
+    addToCountrySet(&guessed, country);
+    if (!guess->pending) {
+      applySolverGuess(t, &candidates, country, guess->distance);
+    }
+  }
+
+  // A wrong guess can still be in range of itself (0 km in border mode)
+  uint64_t *c = CountrySet_data(&candidates);
+  const uint64_t *g = CountrySet_data(&guessed);
+  for (uint32_t w = 0; w < candidates.size; w++) {
+    c[w] &= ~g[w];
+  }
+
+  SolverHint hint = suggestSolverGuess(t, &candidates, &guessed);
+  CountrySet_free(&candidates);
+  CountrySet_free(&guessed);
+  return hint;
+}
@@ -0,0 +1,109 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "game.h"
+#include "array.h"
+#include "distfield.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Guess solver: narrows the mystery country to the set still consistent with
+// every reported distance and suggests the guess that leaves the fewest
+// candidates on average. Runs off a table of all pairwise distances for one
+// mode, so a hint is a few passes over bitsets and pre-sorted rows.
+
+// Reported and tabled distances can differ slightly: border distance stops
+// at the first pair under 5 km, which depends on argument order
+#define SOLVER_TOLERANCE_CENTROID_KM 0.5f
+#define SOLVER_TOLERANCE_BORDER_KM 5.0f
+
+// Bitset over country indices; four inline words cover 256 countries
+DEFINE_ARRAY(CountrySet, uint64_t, 4, MEM_TAG_GAME)
+
+typedef struct {
+  CountryDatabase *db;
+  DistanceMode mode;
+  float toleranceKm;  // How far a reported distance may be from the tabled one
+  uint32_t count;
+  float *km;          // count x count, symmetric
+  uint32_t *byRange;  // Row i: country indices sorted by distance from i
+  uint64_t pairsDone;
+  uint64_t pairCount;  // count * (count - 1) / 2
+  uint32_t nextRow;    // Next pair to hand out in an incremental build
+  uint32_t nextCol;
+  uint8_t *known;      // Pairs carried over by remapDistanceTable, or NULL
+  bool ready;          // Every pair is in and the rows are sorted
+} DistanceTable;
+
+typedef struct {
+  int32_t country;          // Suggested guess, or -1
+  uint32_t candidates;      // Countries still consistent with the guesses
+  float expectedRemaining;  // Candidates left on average after the suggestion
+} SolverHint;
+
+void initDistanceTable(DistanceTable *t, CountryDatabase *db, DistanceMode mode);
+void freeDistanceTable(DistanceTable *t);
+
+// Compute pairs in order until budgetSeconds has passed (at least one pair);
+// returns true once the table is ready. A centroid pair takes microseconds,
+// so the frame loop can fill a centroid table a slice at a time; one exact
+// border pair can take longer than a frame.
+bool advanceDistanceTable(DistanceTable *t, double budgetSeconds);
+
+// Incremental fill computed elsewhere (e.g. on the distance workers): hand
+// out the next pair still missing (a < b), false once all are out; the table
+// finishes itself when the last one is completed
+bool nextTablePair(DistanceTable *t, uint32_t *a, uint32_t *b);
+void completeTablePair(DistanceTable *t, uint32_t a, uint32_t b, float km);
+
+// Border distances from raster fields instead of the exact engine, for
+// builds without worker threads. Every country's border cells are built
+// first, then each row costs one field build, however detailed the rings
+// are. The table's tolerance widens by twice the grid's error.
+typedef struct {
+  FieldGrid grid;
+  CellList *border;       // Per country, NULL until the first advance
+  uint32_t count;
+  uint32_t bordersBuilt;
+} TableFields;
+
+void initTableFields(TableFields *f, float cellDegrees);
+void freeTableFields(TableFields *f);
+void clearTableFields(TableFields *f);  // Drop border cells (e.g. new database)
+
+// Fill rows until budgetSeconds has passed (at least one step); returns true
+// once the table is ready
+bool advanceDistanceTableFields(DistanceTable *t, TableFields *f, double budgetSeconds);
+
+// Batch fill: set every pair (a < b) from any thread, then finish once
+void setTableDistance(DistanceTable *t, uint32_t a, uint32_t b, float km);
+void finishDistanceTable(DistanceTable *t);
+
+// Move the table onto a new database snapshot. source[i] is the index in the
+// old database of the country now at i, or -1 if it changed; distances
+// between unchanged countries are kept and only the rest are recomputed.
+// Every pair handed out by nextTablePair must have been completed.
+// Returns the number of pairs kept.
+uint64_t remapDistanceTable(DistanceTable *t, CountryDatabase *db, const int32_t *source);
+
+float tableDistance(const DistanceTable *t, uint32_t a, uint32_t b);
+float getDistanceTableProgress(const DistanceTable *t);  // 0..1
+
+// Candidate sets. A set must be sized with initCountrySet before use.
+void initCountrySet(CountrySet *set, uint32_t count, bool full);
+void addToCountrySet(CountrySet *set, uint32_t country);
+bool inCountrySet(const CountrySet *set, uint32_t country);
+uint32_t countCountrySet(const CountrySet *set);
+
+// Keep the candidates whose distance from guess is within tolerance of km
+void applySolverGuess(const DistanceTable *t, CountrySet *candidates, uint32_t guess,
+                      float km);
+
+// Best next guess among countries not yet guessed
+SolverHint suggestSolverGuess(const DistanceTable *t, const CountrySet *candidates,
+                              const CountrySet *guessed);
+
+// Hint for a game in progress; pending guesses are ignored until resolved
+SolverHint getGameHint(const DistanceTable *t, const GameState *game);
+
+#endif // SOLVER_H
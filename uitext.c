@@ -0,0 +1,347 @@
+#include "uitext.h"
+#include "raylib/src/rlgl.h"
+#include "array.h"
+#include "memtrack.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SDF_SCALE 4        // Atlas pixels per default-font pixel
+#define SDF_SPREAD 4       // Distance range encoded around each edge (atlas px)
+#define SDF_ATLAS_GAP 2    // Empty pixels between glyphs in the atlas
+#define SOLID_BLOCK 8      // Size of the fully-inside block used for shapes
+#define TEXT_SPACING 1.0f  // Extra advance between glyphs, as DrawTextEx(..., 1.0f)
+#define TEXT_LINE_SPACING 2.0f
+#define TEXT_CACHE_SLOTS 256
+#define TEXT_CACHE_PROBES 8  // Slots searched per lookup before evicting
+#define TEXT_SLOT_BYTES 32   // Smallest text buffer (and quad count) a slot holds
+
+// Distance is in alpha: 0.5 on the edge, more inside. fwidth keeps the
+// antialiased band one screen pixel wide at any scale; shapes sample the
+// solid block (alpha 1) and come out unchanged.
+#ifdef PLATFORM_WEB
+static const char *sdfShaderCode =
+    "#version 100\n"
+    "#extension GL_OES_standard_derivatives : enable\n"
+    "precision mediump float;\n"
+    "varying vec2 fragTexCoord;\n"
+    "varying vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "void main() {\n"
+    "  float d = texture2D(texture0, fragTexCoord).a;\n"
+    "  float w = max(0.7*fwidth(d), 0.0001);\n"
+    "  gl_FragColor = vec4(fragColor.rgb, fragColor.a*smoothstep(0.5 - w, 0.5 + w, d))*colDiffuse;\n"
+    "}\n";
+#else
+static const char *sdfShaderCode =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "  float d = texture(texture0, fragTexCoord).a;\n"
+    "  float w = max(0.7*fwidth(d), 0.0001);\n"
+    "  finalColor = vec4(fragColor.rgb, fragColor.a*smoothstep(0.5 - w, 0.5 + w, d))*colDiffuse;\n"
+    "}\n";
+#endif
+
+// One glyph of a laid-out label, relative to the label's origin
+typedef struct {
+  Rectangle dst;
+  float u0, v0, u1, v1;
+} GlyphQuad;
+
+DEFINE_ARRAY(GlyphQuadArray, GlyphQuad, 1, MEM_TAG_RENDER)
+
+typedef struct {
+  char *text;  // NULL for an empty slot
+  size_t textCapacity;
+  float fontSize;
+  uint32_t hash;
+  unsigned int lastUsed;
+  Vector2 extent;
+  GlyphQuadArray quads;
+} TextLayout;
+
+static Font sdfFont;
+static Shader sdfShader;
+static bool loaded = false;
+static TextLayout cache[TEXT_CACHE_SLOTS];
+static unsigned int frame = 0;
+static UiTextStats stats;
+
+// Atlas generation
+
+// Signed distance image of one default-font glyph, scaled up by SDF_SCALE
+// with SDF_SPREAD of padding on every side
+static Image buildGlyphSdf(Image glyph) {
+  int w = glyph.width * SDF_SCALE + 2 * SDF_SPREAD;
+  int h = glyph.height * SDF_SCALE + 2 * SDF_SPREAD;
+  unsigned char *inside = memCalloc(MEM_TAG_RENDER, (size_t)w * h, 1);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      int gx = (x - SDF_SPREAD) / SDF_SCALE;
+      int gy = (y - SDF_SPREAD) / SDF_SCALE;
+      if (glyph.data && x >= SDF_SPREAD && y >= SDF_SPREAD && gx < glyph.width &&
+          gy < glyph.height) {
+        inside[y * w + x] = GetImageColor(glyph, gx, gy).a > 127;
+      }
+    }
+  }
+
+  // Nearest pixel of the other kind within the spread; the edge lies half a
+  // pixel short of it
+  unsigned char *sdf = RL_CALLOC((size_t)w * h, 1);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      bool in = inside[y * w + x];
+      int best = (SDF_SPREAD + 1) * (SDF_SPREAD + 1);
+      for (int dy = -SDF_SPREAD; dy <= SDF_SPREAD; dy++) {
+        int sy = y + dy;
+        if (sy < 0 || sy >= h) continue;
+        for (int dx = -SDF_SPREAD; dx <= SDF_SPREAD; dx++) {
+          int sx = x + dx;
+          if (sx < 0 || sx >= w || inside[sy * w + sx] == in) continue;
+          int d2 = dx * dx + dy * dy;
+          if (d2 < best) best = d2;
+        }
+      }
+      float d = sqrtf((float)best) - 0.5f;
+      float v = 0.5f + (in ? d : -d) / (2.0f * SDF_SPREAD);
+      sdf[y * w + x] = (unsigned char)(fminf(fmaxf(v, 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+  }
+  memFree(inside);
+
+  return (Image){sdf, w, h, 1, PIXELFORMAT_UNCOMPRESSED_GRAYSCALE};
+}
+
+bool loadUiText(void) {
+  Font base = GetFontDefault();
+  int count = base.glyphCount;
+
+  // One extra glyph: the solid block for shapes
+  GlyphInfo *glyphs = RL_CALLOC(count + 1, sizeof(GlyphInfo));
+  for (int i = 0; i < count; i++) {
+    GlyphInfo *g = &glyphs[i];
+    const Rectangle *rec = &base.recs[i];
+    g->value = base.glyphs[i].value;
+    g->offsetX = base.glyphs[i].offsetX * SDF_SCALE - SDF_SPREAD;
+    g->offsetY = base.glyphs[i].offsetY * SDF_SCALE - SDF_SPREAD;
+    int advance = base.glyphs[i].advanceX ? base.glyphs[i].advanceX : (int)rec->width;
+    g->advanceX = advance * SDF_SCALE;
+    g->image = buildGlyphSdf(base.glyphs[i].image);
+  }
+  unsigned char *solid = RL_MALLOC(SOLID_BLOCK * SOLID_BLOCK);
+  memset(solid, 255, SOLID_BLOCK * SOLID_BLOCK);
+  glyphs[count].image = (Image){solid, SOLID_BLOCK, SOLID_BLOCK, 1,
+                                PIXELFORMAT_UNCOMPRESSED_GRAYSCALE};
+
+  // Row height for packing is the tallest glyph image
+  int rowHeight = base.baseSize * SDF_SCALE + 2 * SDF_SPREAD;
+  Rectangle *recs = NULL;
+  Image atlas = GenImageFontAtlas(glyphs, &recs, count + 1, rowHeight, SDF_ATLAS_GAP, 0);
+  if (!atlas.data || !recs) {
+    UnloadFontData(glyphs, count + 1);
+    return false;
+  }
+
+  sdfFont = (Font){0};
+  sdfFont.baseSize = base.baseSize * SDF_SCALE;
+  sdfFont.glyphCount = count;
+  sdfFont.glyphPadding = 0;  // The SDF padding is part of each glyph's rectangle
+  sdfFont.texture = LoadTextureFromImage(atlas);
+  sdfFont.recs = recs;
+  sdfFont.glyphs = glyphs;
+  UnloadImage(atlas);
+  for (int i = 0; i <= count; i++) {
+    UnloadImage(glyphs[i].image);  // Only the atlas is needed from here on
+    glyphs[i].image = (Image){0};
+  }
+  SetTextureFilter(sdfFont.texture, TEXTURE_FILTER_BILINEAR);
+
+  sdfShader = LoadShaderFromMemory(NULL, sdfShaderCode);
+
+  // Shapes sample the middle of the solid block, clear of filtering at its edge
+  Rectangle block = recs[count];
+  SetShapesTexture(sdfFont.texture, (Rectangle){block.x + 2, block.y + 2,
+                                                block.width - 4, block.height - 4});
+  loaded = sdfFont.texture.id != 0 && sdfShader.id != 0;
+  printf("UI text: %d glyph SDF atlas, %dx%d\n", count, sdfFont.texture.width,
+         sdfFont.texture.height);
+  return loaded;
+}
+
+static void clearLayout(TextLayout *layout) {
+  memFree(layout->text);
+  GlyphQuadArray_free(&layout->quads);
+  memset(layout, 0, sizeof(*layout));
+}
+
+void unloadUiText(void) {
+  for (int i = 0; i < TEXT_CACHE_SLOTS; i++) {
+    if (cache[i].text) clearLayout(&cache[i]);
+  }
+  if (sdfFont.texture.id) {
+    SetShapesTexture((Texture2D){0}, (Rectangle){0});  // Back to raylib's default
+    UnloadFont(sdfFont);
+    UnloadShader(sdfShader);
+  }
+  sdfFont = (Font){0};
+  loaded = false;
+}
+
+// Frame
+
+void beginUiText(void) {
+  frame++;
+  stats.hits = 0;
+  stats.layouts = 0;
+  if (loaded) BeginShaderMode(sdfShader);
+}
+
+void endUiText(void) {
+  if (loaded) EndShaderMode();
+}
+
+// Layout cache
+
+static uint32_t hashLabel(const char *text, float fontSize) {
+  uint32_t hash = 2166136261u;  // FNV-1a
+  for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+    hash = (hash ^ *p) * 16777619u;
+  }
+  uint32_t sizeBits;
+  memcpy(&sizeBits, &fontSize, sizeof(sizeBits));
+  return (hash ^ sizeBits) * 16777619u;
+}
+
+// Same walk as DrawTextEx: advance by the glyph's advance (or width) plus
+// spacing, drop to the next line on '\n', skip drawing spaces and tabs
+static void layoutText(TextLayout *layout) {
+  float scale = layout->fontSize / sdfFont.baseSize;
+  float texW = (float)sdfFont.texture.width;
+  float texH = (float)sdfFont.texture.height;
+  float x = 0.0f, y = 0.0f, width = 0.0f;
+  int lines = 1;
+
+  // An evicted slot's quads are overwritten in place; a glyph takes at least
+  // one byte, so the text length bounds the count
+  size_t len = strlen(layout->text);
+  layout->quads.size = 0;
+  GlyphQuadArray_reserve(&layout->quads, len > TEXT_SLOT_BYTES ? (uint32_t)len : TEXT_SLOT_BYTES);
+  for (const char *p = layout->text; *p;) {
+    int size = 0;
+    int codepoint = GetCodepointNext(p, &size);
+    p += size;
+    if (codepoint == '\n') {
+      if (x > width) width = x;
+      x = 0.0f;
+      y += layout->fontSize + TEXT_LINE_SPACING;
+      lines++;
+      continue;
+    }
+
+    int index = GetGlyphIndex(sdfFont, codepoint);
+    const GlyphInfo *g = &sdfFont.glyphs[index];
+    Rectangle rec = sdfFont.recs[index];
+    if (codepoint != ' ' && codepoint != '\t') {
+      GlyphQuad q;
+      q.dst = (Rectangle){x + g->offsetX * scale, y + g->offsetY * scale,
+                          rec.width * scale, rec.height * scale};
+      q.u0 = rec.x / texW;
+      q.v0 = rec.y / texH;
+      q.u1 = (rec.x + rec.width) / texW;
+      q.v1 = (rec.y + rec.height) / texH;
+      GlyphQuadArray_push(&layout->quads, q);
+    }
+    x += g->advanceX * scale + TEXT_SPACING;
+  }
+  if (x > width) width = x;
+
+  // MeasureTextEx leaves out the spacing after the last glyph
+  layout->extent = (Vector2){width > 0.0f ? width - TEXT_SPACING : 0.0f,
+                             layout->fontSize * lines + TEXT_LINE_SPACING * (lines - 1)};
+}
+
+static const TextLayout *findLayout(const char *text, float fontSize) {
+  uint32_t hash = hashLabel(text, fontSize);
+  TextLayout *victim = NULL;
+  for (int i = 0; i < TEXT_CACHE_PROBES; i++) {
+    TextLayout *slot = &cache[(hash + i) % TEXT_CACHE_SLOTS];
+    if (slot->text && slot->hash == hash && slot->fontSize == fontSize &&
+        strcmp(slot->text, text) == 0) {
+      slot->lastUsed = frame;
+      stats.hits++;
+      return slot;
+    }
+    if (!victim || (victim->text && (!slot->text || slot->lastUsed < victim->lastUsed))) {
+      victim = slot;
+    }
+  }
+
+  // Miss: replace an empty slot or the stalest label in the probe window.
+  // The slot keeps its buffers, so a label that changes every second (the
+  // timer) is laid out again without touching the heap.
+  if (victim->text) stats.labelsCached--;
+  size_t len = strlen(text);
+  if (len + 1 > victim->textCapacity) {
+    memFree(victim->text);
+    victim->textCapacity = len + 1 > TEXT_SLOT_BYTES ? len + 1 : TEXT_SLOT_BYTES;
+    victim->text = memAlloc(MEM_TAG_RENDER, victim->textCapacity);
+  }
+  memcpy(victim->text, text, len + 1);
+  victim->fontSize = fontSize;
+  victim->hash = hash;
+  victim->lastUsed = frame;
+  layoutText(victim);
+  stats.layouts++;
+  stats.labelsCached++;
+  return victim;
+}
+
+// Drawing
+
+void drawUiText(const char *text, Vector2 position, float fontSize, Color color) {
+  if (!loaded) {
+    DrawTextEx(GetFontDefault(), text, position, fontSize, TEXT_SPACING, color);
+    return;
+  }
+  const TextLayout *layout = findLayout(text, fontSize);
+  const GlyphQuad *q = GlyphQuadArray_data(&layout->quads);
+  uint32_t count = layout->quads.size;
+  if (count == 0) return;
+
+  rlCheckRenderBatchLimit(4 * (int)count);
+  rlSetTexture(sdfFont.texture.id);
+  rlBegin(RL_QUADS);
+  rlColor4ub(color.r, color.g, color.b, color.a);
+  rlNormal3f(0.0f, 0.0f, 1.0f);
+  for (uint32_t i = 0; i < count; i++, q++) {
+    float x0 = position.x + q->dst.x;
+    float y0 = position.y + q->dst.y;
+    float x1 = x0 + q->dst.width;
+    float y1 = y0 + q->dst.height;
+    rlTexCoord2f(q->u0, q->v0); rlVertex2f(x0, y0);
+    rlTexCoord2f(q->u0, q->v1); rlVertex2f(x0, y1);
+    rlTexCoord2f(q->u1, q->v1); rlVertex2f(x1, y1);
+    rlTexCoord2f(q->u1, q->v0); rlVertex2f(x1, y0);
+  }
+  rlEnd();
+  rlSetTexture(0);
+}
+
+Vector2 measureUiText(const char *text, float fontSize) {
+  if (!loaded) {
+    return MeasureTextEx(GetFontDefault(), text, fontSize, TEXT_SPACING);
+  }
+  return findLayout(text, fontSize)->extent;
+}
+
+UiTextStats getUiTextStats(void) {
+  return stats;
+}
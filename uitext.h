@@ -0,0 +1,35 @@
+#ifndef UITEXT_H
+#define UITEXT_H
+
+#include "raylib/src/raylib.h"
+#include <stdbool.h>
+
+// Screen text drawn from a signed-distance-field font atlas with one shader,
+// so labels stay crisp from 18 to 48 px. Each (string, size) pair is laid
+// out once into glyph quads and kept in a small cache; drawing a cached
+// label is a single run of quads. The atlas also carries a solid block that
+// 2D shapes use as their texture, so UI rectangles and text share one
+// texture and one shader and batch together.
+
+typedef struct {
+  int labelsCached;  // Layouts currently held
+  int hits;          // Labels drawn from the cache this frame
+  int layouts;       // Labels laid out this frame
+} UiTextStats;
+
+// Build the atlas and shader; call after InitWindow. No TTF ships with the
+// game, so the atlas is generated from raylib's default font glyphs.
+bool loadUiText(void);
+void unloadUiText(void);
+
+// Bracket all 2D UI drawing for the frame (after EndMode3D)
+void beginUiText(void);
+void endUiText(void);
+
+// Same metrics as DrawTextEx/MeasureTextEx with spacing 1
+void drawUiText(const char *text, Vector2 position, float fontSize, Color color);
+Vector2 measureUiText(const char *text, float fontSize);
+
+UiTextStats getUiTextStats(void);
+
+#endif // UITEXT_H
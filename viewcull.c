@@ -0,0 +1,71 @@
+#include "viewcull.h"
+#include "geomath.h"
+#include "raylib/src/raymath.h"
+#include <math.h>
+
+static Vector4 normalizePlane(float a, float b, float c, float d) {
+  float len = sqrtf(a * a + b * b + c * c);
+  return (Vector4){a / len, b / len, c / len, d / len};
+}
+
+static float clampUnit(float v) {
+  if (v > 1.0f) return 1.0f;
+  if (v < -1.0f) return -1.0f;
+  return v;
+}
+
+void setupViewCull(ViewCull *view, Camera3D camera, Matrix transform,
+                   float globeRadius) {
+  view->transform = transform;
+  view->globeRadius = globeRadius;
+  view->cameraLocal = Vector3Transform(camera.position, MatrixInvert(transform));
+  view->cameraDist = Vector3Length(view->cameraLocal);
+  view->cameraDir = Vector3Scale(view->cameraLocal, 1.0f / view->cameraDist);
+  view->horizonAngle = acosf(clampUnit(globeRadius / view->cameraDist));
+
+  float aspect = (float)GetScreenWidth() / (float)GetScreenHeight();
+  Matrix proj = MatrixPerspective(camera.fovy * DEG2RAD, aspect, 0.01, 1000.0);
+  Matrix viewMat = MatrixLookAt(camera.position, camera.target, camera.up);
+  Matrix m = MatrixMultiply(viewMat, proj);  // Applies view then projection
+
+  // Rows of the clip matrix (Gribb/Hartmann plane extraction)
+  float r0[4] = {m.m0, m.m4, m.m8, m.m12};
+  float r1[4] = {m.m1, m.m5, m.m9, m.m13};
+  float r2[4] = {m.m2, m.m6, m.m10, m.m14};
+  float r3[4] = {m.m3, m.m7, m.m11, m.m15};
+
+  view->planes[0] = normalizePlane(r3[0] + r0[0], r3[1] + r0[1], r3[2] + r0[2], r3[3] + r0[3]);
+  view->planes[1] = normalizePlane(r3[0] - r0[0], r3[1] - r0[1], r3[2] - r0[2], r3[3] - r0[3]);
+  view->planes[2] = normalizePlane(r3[0] + r1[0], r3[1] + r1[1], r3[2] + r1[2], r3[3] + r1[3]);
+  view->planes[3] = normalizePlane(r3[0] - r1[0], r3[1] - r1[1], r3[2] - r1[2], r3[3] - r1[3]);
+  view->planes[4] = normalizePlane(r3[0] + r2[0], r3[1] + r2[1], r3[2] + r2[2], r3[3] + r2[3]);
+  view->planes[5] = normalizePlane(r3[0] - r2[0], r3[1] - r2[1], r3[2] - r2[2], r3[3] - r2[3]);
+}
+
+bool isCapCulled(const ViewCull *view, Vector3 centerDir, float angularRadius,
+                 float radius) {
+  // Horizon: points raised above the surface stay visible a little past the
+  // globe's own horizon
+  float visibleAngle = view->horizonAngle;
+  if (radius > view->globeRadius) {
+    visibleAngle += fastAcos(view->globeRadius / radius);
+  }
+  // Per-ring pruning, so the fast tier is plenty (caps carry a 1e-4 margin)
+  float angle = fastAcos(Vector3DotProduct(centerDir, view->cameraDir));
+  if (angle > visibleAngle + angularRadius) {
+    return true;
+  }
+
+  // Frustum: bounding sphere around the cap (chord to its rim)
+  Vector3 centerWorld = Vector3Transform(Vector3Scale(centerDir, radius),
+                                         view->transform);
+  float boundRadius = 2.0f * radius * sinf(fminf(angularRadius, PI) * 0.5f);
+  for (int i = 0; i < 6; i++) {
+    Vector4 p = view->planes[i];
+    float d = p.x * centerWorld.x + p.y * centerWorld.y + p.z * centerWorld.z + p.w;
+    if (d < -boundRadius) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,31 @@
+#ifndef VIEWCULL_H
+#define VIEWCULL_H
+
+#include "raylib/src/raylib.h"
+#include <stdbool.h>
+
+// Per-frame visibility data for things lying on (or just above) the globe.
+// Spherical caps are described in the globe's model space by a unit center
+// direction and an angular radius, and tested against the horizon seen from
+// the camera and against the view frustum.
+typedef struct {
+  Matrix transform;      // Globe model transform
+  Vector3 cameraLocal;   // Camera position in globe model space
+  Vector3 cameraDir;     // Unit direction from the globe center to the camera
+  float cameraDist;
+  float globeRadius;
+  float horizonAngle;    // Angular radius of the globe area facing the camera
+  Vector4 planes[6];     // World-space frustum planes (inside: dot >= 0)
+} ViewCull;
+
+// Build the view data for this frame (aspect ratio comes from the screen size)
+void setupViewCull(ViewCull *view, Camera3D camera, Matrix transform,
+                   float globeRadius);
+
+// True if a cap at the given radius is entirely hidden behind the globe or
+// outside the frustum. radius may exceed globeRadius for geometry drawn
+// slightly above the surface.
+bool isCapCulled(const ViewCull *view, Vector3 centerDir, float angularRadius,
+                 float radius);
+
+#endif // VIEWCULL_H